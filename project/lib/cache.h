@@ -21,6 +21,12 @@
 #include <stdlib.h>
 #include <math.h>
 #include "memory_generic.h"
+#include "victim.h"
+#include "mshr.h"
+#include "writebuf.h"
+#include "timing.h"
+#include "misstrace.h"
+#include "fullassoc.h"
 
 /** @defgroup Function utilities
   * @{
@@ -32,6 +38,8 @@
 #define FALSE   -1
 
 #define BIT(X)  (1 << X)
+#define IS_POWER_OF_2(X)    ((X) > 0 && ((X) & ((X) - 1)) == 0)
+#define LOG2(X)             __builtin_ctz(X)    //X a power of 2
 /**
   * @}
   */
@@ -45,12 +53,32 @@
 /* Cache line */
 /**
   * @brief    Contain tag array(LRU, D, V, tag), and data array
+  *           sectors_valid, sectors_dirty: one bit per sector of a
+  *           sectored cache (cache_set_sectors()), in the padding of the
+  *           line. V and D stay set while any sector is valid, dirty.
   */
 typedef struct line_struct {
-    uint16_t tag_array;
+    uint32_t tag_array;
+    uint8_t flags;
+    uint8_t sectors_valid;
+    uint8_t sectors_dirty;
     uint8_t* data; 
 }line_t;
 
+/* Line flags */
+/**
+  * @brief    Extra state of a line, kept outside of the tag array.
+  *           LINE_PREFETCHED: line was filled by the prefetcher and
+  *                            has not been used by a demand access yet.
+  *           LINE_WRITTEN   : first write already went through to L2
+  *                            (WRITE_ONCE policy).
+  *           LINE_SHARED    : other cores may hold the line (MESI S state),
+  *                            a write must invalidate them first.
+  */
+#define LINE_PREFETCHED     BIT(0)
+#define LINE_WRITTEN        BIT(1)
+#define LINE_SHARED         BIT(2)
+
 /* Cache set */
 /**
   * @brief    Contain array of cache lines.
@@ -59,6 +87,43 @@ typedef struct set_struct {
     line_t* lines;
 }set_t;
 
+/* Write policy */
+/**
+  * @brief    WRITE_BACK   : Write hit only sets the D bit.
+  *           WRITE_THROUGH: Every write is also sent to L2, lines stay clean.
+  *           WRITE_ONCE   : First write to a line is write-through, next
+  *                          writes are write-back.
+  */
+typedef enum write_policy_enum {
+    WRITE_BACK=0,
+    WRITE_THROUGH,
+    WRITE_ONCE
+}write_policy_t;
+
+/* Storage allocator */
+/**
+  * @brief    CACHE_ALLOC_MALLOC : one malloc per set and per line (default).
+  *           CACHE_ALLOC_HUGE   : one arena for all sets, lines and data,
+  *                                on 2 MB pages. Only asked to create_cache(),
+  *                                cache->alloc tells what was obtained:
+  *           CACHE_ALLOC_HUGETLB: reserved huge pages (hugetlbfs).
+  *           CACHE_ALLOC_THP    : transparent huge pages, madvise(MADV_HUGEPAGE).
+  *           Without both, the cache falls back to CACHE_ALLOC_MALLOC.
+  */
+typedef enum cache_alloc_enum {
+    CACHE_ALLOC_MALLOC=0,
+    CACHE_ALLOC_HUGE,
+    CACHE_ALLOC_HUGETLB,
+    CACHE_ALLOC_THP
+}cache_alloc_t;
+
+#define CACHE_HUGE_PAGE_SIZE    (2 * 1024 * 1024)
+#define CACHE_MAX_SECTORS       8       //bits of line_t.sectors_valid
+#define CACHE_USAGE_PARTS       64      //bits of a line usage bitmap
+#define CACHE_USAGE_BINS        (CACHE_USAGE_PARTS + 1) //lines by parts used, 0..64
+
+struct directory_struct;
+
 /* Cache */
 /**
   * @brief    Contain array of sets, and others infomation 
@@ -74,11 +139,40 @@ typedef struct cache_struct {
 
     uint16_t D_BIT;
     uint16_t V_BIT;
-    uint16_t LRU_line_mask;
+    uint32_t LRU_line_mask;
+    uint32_t tag_line_mask; //tag bits of tag_array
     uint32_t tag_mask;
     uint32_t set_mask;
     uint32_t bytes_mask;
     set_t* sets;
+
+    write_policy_t write_policy;
+    int write_allocate;
+
+    fa_table_t* fa;     //way of each tag and LRU order of a cache of 1 set, else NULL
+    victim_t* victim;   //optional, NULL if disabled
+    mshr_t* mshr;       //optional, NULL if disabled
+    write_buffer_t* wbuf; //optional, NULL if disabled
+    misstrace_t* misstrace; //L1->L2 transactions output, NULL if disabled
+    int misstrace_read; //command of a line read in the miss trace
+    timing_t* timing;   //optional, NULL if disabled
+    uint32_t latency;   //cycles of the last read/write request
+
+    struct directory_struct* directory; //shared L2 directory, NULL if single core
+    int core;           //owner core in the directory
+
+    cache_alloc_t alloc; //storage of the sets, see cache_alloc_t
+    void* arena;        //huge page storage, NULL for CACHE_ALLOC_MALLOC
+    size_t arena_size;
+
+    int sector_bits;    //bytes of a sector = BIT(sector_bits), the line if not sectored
+    int sectors_num;    //sectors of a line, 1 if not sectored
+    uint64_t l2_read_bytes;  //bytes read from L2, since create_cache()
+    uint64_t l2_write_bytes; //bytes written to L2 (write back, write-through)
+
+    uint64_t* usage;    //parts of each line used since its fill, NULL if disabled
+    int usage_shift;    //bytes of a part = BIT(usage_shift)
+    uint64_t* usage_hist; //lines left the cache, by parts used, CACHE_USAGE_BINS
 }cache_t;
 
 /**
@@ -113,6 +207,16 @@ typedef enum command_enum {
 /* Return of cache_request(); */
 /**
   * @brief    Indicate the result of the request.
+  *           PREFETCH_L2    : A prefetch fill read a line from L2.
+  *           PREFETCH_HIT   : Demand access hit a line filled by prefetch.
+  *           PREFETCH_UNUSED: A prefetched line left the cache unused.
+  *           VICTIM_HIT     : Miss served by the victim buffer, no L2 read.
+  *           MSHR_MERGE     : Miss merged into an outstanding miss, no L2 read.
+  *           WRITE_L2_THROUGH: The written byte is sent through to L2.
+  *           UPGRADE_L2     : Write to a shared line, copies of other cores
+  *                            are invalidated through the directory.
+  *           SECTOR_MISS    : The line is present but not the sector of the
+  *                            miss, only the sector is read.
   */
 typedef enum return_enum {
     READ_HIT=0,
@@ -123,9 +227,30 @@ typedef enum return_enum {
     READ_L2,
     READ_L2_OWN,
     EVICT_L2_OK,
-    EVICT_L2_ERROR
+    EVICT_L2_ERROR,
+    PREFETCH_L2,
+    PREFETCH_HIT,
+    PREFETCH_UNUSED,
+    VICTIM_HIT,
+    MSHR_MERGE,
+    WRITE_L2_THROUGH,
+    UPGRADE_L2,
+    SECTOR_MISS
 }return_t;
 
+/* Stage of cache_L1_host_prefetch(); */
+/**
+  * @brief    Host memory a request will touch, in the order it needs it.
+  *           HOST_PREFETCH_SET  : the set entry holding the lines pointer.
+  *           HOST_PREFETCH_LINES: the lines of the set (tags, LRU, flags).
+  *           HOST_PREFETCH_DATA : the byte of the line hit, if any.
+  */
+typedef enum host_prefetch_enum {
+    HOST_PREFETCH_SET=0,
+    HOST_PREFETCH_LINES,
+    HOST_PREFETCH_DATA
+}host_prefetch_t;
+
 /**
   * @}
   */
@@ -149,7 +274,18 @@ typedef struct cache_stat_struct {
     int read_misses;
     int write_hits;
     int write_misses;
+    int l2_writebacks;
+    int l2_write_throughs;
+    int sector_misses;
     double hit_rate;
+
+    cache_t* cache;     //bound by cache_stat_bind() for timing, or NULL
+    uint64_t cycles;
+    uint64_t stall_cycles;
+    uint32_t latency_hist[TIMING_HIST_BINS];
+    uint64_t l2_read_bytes_base;  //bytes of the cache at the last clear_stat()
+    uint64_t l2_write_bytes_base;
+    uint64_t usage_hist_base[CACHE_USAGE_BINS]; //cache->usage_hist at the last clear_stat()
 }cache_stat_t;
 /**
   * @}
@@ -195,7 +331,14 @@ typedef struct query_struct {
   */
 
 /* Cache Initialize functions ************************************************/
-cache_t* create_cache(int sets_num, int ways_assoc, int line_size);
+int cache_check_geometry(int sets_num, int ways_assoc, int line_size);
+cache_t* create_cache(int sets_num, int ways_assoc, int line_size, cache_alloc_t alloc);
+void destroy_cache(cache_t* cache);
+int cache_first_touch(cache_t* cache);
+int cache_set_write_policy(cache_t* cache, write_policy_t policy, int write_allocate);
+int cache_set_misstrace(cache_t* cache, misstrace_t* mt, int read_command);
+int cache_set_sectors(cache_t* cache, int sector_size);
+int cache_set_usage(cache_t* cache, int enable);
 line_t* create_set(int ways_assoc);
 uint8_t* create_line(int line_size);
 
@@ -203,17 +346,28 @@ uint8_t* create_line(int line_size);
 uint32_t get_tag(cache_t cache, uint32_t address);
 uint32_t get_set(cache_t cache, uint32_t address);
 uint32_t get_bytes_offset(cache_t cache, uint32_t address);
-uint16_t get_line_LRU(cache_t cache, uint16_t tag_arr);
+uint16_t get_line_LRU(cache_t cache, uint32_t tag_arr);
+uint32_t get_line_address(cache_t cache, uint32_t tag_arr, uint32_t set);
 
 /* Cache request subfunctions ************************************************/
 int cache_L1_read(cache_t* cache, uint32_t address, uint8_t*data);
 int cache_L1_write(cache_t* cache, uint32_t address, uint8_t data);
 int cache_L2_evict(cache_t* cache, uint32_t address);
 int cache_L1_clear(cache_t* cache);
+int cache_L1_probe(cache_t* cache, uint32_t address);
+int cache_L1_prefetch(cache_t* cache, uint32_t address);
+int cache_L1_snoop(cache_t* cache, uint32_t address, int invalidate);
+int cache_L1_warm_read(cache_t* cache, uint32_t address);
+int cache_L1_warm_write(cache_t* cache, uint32_t address);
+int cache_L1_repeatable(cache_t* cache, uint32_t address, int write);
+uint64_t cache_L1_usage_bit(cache_t* cache, uint32_t address);
+int cache_L1_repeat(cache_t* cache, uint32_t address, int write, uint32_t count, uint64_t used);
+void cache_L1_host_prefetch(cache_t* cache, uint32_t address, int write, host_prefetch_t stage);
 
 /* Cache L2 request functions ************************************************/
 int cache_L2_read(cache_t* cache, uint32_t address, uint8_t* data);
 int cache_L2_write(cache_t* cache, uint32_t address, uint8_t* data);
+int cache_L2_write_through(cache_t* cache, uint32_t address, uint8_t data);
 
 /**
   * @}
@@ -227,9 +381,11 @@ int cache_L2_write(cache_t* cache, uint32_t address, uint8_t* data);
 /* Statistic initialize functions ******************************************************/
 cache_stat_t* cache_stat_create(char* cache_name, FILE* log_fp, int mode);
 int cache_stat_init(cache_stat_t* stat,char* cache_name, FILE* log_fp, int mode);
+int cache_stat_bind(cache_stat_t* stat, cache_t* cache);
 
 /* Statistic activities functions ******************************************************/
 int cache_stat_update(cache_stat_t*stat, return_t update, uint32_t address);
+int cache_stat_repeat(cache_stat_t*stat, return_t update, uint32_t count);
 int cache_log(cache_stat_t *stat);
 int clear_stat(cache_stat_t *stat);
 
@@ -0,0 +1,151 @@
+/**
+  ***********************************************************************
+  * @file       cachesim.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Public API of libcachesim.a / libcachesim.so.
+  *             This header does not depend on the internal headers of
+  *             the simulator, only what is declared here is exported.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef CACHESIM_H
+#define CACHESIM_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup Cachesim_configuration
+  * @brief    CACHESIM_API_VERSION changes when a declaration of this
+  *           file changes, compare it with cachesim_api_version().
+  * @{
+  */
+#define CACHESIM_API_VERSION    3
+
+#if defined(__GNUC__)
+#define CACHESIM_API    __attribute__((visibility("default")))
+#else
+#define CACHESIM_API
+#endif
+
+/* Commands, same values as the trace file */
+#define CACHESIM_READ           0
+#define CACHESIM_WRITE          1
+#define CACHESIM_FETCH          2
+#define CACHESIM_EVICT          3
+#define CACHESIM_CLEAR          8
+#define CACHESIM_PRINT          9
+
+/* Caches of a core */
+#define CACHESIM_INSTRUCTION    0
+#define CACHESIM_DATA           1
+
+/* Prefetchers, can be combined */
+#define CACHESIM_PF_NONE        0
+#define CACHESIM_PF_NEXT_LINE   1
+#define CACHESIM_PF_STRIDE      2
+#define CACHESIM_PF_STREAM      4
+
+/* Data cache write policy */
+#define CACHESIM_WRITE_BACK     0
+#define CACHESIM_WRITE_THROUGH  1
+#define CACHESIM_WRITE_ONCE     2
+/**
+  * @}
+  */
+
+/* Cachesim data structures ----------------------------------------------*/
+/** @defgroup Cachesim_data_structures
+  * @{
+  */
+
+/* Simulator handle */
+typedef struct sim_context_struct cachesim_t;
+
+/* Configuration */
+/**
+  * @brief    Options of a simulator, fill it by cachesim_config_init() first.
+  *           cores: 0 for one core without coherence,
+  *                  1..64 for cores sharing a coherent L2 (MESI).
+  *           latencies: L1 hit, L2 hit, memory, write to L2 (cycles),
+  *                      used when timing is 1.
+  *           huge_pages: 1 to keep the L1 caches on 2 MB pages.
+  *           l1_sets, l1_ways: L1 geometry by CACHESIM_INSTRUCTION/DATA,
+  *                      line_size: line of every level, 0 for the default.
+  */
+typedef struct cachesim_config_struct {
+    int cores;
+    int l2_sets;
+    int l2_ways;
+    int prefetch;
+    int prefetch_degree;
+    int victim_entries;
+    int mshr_entries;
+    int mshr_window;
+    int write_policy;
+    int write_allocate;
+    int write_buffer_entries;
+    int timing;
+    uint32_t latencies[4];
+    int log_mode;
+    int huge_pages;
+    int l1_sets[2];
+    int l1_ways[2];
+    int line_size;
+    int reserved[2];
+}cachesim_config_t;
+
+/* One access */
+/**
+  * @brief    command: CACHESIM_READ/WRITE/FETCH/EVICT/CLEAR/PRINT.
+  *           core   : core issuing the access, 0 for one core.
+  */
+typedef struct cachesim_access_struct {
+    uint32_t address;
+    uint16_t command;
+    uint16_t core;
+}cachesim_access_t;
+
+/* Statistic of one cache */
+typedef struct cachesim_stats_struct {
+    uint64_t read_hits;
+    uint64_t read_misses;
+    uint64_t write_hits;
+    uint64_t write_misses;
+    uint64_t l2_writebacks;
+    uint64_t l2_write_throughs;
+    uint64_t cycles;
+    uint64_t stall_cycles;
+}cachesim_stats_t;
+
+/**
+  * @}
+  */
+
+/* Cachesim function prototypes -------------------------------------------------*/
+/** @addtogroup Cachesim_data_structures
+  * @{
+  */
+CACHESIM_API int cachesim_api_version(void);
+CACHESIM_API int cachesim_config_init(cachesim_config_t* config);
+CACHESIM_API cachesim_t* cachesim_create(const cachesim_config_t* config, const char* log_path);
+CACHESIM_API int cachesim_access_batch(cachesim_t* sim, const cachesim_access_t* accesses, int accesses_num);
+CACHESIM_API int cachesim_get_stats(cachesim_t* sim, int core, int cache, cachesim_stats_t* stats);
+CACHESIM_API void cachesim_destroy(cachesim_t* sim);
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+/**
+  ***********************************************************************
+  * @file       coherence.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the shared L2 directory keeping the private L1 caches
+  *             of several cores coherent (MESI).
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef COHERENCE_H
+#define COHERENCE_H
+/* Includes ------------------------------------------------------------*/
+#include "cache.h"
+
+/** @defgroup Directory_configuration
+  * @{
+  */
+#define DIR_MAX_CORES           64
+#define DIR_DEFAULT_L2_SETS     (64 * 1024)
+#define DIR_DEFAULT_L2_WAYS     16
+#define DIR_INVALID_LINE        0x1
+
+/* Result bits of directory_read() */
+#define DIR_L2_HIT              BIT(0)
+#define DIR_SHARED              BIT(1)
+#define DIR_FLUSH               BIT(2)
+/**
+  * @}
+  */
+
+/* Directory data structures ----------------------------------------------*/
+/** @defgroup Directory_data_structures
+  * @{
+  */
+
+/* Shared L2 with directory */
+/**
+  * @brief    Inclusive L2 shared by all cores. Entry i (set * ways + way)
+  *           holds a line address (DIR_INVALID_LINE if empty), the mask of
+  *           cores having the line in an L1 cache, and whether the only
+  *           sharer may hold it in E or M state.
+  *           All arrays are allocated once by directory_create().
+  *           L1 line states (MESI): M = D bit set, E = valid and clean,
+  *           S = valid with LINE_SHARED, I = not valid.
+  */
+typedef struct directory_struct {
+    int cores_num;
+    int sets_num;
+    int ways;
+    int line_bits;
+    uint32_t clock;
+    uint32_t* tags;
+    uint64_t* sharers;
+    uint8_t* exclusive;
+    uint32_t* stamp;
+
+    cache_t* icaches[DIR_MAX_CORES];
+    cache_t* dcaches[DIR_MAX_CORES];
+
+    int l2_hits;
+    int l2_misses;
+    int l2_evictions;
+    int snoops;
+    int invalidations;
+    int back_invalidations;
+    int downgrades;
+    int flushes;
+    int upgrades;
+}directory_t;
+
+/**
+  * @}
+  */
+
+/* Directory function prototypes -------------------------------------------------*/
+/** @addtogroup Directory_data_structures
+  * @{
+  */
+directory_t* directory_create(int cores_num, int sets_num, int ways, int line_size);
+int directory_attach(directory_t* dir, int core, cache_t* icache, cache_t* dcache);
+int directory_read(directory_t* dir, cache_t* cache, uint32_t address, int exclusive);
+int directory_upgrade(directory_t* dir, cache_t* cache, uint32_t address);
+int directory_evict(directory_t* dir, cache_t* cache, uint32_t address);
+int directory_l2_evict(directory_t* dir, uint32_t address);
+int directory_clear(directory_t* dir);
+void directory_destroy(directory_t* dir);
+int directory_log(directory_t* dir, FILE* fp);
+/**
+  * @}
+  */
+
+#endif
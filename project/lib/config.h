@@ -0,0 +1,44 @@
+/**
+  ***********************************************************************
+  * @file       config.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the configuration file of the simulator.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef CONFIG_H
+#define CONFIG_H
+/* Includes ------------------------------------------------------------*/
+#include "sim.h"
+
+/** @defgroup Config_configuration
+  * @brief    CONFIG_LINE_SIZE: longest line of a configuration file.
+  *           CONFIG_KEY_SIZE : longest key.
+  * @{
+  */
+#define CONFIG_LINE_SIZE    640
+#define CONFIG_KEY_SIZE     32
+/**
+  * @}
+  */
+
+/* Config function prototypes -------------------------------------------------*/
+/** @addtogroup Config_data_structures
+  * @{
+  */
+int config_set(sim_config_t* config, const char* key, const char* value);
+int config_set_option(sim_config_t* config, const char* option);
+int config_load(sim_config_t* config, const char* path);
+int config_print(const sim_config_t* config, FILE* fp);
+/**
+  * @}
+  */
+
+#endif
@@ -0,0 +1,96 @@
+/**
+  ***********************************************************************
+  * @file       fullassoc.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the fully-associative table: line tag to way in O(1), and
+  *             the LRU order of the ways.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef FULLASSOC_H
+#define FULLASSOC_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Fully_associative_configuration
+  * @brief    FA_MAX_ENTRIES: ways of a fully-associative cache.
+  *           FA_NONE       : no entry (end of the LRU list, empty bucket).
+  *           FA_FREE       : prev of an entry holding no line.
+  * @{
+  */
+#define FA_MAX_ENTRIES          (1 << 20)
+#define FA_NONE                 -1
+#define FA_FREE                 -2
+/**
+  * @}
+  */
+
+/* Fully-associative table data structures ----------------------------------------------*/
+/** @defgroup Fully_associative_data_structures
+  * @{
+  */
+
+/* Entry */
+/**
+  * @brief    Entry i is way i of the cache.
+  *           key: tag of the line held.
+  *           prev, next: neighbours in the LRU list, FA_NONE at its ends.
+  *           An entry holding no line has prev FA_FREE, and next is the
+  *           next free entry.
+  */
+typedef struct fa_entry_struct {
+    uint32_t key;
+    int32_t prev;
+    int32_t next;
+}fa_entry_t;
+
+/* Fully-associative table */
+/**
+  * @brief    buckets: open addressing table (linear probing) of
+  *           buckets_mask + 1 >= 2 * entries_num entry indexes, FA_NONE if
+  *           empty. A removed key shifts back the keys after it, so there
+  *           is no tombstone and a lookup stops at the first empty bucket.
+  *           head: MRU entry, tail: LRU entry, free: first free entry.
+  */
+typedef struct fa_table_struct {
+    int entries_num;
+    int used;
+    int32_t head;
+    int32_t tail;
+    int32_t free;
+    int buckets_bits;
+    uint32_t buckets_mask;
+    int32_t* buckets;
+    fa_entry_t* entries;
+}fa_table_t;
+
+/**
+  * @}
+  */
+
+/* Fully-associative table function prototypes -------------------------------------------------*/
+/** @addtogroup Fully_associative_data_structures
+  * @{
+  */
+fa_table_t* fa_create(int entries_num);
+int fa_lookup(fa_table_t* fa, uint32_t key);
+void fa_touch(fa_table_t* fa, int index);
+int fa_select(fa_table_t* fa);
+int fa_insert(fa_table_t* fa, int index, uint32_t key);
+void fa_remove(fa_table_t* fa, int index);
+void fa_host_prefetch(fa_table_t* fa, uint32_t key);
+int fa_clear(fa_table_t* fa);
+void fa_destroy(fa_table_t* fa);
+/**
+  * @}
+  */
+
+#endif
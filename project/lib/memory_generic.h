@@ -2,9 +2,10 @@
 #define MEMORY_GENERIC_H
 #include <math.h>
 
-#define K       pow(2, 10)
-#define M       pow(2, 20)
-#define G       pow(2, 30)
+//integer sizes, usable in constant expressions:
+#define K       (1 << 10)
+#define M       (1 << 20)
+#define G       (1 << 30)
 
 #define Byte    8
 #define bit     1   
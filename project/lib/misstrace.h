@@ -0,0 +1,88 @@
+/**
+  ***********************************************************************
+  * @file       misstrace.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the L1 to L2 transaction trace (miss stream).
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef MISSTRACE_H
+#define MISSTRACE_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Miss_trace_configuration
+  * @brief    MISSTRACE_BUFFER_SIZE: bytes gathered before one write to the
+  *           file. MISSTRACE_RECORD_SIZE: longest record,
+  *           "c ffffffff 63 1 t\n".
+  * @{
+  */
+#define MISSTRACE_BUFFER_SIZE   (1024 * 1024)
+#define MISSTRACE_RECORD_SIZE   18
+/**
+  * @}
+  */
+
+/* Transaction type */
+/**
+  * @brief    The command of a record stays READ_DATA, WRITE_DATA or
+  *           INSTRUCTION_FETCH so the miss trace replays as a native
+  *           trace, where a read for ownership, a writeback and a
+  *           write-through are all writes. The type tells them apart in
+  *           a fifth field, after the core and the count, which the
+  *           native trace reader ignores:
+  *           MISSTRACE_READ     : "r", line read (READ_L2, PREFETCH_L2).
+  *           MISSTRACE_OWN      : "o", read for ownership (READ_L2_OWN).
+  *           MISSTRACE_WRITEBACK: "w", writeback of a dirty line (WRITE_L2).
+  *           MISSTRACE_THROUGH  : "t", write-through of a byte
+  *                                (WRITE_L2_THROUGH).
+  */
+typedef enum misstrace_type_enum {
+    MISSTRACE_READ=0,
+    MISSTRACE_OWN,
+    MISSTRACE_WRITEBACK,
+    MISSTRACE_THROUGH
+}misstrace_type_t;
+
+/* Miss trace data structures ----------------------------------------------*/
+/** @defgroup Miss_trace_data_structures
+  * @{
+  */
+
+/* Miss trace writer */
+/**
+  * @brief    One buffered writer shared by all the L1 caches of a
+  *           simulation, records: transactions written.
+  */
+typedef struct misstrace_struct {
+    FILE* fp;
+    uint64_t records;
+    size_t used;
+    char buffer[MISSTRACE_BUFFER_SIZE];
+}misstrace_t;
+
+/**
+  * @}
+  */
+
+/* Miss trace function prototypes -------------------------------------------------*/
+/** @addtogroup Miss_trace_data_structures
+  * @{
+  */
+misstrace_t* misstrace_create(const char* path);
+int misstrace_write(misstrace_t* mt, int command, misstrace_type_t type, uint32_t address, int core);
+int misstrace_flush(misstrace_t* mt);
+void misstrace_destroy(misstrace_t* mt);
+/**
+  * @}
+  */
+
+#endif
@@ -0,0 +1,79 @@
+/**
+  ***********************************************************************
+  * @file       mshr.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the miss-status holding registers (MSHR) of an L1 cache.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef MSHR_H
+#define MSHR_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup MSHR_configuration
+  * @brief    MSHR_MAX_ENTRIES must be a multiple of SIMD_LANES_U32.
+  * @{
+  */
+#define MSHR_MAX_ENTRIES        32
+#define MSHR_DEFAULT_WINDOW     16
+#define MSHR_INVALID_LINE       0x1
+/**
+  * @}
+  */
+
+/* MSHR data structures ----------------------------------------------*/
+/** @defgroup MSHR_data_structures
+  * @{
+  */
+
+/* MSHR table */
+/**
+  * @brief    Outstanding L2 reads of one cache.
+  *           A miss is outstanding for `window` cache accesses after it
+  *           is issued, another miss to the same line in that window is
+  *           merged into it instead of reading L2 again. The entry is
+  *           dropped when the line leaves the cache, a later miss to it
+  *           reads L2.
+  */
+typedef struct mshr_struct {
+    int entries_num;
+    uint32_t window;
+    uint32_t now;
+    uint32_t lines[MSHR_MAX_ENTRIES];
+    uint32_t issue[MSHR_MAX_ENTRIES];
+
+    int allocations;
+    int merges;
+    int full;
+}mshr_t;
+
+/**
+  * @}
+  */
+
+/* MSHR function prototypes -------------------------------------------------*/
+/** @addtogroup MSHR_data_structures
+  * @{
+  */
+mshr_t* mshr_create(int entries_num, uint32_t window);
+void mshr_tick(mshr_t* mshr);
+int mshr_lookup(mshr_t* mshr, uint32_t line);
+int mshr_allocate(mshr_t* mshr, uint32_t line);
+void mshr_release(mshr_t* mshr, uint32_t line, uint32_t mask);
+int mshr_clear(mshr_t* mshr);
+void mshr_destroy(mshr_t* mshr);
+int mshr_log(mshr_t* mshr, FILE* fp);
+/**
+  * @}
+  */
+
+#endif
@@ -0,0 +1,176 @@
+/**
+  ***********************************************************************
+  * @file       pipeline.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the simulation pipeline: a decoder thread, the simulation
+  *             thread and a logger thread connected by lock-free
+  *             single-producer/single-consumer rings.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef PIPELINE_H
+#define PIPELINE_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "trace.h"
+
+/** @defgroup Pipeline_configuration
+  * @brief    PIPELINE_ALIGN     : host cache line, the indexes of a ring
+  *                                written by different threads never
+  *                                share one.
+  *           PIPELINE_SLOTS     : slots of each ring, a power of 2. A full
+  *                                ring blocks its producer (backpressure).
+  *           PIPELINE_BATCH     : trace records of one decoded batch.
+  *           PIPELINE_CHUNK_SIZE: bytes of one output chunk to the logger.
+  *           PIPELINE_SPIN      : polls of a waiting thread before it
+  *                                yields its core.
+  *           PIPELINE_MAX_DECODERS: parser threads of a native trace.
+  *           PIPELINE_TEXT_CHUNK: bytes of native trace text parsed by one
+  *                                thread at a time, cut after a new line.
+  * @{
+  */
+#define PIPELINE_ALIGN          64
+#define PIPELINE_SLOTS          16
+#define PIPELINE_BATCH          1024
+#define PIPELINE_CHUNK_SIZE     (64 * 1024)
+#define PIPELINE_SPIN           256
+#define PIPELINE_MAX_DECODERS   64
+#define PIPELINE_TEXT_CHUNK     (1024 * 1024)
+/**
+  * @}
+  */
+
+/* Pipeline data structures ----------------------------------------------*/
+/** @defgroup Pipeline_data_structures
+  * @{
+  */
+
+/* Single-producer/single-consumer ring */
+/**
+  * @brief    head: next slot to read, only written by the consumer.
+  *           tail: next slot to write, only written by the producer.
+  *           tail_seen, head_seen: last value of the other index seen by
+  *           the consumer and the producer, they only read the other
+  *           cache line again when the ring looks empty or full.
+  */
+typedef struct spsc_ring_struct {
+    _Alignas(PIPELINE_ALIGN) atomic_size_t head;
+    size_t tail_seen;
+    _Alignas(PIPELINE_ALIGN) atomic_size_t tail;
+    size_t head_seen;
+    _Alignas(PIPELINE_ALIGN) size_t slot_size;
+    uint8_t* slots;
+}spsc_ring_t;
+
+/* Decoded batch */
+/**
+  * @brief    count: records, last: 1 for the last batch of a text chunk,
+  *           end: 1 for the last batch of the trace.
+  */
+typedef struct pipeline_batch_struct {
+    int count;
+    int last;
+    int end;
+    trace_record_t records[PIPELINE_BATCH];
+}pipeline_batch_t;
+
+/* Output chunk */
+/**
+  * @brief    length bytes of data for the file fp. close: 1 to close fp
+  *           after them. fp NULL ends the logger.
+  */
+typedef struct pipeline_chunk_struct {
+    FILE* fp;
+    int close;
+    size_t length;
+    char data[PIPELINE_CHUNK_SIZE];
+}pipeline_chunk_t;
+
+struct pipeline_struct;
+
+/* Decoder thread */
+/**
+  * @brief    batches: this decoder to the simulation.
+  */
+typedef struct pipeline_decoder_struct {
+    spsc_ring_t batches;
+    struct pipeline_struct* pipeline;
+    int index;
+    int started;
+    pthread_t thread;
+}pipeline_decoder_t;
+
+/* Pipeline */
+/**
+  * @brief    decoders: one reading the trace, or decoders_num parsing the
+  *           chunks of the mapped text, chunk i by decoder i % decoders_num.
+  *           text, bounds: mapped native trace and its chunks_num + 1 chunk
+  *           boundaries, NULL for one decoder.
+  *           chunks: simulation to logger.
+  *           batch, next: batch being simulated and its next record,
+  *           current: decoder it comes from.
+  *           stop: set by pipeline_destroy(), a decoder waiting for a
+  *           slot gives up. failed: set by the logger if a file could not
+  *           be written, the streams fail from then on.
+  */
+typedef struct pipeline_struct {
+    pipeline_decoder_t decoders[PIPELINE_MAX_DECODERS];
+    int decoders_num;
+    spsc_ring_t chunks;
+    trace_t* trace;
+    const char* text;
+    size_t text_size;
+    size_t* bounds;
+    size_t chunks_num;
+    pthread_t logger;
+    int logger_started;
+    atomic_int stop;
+    atomic_int failed;
+    pipeline_batch_t* batch;
+    int next;
+    int current;
+}pipeline_t;
+
+/* Output stream */
+/**
+  * @brief    Stream of pipeline_open(): its bytes go to fp through the
+  *           logger of pipeline.
+  */
+typedef struct pipeline_stream_struct {
+    pipeline_t* pipeline;
+    FILE* fp;
+}pipeline_stream_t;
+
+/**
+  * @}
+  */
+
+/* Pipeline function prototypes -------------------------------------------------*/
+/** @addtogroup Pipeline_data_structures
+  * @{
+  */
+int spsc_ring_init(spsc_ring_t* ring, size_t slot_size);
+void* spsc_ring_write_slot(spsc_ring_t* ring);
+void spsc_ring_push(spsc_ring_t* ring);
+void* spsc_ring_read_slot(spsc_ring_t* ring);
+void spsc_ring_pop(spsc_ring_t* ring);
+void spsc_ring_free(spsc_ring_t* ring);
+pipeline_t* pipeline_create(trace_t* trace, int decoders);
+int pipeline_read(pipeline_t* pipeline, trace_record_t* record);
+FILE* pipeline_open(pipeline_t* pipeline, FILE* fp, int buffered);
+void pipeline_destroy(pipeline_t* pipeline);
+/**
+  * @}
+  */
+
+#endif
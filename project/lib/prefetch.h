@@ -0,0 +1,126 @@
+/**
+  ***********************************************************************
+  * @file       prefetch.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the hardware prefetcher models: next-N-line, stride
+  *             and stream buffers.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef PREFETCH_H
+#define PREFETCH_H
+/* Includes ------------------------------------------------------------*/
+#include "cache.h"
+
+/** @defgroup Prefetch_configuration
+  * @brief    Size of the fixed tables. The queue size must be a power of 2.
+  * @{
+  */
+#define PF_QUEUE_SIZE           32
+#define PF_STRIDE_ENTRIES       16
+#define PF_STRIDE_REGION_BITS   12
+#define PF_STRIDE_CONFIDENCE    2
+#define PF_STREAM_BUFFERS       4
+#define PF_STREAM_DEPTH         4
+#define PF_DEFAULT_DEGREE       2
+#define PF_DEFAULT_FILL_RATE    2
+
+#define PF_INVALID_LINE         0x1
+/**
+  * @}
+  */
+
+/* Prefetch data structures ----------------------------------------------*/
+/** @defgroup Prefetch_data_structures
+  * @{
+  */
+
+/* Prefetcher type */
+/**
+  * @brief    Bit mask of enabled prefetchers.
+  *           PF_NEXT_LINE: fetch next N lines on a miss or first use of a
+  *                         prefetched line (tagged prefetch).
+  *           PF_STRIDE   : PC-less stride detection per memory region.
+  *           PF_STREAM   : sequential stream buffers running ahead of misses.
+  */
+typedef enum prefetch_type_enum {
+    PF_NONE=0,
+    PF_NEXT_LINE=1,
+    PF_STRIDE=2,
+    PF_STREAM=4
+}prefetch_type_t;
+
+/* Stride table entry */
+/**
+  * @brief    Last address and stride seen inside one memory region.
+  */
+typedef struct stride_entry_struct {
+    uint32_t region;
+    uint32_t last_addr;
+    int32_t stride;
+    int confidence;
+    int valid;
+}stride_entry_t;
+
+/* Stream buffer */
+/**
+  * @brief    Window of lines [head, tail) already requested for a stream.
+  */
+typedef struct stream_buffer_struct {
+    uint32_t head;
+    uint32_t tail;
+    int lru;
+    int valid;
+}stream_buffer_t;
+
+/* Prefetcher */
+/**
+  * @brief    One prefetcher instance per L1 cache.
+  *           All storage is fixed size, no allocation after init.
+  */
+typedef struct prefetch_struct {
+    int type;
+    int degree;
+    int fill_rate;
+
+    stride_entry_t stride_table[PF_STRIDE_ENTRIES];
+    int stride_victim;
+    stream_buffer_t streams[PF_STREAM_BUFFERS];
+
+    uint32_t queue[PF_QUEUE_SIZE];
+    int queue_head;
+    int queue_count;
+
+    int issued;
+    int useful;
+    int late;
+    int polluting;
+    int dropped;
+}prefetch_t;
+
+/**
+  * @}
+  */
+
+/* Prefetch function prototypes -------------------------------------------------*/
+/** @addtogroup Prefetch_data_structures
+  * @{
+  */
+int prefetch_init(prefetch_t* pf, int type, int degree);
+int prefetch_parse_type(const char* str);
+int prefetch_update(prefetch_t* pf, cache_t* cache, cache_stat_t* stat,
+                        uint32_t address, int update);
+int prefetch_log(prefetch_t* pf, FILE* fp);
+int prefetch_clear(prefetch_t* pf);
+/**
+  * @}
+  */
+
+#endif
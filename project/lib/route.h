@@ -0,0 +1,106 @@
+/**
+  ***********************************************************************
+  * @file       route.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the address map routing the requests to the caches.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef ROUTE_H
+#define ROUTE_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Route_configuration
+  * @brief    ROUTE_INSTRUCTION/ROUTE_DATA: cache indexes of a core, same
+  *           values as INSTRUCTION_CACHE/DATA_CACHE.
+  *           ROUTE_MAX_REGIONS: regions of one map.
+  * @{
+  */
+#define ROUTE_INSTRUCTION       0
+#define ROUTE_DATA              1
+#define ROUTE_MAX_REGIONS       64
+#define ROUTE_TARGET_SIZE       8
+/**
+  * @}
+  */
+
+/* Route data structures ----------------------------------------------*/
+/** @defgroup Route_data_structures
+  * @{
+  */
+
+/* Kind of region */
+/**
+  * @brief    ROUTE_CACHED    : lines may be held by the caches of the region.
+  *           ROUTE_SCRATCHPAD: on-chip memory, never cached, always ready.
+  *           ROUTE_UNCACHED  : memory mapped I/O, goes around the caches.
+  */
+typedef enum route_kind_enum {
+    ROUTE_CACHED=0,
+    ROUTE_SCRATCHPAD,
+    ROUTE_UNCACHED
+}route_kind_t;
+
+/* Region of the address map */
+/**
+  * @brief    base..end: byte addresses, end included.
+  *           caches   : BIT(ROUTE_INSTRUCTION) | BIT(ROUTE_DATA) allowed to
+  *                      hold the lines (ROUTE_CACHED only). A fetch uses the
+  *                      instruction cache, a read/write the data cache; if
+  *                      the cache is not allowed the access is uncached.
+  *           home     : cache reporting an evict of a line held nowhere.
+  *           reads, writes, fetches: accesses that bypassed the caches.
+  */
+typedef struct route_region_struct {
+    uint32_t base;
+    uint32_t end;
+    route_kind_t kind;
+    uint8_t caches;
+    uint8_t home;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t fetches;
+}route_region_t;
+
+/* Address map */
+/**
+  * @brief    regions: sorted by base, never overlapping.
+  *           custom : 1 if given by route_parse(), logged then.
+  */
+typedef struct route_struct {
+    int regions_num;
+    int custom;
+    route_region_t regions[ROUTE_MAX_REGIONS];
+}route_t;
+
+/**
+  * @}
+  */
+
+/* Route function prototypes -------------------------------------------------*/
+/** @addtogroup Route_data_structures
+  * @{
+  */
+route_t* route_create(void);
+int route_add(route_t* route, uint32_t base, uint32_t end, route_kind_t kind, uint8_t caches, uint8_t home);
+int route_parse(route_t* route, const char* str);
+route_region_t* route_lookup(route_t* route, uint32_t address);
+int route_cached(route_region_t* region, int cache);
+void route_bypass(route_region_t* region, int command);
+int route_clear(route_t* route);
+void route_destroy(route_t* route);
+int route_log(route_t* route, FILE* fp);
+/**
+  * @}
+  */
+
+#endif
@@ -0,0 +1,103 @@
+/**
+  ***********************************************************************
+  * @file       sample.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the sampled simulation (functional warming between
+  *             periodic measurement windows).
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef SAMPLE_H
+#define SAMPLE_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Sample_configuration
+  * @brief    Status bits of sample_next(), for the next access:
+  *           SAMPLE_DETAILED: simulate it in detail (detailed warming or
+  *                            measurement), otherwise warming only.
+  *           SAMPLE_OPEN    : a measurement window starts with it.
+  *           SAMPLE_CLOSE   : the measurement window ends with it.
+  *           Confidence intervals use z = 1.96 (95%) and z = 3 (99.7%),
+  *           SAMPLE_TARGET_ERROR is the relative error used to advise the
+  *           number of windows.
+  * @{
+  */
+#define SAMPLE_DETAILED         BIT(0)
+#define SAMPLE_OPEN             BIT(1)
+#define SAMPLE_CLOSE            BIT(2)
+#define SAMPLE_Z_95             1.96
+#define SAMPLE_Z_997            3.0
+#define SAMPLE_TARGET_ERROR     0.03
+/**
+  * @}
+  */
+
+/* Sample data structures ----------------------------------------------*/
+/** @defgroup Sample_data_structures
+  * @{
+  */
+
+/* Estimator of one cache */
+/**
+  * @brief    start_*: counters of the cache when the window opened.
+  *           mean, m2: running mean and sum of squared deviations of the
+  *                     hit rate of the windows (Welford).
+  */
+typedef struct sample_stat_struct {
+    uint32_t start_hits;
+    uint32_t start_accesses;
+    uint64_t windows;
+    uint64_t hits;
+    uint64_t accesses;
+    double mean;
+    double m2;
+}sample_stat_t;
+
+/* Sampler */
+/**
+  * @brief    Every period accesses: period - warmup - window accesses of
+  *           functional warming, warmup accesses of detailed warming,
+  *           then window accesses measured.
+  */
+typedef struct sample_struct {
+    uint32_t period;
+    uint32_t window;
+    uint32_t warmup;
+    uint32_t position;
+    uint64_t warmed;
+    uint64_t detailed;
+    int stats_num;
+    sample_stat_t* stats;
+}sample_t;
+
+/**
+  * @}
+  */
+
+/* Sample function prototypes -------------------------------------------------*/
+/** @addtogroup Sample_data_structures
+  * @{
+  */
+sample_t* sample_create(uint32_t period, uint32_t window, uint32_t warmup, int stats_num);
+int sample_parse(const char* str, uint32_t* period, uint32_t* window, uint32_t* warmup);
+int sample_next(sample_t* sample);
+void sample_open(sample_t* sample, int index, uint32_t hits, uint32_t accesses);
+void sample_close(sample_t* sample, int index, uint32_t hits, uint32_t accesses);
+int sample_clear(sample_t* sample);
+void sample_destroy(sample_t* sample);
+int sample_log(sample_t* sample, FILE* fp);
+int sample_log_stat(sample_t* sample, int index, const char* name, FILE* fp);
+/**
+  * @}
+  */
+
+#endif
@@ -0,0 +1,188 @@
+/**
+  ***********************************************************************
+  * @file       sim.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the simulator context: the cache hierarchy of all cores,
+  *             its statistic, trace and log files.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef SIM_H
+#define SIM_H
+/* Includes ------------------------------------------------------------*/
+#include "cache.h"
+#include "prefetch.h"
+#include "coherence.h"
+#include "sample.h"
+#include "route.h"
+#include "stats.h"
+#include "trace.h"
+#include "pipeline.h"
+#include "traceidx.h"
+
+/** @defgroup Sim_configuration
+  * @brief    The cache geometries below are the defaults of sim_config_init(),
+  *           a configuration file changes them at run time (config.c).
+  * @{
+  */
+//Default address map, see route.c. The rest is instruction memory:
+#define INSTR_BASE_ADDR 0x0
+#define INSTR_END_ADDR  0xffffff
+#define INSTRUCTION_CACHE               0
+#define INSTRUCTION_CACHE_ASSOC_WAYS    2
+#define INSTRUCTION_CACHE_NUM_SETS      16*K
+#define INSTRUCTION_CACHE_LINE_SIZE     64
+
+//data memory from 0-> 3/4 * 2^32 -1
+#define DATA_BASE_ADDR  0x1000000
+#define DATA_END_ADDR   0xffffffff
+#define DATA_CACHE                      1
+#define DATA_CACHE_ASSOC_WAYS           4
+#define DATA_CACHE_NUM_SETS             16*K
+#define DATA_CACHE_LINE_SIZE            64
+
+#define SIM_ROUTE_SIZE      512
+#define SIM_NAME_SIZE       32
+#define SIM_PATH_SIZE       256
+#define SIM_MAX_INFLIGHT    64
+/**
+  * @}
+  */
+
+/* Simulator data structures ----------------------------------------------*/
+/** @defgroup Sim_data_structures
+  * @{
+  */
+
+/* Simulator configuration */
+/**
+  * @brief    Options of one simulation, see sim_config_init() for defaults.
+  *           coherence: 0 for one core without directory,
+  *                      1 for cores_num cores sharing an L2 directory.
+  *           sample_*: sampled simulation, see sample.c. 0 period for
+  *                     a full detailed simulation.
+  *           rle: 1 to merge consecutive trace records of one core to
+  *                the same line with the same command, see sim_step_batch().
+  *           huge_pages: 1 to keep the storage of each L1 cache on 2 MB
+  *                       pages (CACHE_ALLOC_HUGE), touched at once by
+  *                       sim_create() on the NUMA node of its thread.
+  *           route_map: address map for route_parse(), empty for the
+  *                      default map (instruction and data memory, see above).
+  *           l1_sets, l1_ways: geometry of the L1 caches, indexed by
+  *                      INSTRUCTION_CACHE/DATA_CACHE.
+  *           line_size: line size of every level (L1, victim buffer, write
+  *                      buffer, L2).
+  *           stats_path: statistic export file (stats.c), empty for none.
+  *                      stats_format: see stats_format_t.
+  *           interleave: trace records in flight in sim_step_batch(), their
+  *                      host memory prefetched ahead; 0 or 1 for none.
+  *           trace_format: format of the trace file, see trace_format_t.
+  *           miss_trace_path: trace of the L1 to L2 transactions
+  *                      (misstrace.c), empty for none.
+  *           pipeline: 1 to decode the trace and write the log and the
+  *                      miss trace on their own threads (pipeline.c).
+  *           decoders: parser threads of a native trace in the pipeline,
+  *                      0 or 1 for one decoder.
+  *           trace_start, trace_end: records [start, end) of the trace are
+  *                      replayed, from 0, end 0 for the whole rest.
+  *           sector_size: bytes of a sector of the L1 lines, 0 for whole
+  *                      lines, see cache_set_sectors().
+  *           line_usage: 1 to record the bytes used of every L1 line, see
+  *                      cache_set_usage().
+  */
+typedef struct sim_config_struct {
+    int mode;
+    int cores_num;
+    int coherence;
+    int l2_sets;
+    int l2_ways;
+    int prefetch_type;
+    int prefetch_degree;
+    int victim_entries;
+    int mshr_entries;
+    int mshr_window;
+    write_policy_t write_policy;
+    int write_allocate;
+    int write_buffer_entries;
+    int timing_enabled;
+    uint32_t latencies[4];
+    uint32_t sample_period;
+    uint32_t sample_window;
+    uint32_t sample_warmup;
+    int rle;
+    int huge_pages;
+    char route_map[SIM_ROUTE_SIZE];
+    int l1_sets[2];
+    int l1_ways[2];
+    int line_size;
+    char stats_path[SIM_PATH_SIZE];
+    stats_format_t stats_format;
+    int interleave;
+    trace_format_t trace_format;
+    char miss_trace_path[SIM_PATH_SIZE];
+    int pipeline;
+    int decoders;
+    uint64_t trace_start;
+    uint64_t trace_end;
+    int sector_size;
+    int line_usage;
+}sim_config_t;
+
+/* Simulator context */
+/**
+  * @brief    Everything one simulation owns. Contexts share nothing,
+  *           several of them can run at the same time on different threads.
+  */
+typedef struct sim_context_struct {
+    sim_config_t config;
+    trace_t* trace;         //NULL if no trace
+    uint64_t trace_left;    //records left to read before config.trace_end
+    FILE* log_file;
+    long records;
+
+    //one instruction and one data cache per core:
+    cache_t* instruction_caches[DIR_MAX_CORES];
+    cache_t* data_caches[DIR_MAX_CORES];
+    cache_stat_t instruction_cache_stats[DIR_MAX_CORES];
+    cache_stat_t data_cache_stats[DIR_MAX_CORES];
+    prefetch_t instruction_prefetches[DIR_MAX_CORES];
+    prefetch_t data_prefetches[DIR_MAX_CORES];
+    char cache_names[DIR_MAX_CORES][2][SIM_NAME_SIZE];
+
+    directory_t* directory; //multi-core only, NULL otherwise
+    timing_t* timing;       //NULL if disabled
+    sample_t* sample;       //NULL if not sampled
+    route_t* route;         //address map of the requests
+    stats_t* stats;         //NULL if not exported
+    misstrace_t* misstrace; //NULL if not written
+    pipeline_t* pipeline;   //NULL if not pipelined
+}sim_context_t;
+
+/**
+  * @}
+  */
+
+/* Simulator function prototypes -------------------------------------------------*/
+/** @addtogroup Sim_data_structures
+  * @{
+  */
+int sim_config_init(sim_config_t* config);
+int sim_config_check(const sim_config_t* config);
+sim_context_t* sim_create(const sim_config_t* config, const char* trace_path, const char* log_path);
+int sim_request(sim_context_t* sim, int command, uint32_t address, int core);
+int sim_request_repeat(sim_context_t* sim, int command, uint32_t address, int core, uint32_t count);
+int sim_step_batch(sim_context_t* sim, int records_num);
+int sim_export(sim_context_t* sim, const char* event);
+void sim_destroy(sim_context_t* sim);
+/**
+  * @}
+  */
+
+#endif
@@ -0,0 +1,67 @@
+/**
+  ***********************************************************************
+  * @file       simd.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Small SIMD helpers for searching the fixed-size tables
+  *             (victim buffer, MSHR). SSE2 when available, otherwise
+  *             a plain loop.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef SIMD_H
+#define SIMD_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/** @defgroup SIMD_utilities
+  * @{
+  */
+#define SIMD_LANES_U32      4
+#define SIMD_ROUND_U32(N)   (((N) + SIMD_LANES_U32 - 1) & ~(SIMD_LANES_U32 - 1))
+
+/**
+  * @brief      Find the first element equal to key.
+  * @param      keys: array of keys, size must be a multiple of SIMD_LANES_U32.
+  * @param      n: number of keys to search, multiple of SIMD_LANES_U32.
+  * @param      key: value to search.
+  * @retval     index of the first match, otherwise -1.
+  */
+static inline int simd_find_u32(const uint32_t* keys, int n, uint32_t key)
+{
+    int i;
+#ifdef __SSE2__
+    __m128i k = _mm_set1_epi32((int)key);
+    for(i = 0; i < n; i += SIMD_LANES_U32)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(keys + i));
+        int m = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, k)));
+        if(m)
+        {
+            return i + __builtin_ctz(m);
+        }
+    }
+#else
+    for(i = 0; i < n; i++)
+    {
+        if(keys[i] == key)
+        {
+            return i;
+        }
+    }
+#endif
+    return -1;
+}
+/**
+  * @}
+  */
+
+#endif
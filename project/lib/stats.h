@@ -0,0 +1,112 @@
+/**
+  ***********************************************************************
+  * @file       stats.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the machine readable export of the statistic (JSON, CSV,
+  *             binary).
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef STATS_H
+#define STATS_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Stats_configuration
+  * @brief    STATS_BUFFER_SIZE: bytes gathered before one write to the file.
+  *           STATS_NAME_SIZE  : longest run, group or counter name.
+  *           STATS_MAGIC/STATS_VERSION: header of a binary file, written
+  *           once when the file is created.
+  * @{
+  */
+#define STATS_BUFFER_SIZE       (64 * 1024)
+#define STATS_NAME_SIZE         256
+#define STATS_MAGIC             "CSIMSTAT"
+#define STATS_VERSION           1
+
+/* Records of the binary format, first byte of each record */
+#define STATS_REC_RUN           1
+#define STATS_REC_BEGIN         2
+#define STATS_REC_GROUP         3
+#define STATS_REC_COUNTER       4
+#define STATS_REC_END           5
+/**
+  * @}
+  */
+
+/* Stats data structures ----------------------------------------------*/
+/** @defgroup Stats_data_structures
+  * @{
+  */
+
+/* Export format */
+/**
+  * @brief    STATS_AUTO  : from the file extension, .json or .csv, else binary.
+  *           STATS_JSON  : one JSON object per snapshot and line (JSON Lines).
+  *           STATS_CSV   : one row per counter:
+  *                         run,snapshot,event,records,group,counter,value
+  *           STATS_BINARY: append-only records, little endian, see stats.c.
+  */
+typedef enum stats_format_enum {
+    STATS_AUTO=0,
+    STATS_JSON,
+    STATS_CSV,
+    STATS_BINARY
+}stats_format_t;
+
+/* Stats writer */
+/**
+  * @brief    One buffered writer: every format goes through buffer, the
+  *           file is only written when it is full or by stats_flush().
+  *           snapshot: index of the next snapshot of this run.
+  *           groups: written in the current snapshot, -1 out of a snapshot.
+  *           counters, group_counters: written in the snapshot, in the group.
+  *           prefix: CSV only, start of the rows of the current group,
+  *                   prefix_begin: length of its run,snapshot,event,records
+  *                   part.
+  */
+typedef struct stats_struct {
+    FILE* fp;
+    stats_format_t format;
+    char run[STATS_NAME_SIZE];
+    uint32_t snapshot;
+    int groups;
+    int group_counters;
+    uint32_t counters;
+    char prefix[4 * STATS_NAME_SIZE];
+    size_t prefix_begin;
+    size_t prefix_length;
+    size_t used;
+    char buffer[STATS_BUFFER_SIZE];
+}stats_t;
+
+/**
+  * @}
+  */
+
+/* Stats function prototypes -------------------------------------------------*/
+/** @addtogroup Stats_data_structures
+  * @{
+  */
+int stats_parse_format(const char* str);
+const char* stats_format_name(stats_format_t format);
+stats_t* stats_create(const char* path, stats_format_t format, const char* run);
+int stats_begin(stats_t* stats, const char* event, uint64_t records);
+int stats_group(stats_t* stats, const char* name);
+int stats_counter(stats_t* stats, const char* name, uint64_t value);
+int stats_end(stats_t* stats);
+int stats_flush(stats_t* stats);
+void stats_destroy(stats_t* stats);
+/**
+  * @}
+  */
+
+#endif
@@ -0,0 +1,78 @@
+/**
+  ***********************************************************************
+  * @file       timing.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the latency model shared by the L1 caches.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef TIMING_H
+#define TIMING_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Timing_configuration
+  * @brief    Default latencies in cycles, and histogram size.
+  *           Bin i of the histogram counts latencies in [2^i, 2^(i+1)),
+  *           bin 0 also counts 0, the last bin counts everything above.
+  * @{
+  */
+#define TIMING_DEFAULT_L1_HIT       1
+#define TIMING_DEFAULT_L2_HIT       10
+#define TIMING_DEFAULT_MEMORY       100
+#define TIMING_DEFAULT_WRITEBACK    10
+#define TIMING_HIST_BINS            16
+/**
+  * @}
+  */
+
+/* Timing data structures ----------------------------------------------*/
+/** @defgroup Timing_data_structures
+  * @{
+  */
+
+/* Latency model */
+/**
+  * @brief    Latencies (cycles) of one cache hierarchy.
+  *           l2_lines is a bitmap of the lines held by L2: a line is
+  *           brought in by its first L1 miss (memory latency) and dropped
+  *           by the L2 evict command, other misses hit L2.
+  */
+typedef struct timing_struct {
+    uint32_t l1_hit;
+    uint32_t l2_hit;
+    uint32_t memory;
+    uint32_t writeback;
+    int line_bits;
+    uint64_t* l2_lines;
+}timing_t;
+
+/**
+  * @}
+  */
+
+/* Timing function prototypes -------------------------------------------------*/
+/** @addtogroup Timing_data_structures
+  * @{
+  */
+timing_t* timing_create(uint32_t l1_hit, uint32_t l2_hit, uint32_t memory,
+                            uint32_t writeback, int line_size);
+int timing_parse(const char* str, uint32_t* latencies);
+uint32_t timing_l2_read(timing_t* timing, uint32_t address);
+void timing_l2_evict(timing_t* timing, uint32_t address);
+int timing_clear(timing_t* timing);
+void timing_destroy(timing_t* timing);
+int timing_hist_bin(uint32_t latency);
+/**
+  * @}
+  */
+
+#endif
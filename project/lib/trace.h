@@ -0,0 +1,115 @@
+/**
+  ***********************************************************************
+  * @file       trace.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the trace readers (native, Valgrind Lackey, DineroIV,
+  *             ChampSim).
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef TRACE_H
+#define TRACE_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Trace_configuration
+  * @brief    TRACE_LINE_SIZE    : longest line of a text trace.
+  *           TRACE_MAX_ACCESSES : accesses of one input record, a ChampSim
+  *                                instruction has 1 fetch, 4 loads, 2 stores.
+  *           TRACE_CHAMPSIM_SIZE: bytes of one ChampSim instruction.
+  * @{
+  */
+#define TRACE_LINE_SIZE         512
+#define TRACE_MAX_ACCESSES      8
+#define TRACE_CHAMPSIM_SIZE     64
+/**
+  * @}
+  */
+
+/* Trace data structures ----------------------------------------------*/
+/** @defgroup Trace_data_structures
+  * @{
+  */
+
+/* Trace format */
+/**
+  * @brief    TRACE_AUTO    : .din is DineroIV, .champsimtrace ChampSim, a
+  *                           text starting like Lackey is Lackey, else native.
+  *           TRACE_NATIVE  : "<command> <address in hex> [core] [count]".
+  *           TRACE_LACKEY  : valgrind --tool=lackey --trace-mem=yes,
+  *                           "I  addr,size", " L addr,size", " S", " M".
+  *           TRACE_DINERO  : DineroIV din, "<label> <address> [size]",
+  *                           label 0 read, 1 write, 2 fetch, 4 flush.
+  *           TRACE_CHAMPSIM: uncompressed ChampSim binary instructions.
+  */
+typedef enum trace_format_enum {
+    TRACE_AUTO=0,
+    TRACE_NATIVE,
+    TRACE_LACKEY,
+    TRACE_DINERO,
+    TRACE_CHAMPSIM
+}trace_format_t;
+
+/* Trace record */
+/**
+  * @brief    One request of the trace, see sim_step_batch().
+  */
+typedef struct trace_record_struct {
+    int command;
+    uint32_t address;
+    int core;
+    uint32_t count;
+}trace_record_t;
+
+/* Access of an input record */
+/**
+  * @brief    address..end: first and last byte, split at line boundaries
+  *           into one record per line when read.
+  */
+typedef struct trace_access_struct {
+    int command;
+    uint64_t address;
+    uint64_t end;
+}trace_access_t;
+
+/* Trace reader */
+/**
+  * @brief    accesses: of the last input record, the next one to read at
+  *           access_next.
+  */
+typedef struct trace_struct {
+    FILE* fp;
+    trace_format_t format;
+    uint64_t line_mask;
+    trace_access_t accesses[TRACE_MAX_ACCESSES];
+    int accesses_num;
+    int access_next;
+}trace_t;
+
+/**
+  * @}
+  */
+
+/* Trace function prototypes -------------------------------------------------*/
+/** @addtogroup Trace_data_structures
+  * @{
+  */
+int trace_parse_format(const char* str);
+const char* trace_format_name(trace_format_t format);
+trace_t* trace_create(const char* path, trace_format_t format, int line_size);
+int trace_read(trace_t* trace, trace_record_t* record);
+int trace_parse_text(const char** p, const char* end, trace_record_t* record);
+void trace_destroy(trace_t* trace);
+/**
+  * @}
+  */
+
+#endif
@@ -0,0 +1,100 @@
+/**
+  ***********************************************************************
+  * @file       traceidx.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the trace index: record numbers to file offsets, and
+  *             the positions of the control records.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef TRACEIDX_H
+#define TRACEIDX_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+#include "trace.h"
+
+/** @defgroup Trace_index_configuration
+  * @brief    TRACEIDX_INTERVAL : records between two seek points.
+  *           TRACEIDX_EXTENSION: added to the trace name for the index file.
+  *           TRACEIDX_MAGIC, TRACEIDX_VERSION: first bytes of the file.
+  * @{
+  */
+#define TRACEIDX_INTERVAL       65536
+#define TRACEIDX_EXTENSION      ".idx"
+#define TRACEIDX_MAGIC          "CSIX"
+#define TRACEIDX_VERSION        1
+/**
+  * @}
+  */
+
+/* Trace index data structures ----------------------------------------------*/
+/** @defgroup Trace_index_data_structures
+  * @{
+  */
+
+/* Index file header */
+/**
+  * @brief    trace_size, trace_mtime: of the trace when it was indexed, the
+  *           index is built again if they changed.
+  *           records: records of the trace (trace_read()).
+  *           points_num: records / interval + 1, controls_num: control
+  *           records. The points (uint64_t) and the controls follow.
+  */
+typedef struct trace_index_header_struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t interval;
+    uint32_t reserved;
+    uint64_t trace_size;
+    int64_t trace_mtime;
+    uint64_t records;
+    uint64_t points_num;
+    uint64_t controls_num;
+}trace_index_header_t;
+
+/* Control record */
+/**
+  * @brief    record: number of a CLEAR_CACHE or PRINT_CONTENT record.
+  */
+typedef struct trace_control_struct {
+    uint64_t record;
+    uint32_t command;
+    uint32_t reserved;
+}trace_control_t;
+
+/* Trace index */
+/**
+  * @brief    points[i]: offset where the reader continues to read record
+  *           i * interval, so points[0] is 0.
+  */
+typedef struct trace_index_struct {
+    trace_index_header_t header;
+    uint64_t* points;
+    trace_control_t* controls;
+}trace_index_t;
+
+/**
+  * @}
+  */
+
+/* Trace index function prototypes -------------------------------------------------*/
+/** @addtogroup Trace_index_data_structures
+  * @{
+  */
+trace_index_t* traceidx_open(const char* trace_path);
+int traceidx_seek(const trace_index_t* index, trace_t* trace, uint64_t record);
+int traceidx_log(const trace_index_t* index, FILE* fp);
+void traceidx_destroy(trace_index_t* index);
+/**
+  * @}
+  */
+
+#endif
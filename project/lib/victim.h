@@ -0,0 +1,80 @@
+/**
+  ***********************************************************************
+  * @file       victim.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the fully-associative victim buffer between L1 and L2.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef VICTIM_H
+#define VICTIM_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Victim_configuration
+  * @brief    VICTIM_MAX_ENTRIES must be a multiple of SIMD_LANES_U32.
+  * @{
+  */
+#define VICTIM_MAX_ENTRIES      16
+#define VICTIM_INVALID_LINE     0x1
+/**
+  * @}
+  */
+
+/* Victim buffer data structures ----------------------------------------------*/
+/** @defgroup Victim_data_structures
+  * @{
+  */
+
+/* Victim buffer */
+/**
+  * @brief    Lines evicted from L1, searched on every L1 miss.
+  *           Entry i holds line address lines[i] (VICTIM_INVALID_LINE if empty)
+  *           and line_size bytes at data + i * line_size.
+  */
+typedef struct victim_struct {
+    int entries_num;
+    int line_size;
+    uint32_t clock;
+    uint32_t lines[VICTIM_MAX_ENTRIES];
+    uint32_t stamp[VICTIM_MAX_ENTRIES];
+    uint8_t dirty[VICTIM_MAX_ENTRIES];
+    uint8_t* data;
+
+    int probes;
+    int hits;
+    int fills;
+    int writebacks;
+}victim_t;
+
+#define VICTIM_DATA(vc, i)      ((vc)->data + (i) * (vc)->line_size)
+
+/**
+  * @}
+  */
+
+/* Victim buffer function prototypes -------------------------------------------------*/
+/** @addtogroup Victim_data_structures
+  * @{
+  */
+victim_t* victim_create(int entries_num, int line_size);
+int victim_lookup(victim_t* vc, uint32_t line);
+int victim_select(victim_t* vc);
+void victim_place(victim_t* vc, int index, uint32_t line, uint8_t* data, int dirty);
+void victim_invalidate(victim_t* vc, int index);
+int victim_clear(victim_t* vc);
+void victim_destroy(victim_t* vc);
+int victim_log(victim_t* vc, FILE* fp);
+/**
+  * @}
+  */
+
+#endif
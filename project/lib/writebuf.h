@@ -0,0 +1,84 @@
+/**
+  ***********************************************************************
+  * @file       writebuf.h
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      This file contains all the functions prototypes for
+  *             the coalescing write buffer between L1 and L2.
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+
+
+/* Define to prevent recursive inclusion -------------------------------*/
+#ifndef WRITEBUF_H
+#define WRITEBUF_H
+/* Includes ------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdio.h>
+
+/** @defgroup Write_buffer_configuration
+  * @brief    WB_MAX_ENTRIES must be a power of 2 and a multiple of SIMD_LANES_U32.
+  * @{
+  */
+#define WB_MAX_ENTRIES          32
+#define WB_INVALID_LINE         0x1
+#define WB_FULL_LINE            0xFFFFFFFFFFFFFFFFULL
+#define WB_MASK_BITS            64      //parts of a line in a coalescing mask
+/**
+  * @}
+  */
+
+/* Write buffer data structures ----------------------------------------------*/
+/** @defgroup Write_buffer_data_structures
+  * @{
+  */
+
+/* Write buffer */
+/**
+  * @brief    FIFO of pending L2 writes, one entry per line, kept as a
+  *           ring of entries_num slots from head. Slots flushed out of
+  *           order stay in the ring as holes (WB_INVALID_LINE).
+  *           masks[i] has one bit per part of the line written, a part
+  *           is 1 << mask_shift bytes (one byte up to 64-byte lines,
+  *           line_size / 64 above), a writeback sets WB_FULL_LINE.
+  */
+typedef struct write_buffer_struct {
+    int entries_num;
+    int line_size;
+    int mask_shift;
+    uint32_t lines[WB_MAX_ENTRIES];
+    uint64_t masks[WB_MAX_ENTRIES];
+    int head;
+    int count;
+
+    int writes;
+    int coalesced;
+    int full;
+    int flushes;
+    int l2_writes;
+    uint64_t l2_bytes;
+}write_buffer_t;
+
+/**
+  * @}
+  */
+
+/* Write buffer function prototypes -------------------------------------------------*/
+/** @addtogroup Write_buffer_data_structures
+  * @{
+  */
+write_buffer_t* writebuf_create(int entries_num, int line_size);
+int writebuf_write(write_buffer_t* wb, uint32_t address, int size);
+int writebuf_flush_line(write_buffer_t* wb, uint32_t address);
+int writebuf_drain(write_buffer_t* wb);
+int writebuf_clear(write_buffer_t* wb);
+void writebuf_destroy(write_buffer_t* wb);
+int writebuf_log(write_buffer_t* wb, FILE* fp);
+/**
+  * @}
+  */
+
+#endif
@@ -21,6 +21,17 @@
             (++) Configure number of sets.
             (++) Configure associativity (N-way).
             (++) Configure line size (bytes).
+            (++) Configure the storage: CACHE_ALLOC_MALLOC, or
+                 CACHE_ALLOC_HUGE to keep all sets, lines and data in one
+                 arena of 2 MB pages (fewer TLB misses on random traces).
+            Release it by destroy_cache().
+
+        (#) The storage of a set is written on the first access to the
+            set, by the thread simulating the cache: with the default NUMA
+            policy its pages are placed on the node of that thread (first
+            touch). A thread owning a cache can also place all the storage
+            at once by cache_first_touch() before simulating, sim_create()
+            does it for the caches on huge pages.
 
         (#) Do not use the create_set() and create_line(), unless you
             want to control the cache manually. Otherwise, just use
@@ -40,6 +51,53 @@
             (++) L2 evict command   :       cache_L2_evict().
             (++) Read from L2       :       cache_L2_read().
             (++) Write to L2        :       cache_L2_write().
+            (++) Lookup only        :       cache_L1_probe().
+            (++) Prefetch fill      :       cache_L1_prefetch().
+            (++) Directory snoop    :       cache_L1_snoop().
+            (++) Warming only       :       cache_L1_warm_read(),
+                                            cache_L1_warm_write().
+            (++) Repeated hits      :       cache_L1_repeatable(),
+                                            cache_L1_repeat().
+            (++) Host prefetch hint :       cache_L1_host_prefetch().
+
+        (#) Optional structures attached to a cache (NULL to disable):
+            (++) cache->victim: victim buffer probed on miss, see victim.c.
+            (++) cache->mshr  : miss merging registers, see mshr.c. A
+                 merged miss takes the data of the outstanding one: no
+                 L2 read, no L2 bytes, and only the L1 hit latency the
+                 access already pays (the time left of the outstanding
+                 miss is not modelled). With a directory the line is
+                 still registered, without its latency. The entry of a
+                 line is dropped when the line is replaced or
+                 invalidated, so only a miss to a line whose first fill
+                 is still outstanding merges.
+            (++) cache->wbuf  : coalescing write buffer, see writebuf.c.
+            (++) cache->misstrace: trace of the transactions to L2, set by
+                 cache_set_misstrace(), see misstrace.c.
+            (++) cache->directory: shared L2 keeping the L1 caches of
+                 several cores coherent, see coherence.c.
+
+        (#) Writes follow cache_set_write_policy(): write-back (default),
+            write-through, or write-through on the first write to a line
+            only, with or without write allocate.
+
+        (#) A cache of 1 set is fully associative: a hash table finds the
+            way of a line and a list keeps the LRU order (cache->fa, see
+            fullassoc.c), so each access is O(1) for thousands of ways.
+
+        (#) cache_set_sectors() cuts the lines in sectors, each with its
+            own valid and dirty bit. A miss on a present line reads only
+            the missing sector (SECTOR_MISS), a write back only writes the
+            dirty sectors. The bytes read from and written to L2 are
+            counted in the cache.
+
+        (#) cache_set_usage() records the bytes of each line used by the
+            reads and writes, in CACHE_USAGE_PARTS parts of the line. When
+            the line leaves (replaced, moved to the victim buffer or
+            invalidated), the number of parts used goes to
+            cache->usage_hist: how much of the fetched lines is used.
+            Functional warming marks no part and does not count the lines
+            it replaces.
     
     [..] Cache statistic APIs:
         (#) Create a pointer of stat by cache_stat_create().
@@ -53,6 +111,7 @@
             (++) Create stat        :       cache_stat_create().
             (++) Init stat          :       cache_stat_init().
             (++) Stat update        :       cache_stat_update().
+            (++) Repeated hits      :       cache_stat_repeat().
             (++) Log to file        :       cache_log().
             (++) Clear stat         :       clear_stat().
             (++) Print cache state  :       print_cache().
@@ -70,7 +129,10 @@
   * All rights reserved.</center></h2>
   */
 /* Includes ------------------------------------------------------------*/
+#include <string.h>
+#include <sys/mman.h>
 #include "cache.h"
+#include "coherence.h"
 
 
 /* Cache function prototypes -------------------------------------------------*/
@@ -79,21 +141,133 @@
   */
 
 /* Cache Initialize functions ************************************************/
+/**
+  * @attention  RESTRICTED API
+  * @brief      Sizes of the parts of the arena: sets, lines, data.
+  *             Each part starts on a cache line of the host.
+  */
+static size_t cache_arena_sets_size(cache_t* cache)
+{
+    size_t size = ((size_t)1 << cache->sets_num_bits) * sizeof(set_t);
+    return (size + 63) & ~(size_t)63;
+}
+
+static size_t cache_arena_lines_size(cache_t* cache)
+{
+    size_t size = ((size_t)1 << cache->sets_num_bits) * cache->ways_assoc * sizeof(line_t);
+    return (size + 63) & ~(size_t)63;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Map the arena of a cache on 2 MB pages: reserved huge pages
+  *             first, then transparent huge pages on a 2 MB aligned mapping.
+  *             The pages are not touched here, see cache_first_touch().
+  * @param      cache: pointer to cache instance, sets_num_bits, ways_assoc
+  *                    and bytes_num_bits set.
+  * @retval     SUCCESS and cache->arena/arena_size/alloc set, ERROR if no
+  *             mapping could be made.
+  */
+static int cache_arena_create(cache_t* cache)
+{
+    size_t size = cache_arena_sets_size(cache) + cache_arena_lines_size(cache) +
+                  ((size_t)1 << (cache->sets_num_bits + cache->bytes_num_bits)) * cache->ways_assoc;
+    size = (size + CACHE_HUGE_PAGE_SIZE - 1) & ~(size_t)(CACHE_HUGE_PAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+    void *arena = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(arena != MAP_FAILED)
+    {
+        cache->arena = arena;
+        cache->arena_size = size;
+        cache->alloc = CACHE_ALLOC_HUGETLB;
+        return SUCCESS;
+    }
+#endif
+    //one more page, then cut the mapping to a 2 MB boundary:
+    uint8_t *map = (uint8_t*)mmap(NULL, size + CACHE_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(map == MAP_FAILED)
+    {
+        return ERROR;
+    }
+    uintptr_t start = ((uintptr_t)map + CACHE_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(CACHE_HUGE_PAGE_SIZE - 1);
+    size_t head = start - (uintptr_t)map;
+    if(head > 0)
+    {
+        munmap(map, head);
+    }
+    munmap((uint8_t*)start + size, CACHE_HUGE_PAGE_SIZE - head);
+#ifdef MADV_HUGEPAGE
+    //if THP is disabled it fails, the arena stays on small pages.
+    madvise((void*)start, size, MADV_HUGEPAGE);
+#endif
+    cache->arena = (void*)start;
+    cache->arena_size = size;
+    cache->alloc = CACHE_ALLOC_THP;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Check a cache geometry: powers of 2, and the tag array of a
+  *             line (tag, V, D, LRU bits) must fit in 31 bits (BIT() is
+  *             an int shift). A cache of 1 set keeps no LRU bits, it has
+  *             up to FA_MAX_ENTRIES ways.
+  * @param      sets_num: number of set in the cache.
+  * @param      ways_assoc: associativity of cache.
+  * @param      line_size: line(block) size in bytes.
+  * @retval     SUCCESS if the geometry is supported. Otherwise ERROR.
+  */
+int cache_check_geometry(int sets_num, int ways_assoc, int line_size)
+{
+    if(!IS_POWER_OF_2(sets_num) || !IS_POWER_OF_2(ways_assoc) || !IS_POWER_OF_2(line_size))
+    {
+        printf("Error: Sets %d, ways %d and line size %d must be powers of 2.\n",
+                sets_num, ways_assoc, line_size);
+        return ERROR;
+    }
+    int tags_num_bits = MEMORY_ADDRESS - LOG2(sets_num) - LOG2(line_size);
+    if(sets_num == 1 && ways_assoc > FA_MAX_ENTRIES)
+    {
+        printf("Error: A fully-associative cache has at most %d ways.\n", FA_MAX_ENTRIES);
+        return ERROR;
+    }
+    if(tags_num_bits + 2 + ((sets_num == 1) ? 0 : LOG2(ways_assoc)) > 31)
+    {
+        printf("Error: %d sets x %d ways x %d bytes: tag (%d bits), V, D and LRU bits do not fit in 31 bits.\n",
+                sets_num, ways_assoc, line_size, tags_num_bits);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
 /**
   * @brief      Create a pointer of cache and return it for use.
   * @param      sets_num: number of set in the cache.
   * @param      ways_assoc: associativity of cache, for example: 4-way -> ways_assoc == 4
   * @param      line_size: line(block) size, for example: 64-byte line -> line_size == 64
-  * @retval     pointer to the cache instance
+  * @param      alloc: CACHE_ALLOC_MALLOC, or CACHE_ALLOC_HUGE for huge pages,
+  *                    falls back to CACHE_ALLOC_MALLOC if not available.
+  * @retval     pointer to the cache instance, NULL if the geometry is not
+  *             supported, see cache_check_geometry().
   */
-cache_t* create_cache(int sets_num, int ways_assoc, int line_size)
+cache_t* create_cache(int sets_num, int ways_assoc, int line_size, cache_alloc_t alloc)
 {
+    if(cache_check_geometry(sets_num, ways_assoc, line_size) < 0)
+    {
+        return NULL;
+    }
     cache_t *cache = (cache_t*)malloc(sizeof(cache_t));
-    cache->bytes_num_bits = log2(line_size);
-    cache->sets_num_bits = log2(sets_num);
+    if(cache == NULL)
+    {
+        return NULL;
+    }
+    cache->bytes_num_bits = LOG2(line_size);
+    cache->sets_num_bits = LOG2(sets_num);
     cache->tags_num_bits = MEMORY_ADDRESS - cache->sets_num_bits - cache->bytes_num_bits;
     cache->ways_assoc = ways_assoc;
-    cache->LRU_num_bits = log2(ways_assoc);
+    //the LRU order of a fully-associative cache is kept by cache->fa:
+    cache->LRU_num_bits = (sets_num == 1) ? 0 : LOG2(ways_assoc);
 
     cache->V_BIT = (uint16_t)(cache->tags_num_bits);
     
@@ -102,11 +276,13 @@ cache_t* create_cache(int sets_num, int ways_assoc, int line_size)
     // cache->D_BIT = BIT(cache->D_BIT);
     int i;
     //Create LRU_line_mask:
+    cache->LRU_line_mask = 0;
     for(i = 0; i < cache->LRU_num_bits; i++)
     {
         cache->LRU_line_mask |= BIT(i);
     }
     cache->LRU_line_mask = cache->LRU_line_mask << (1 + 1+ cache->tags_num_bits);
+    cache->tag_line_mask = ~(cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT));
     //create bytes offset mask:
     cache->bytes_mask = 0;
     for(i = 0; i < cache->bytes_num_bits; i++)
@@ -123,7 +299,7 @@ cache_t* create_cache(int sets_num, int ways_assoc, int line_size)
 
     //create tag_mask for extract tag from address:
     cache->tag_mask = 0;
-    for(i = 0; i < cache->sets_num_bits; i++)
+    for(i = 0; i < cache->tags_num_bits; i++)
     {
         cache->tag_mask |= BIT(i);
     }
@@ -131,12 +307,228 @@ cache_t* create_cache(int sets_num, int ways_assoc, int line_size)
     // printf("> Log from cache.c:\n");
     // print_cache(*cache);
 
-    //create sets in cache:
-    cache->sets = (set_t*)malloc(sets_num * sizeof(set_t));
+    //create sets in cache, all sets start empty (lines == NULL):
+    cache->alloc = CACHE_ALLOC_MALLOC;
+    cache->arena = NULL;
+    cache->arena_size = 0;
+    if(alloc == CACHE_ALLOC_HUGE && cache_arena_create(cache) == SUCCESS)
+    {
+        //a new mapping reads as zero, sets stay untouched until used:
+        cache->sets = (set_t*)cache->arena;
+    }
+    else
+    {
+        cache->sets = (set_t*)calloc(sets_num, sizeof(set_t));
+    }
+    cache->write_policy = WRITE_BACK;
+    cache->write_allocate = 1;
+    cache->victim = NULL;
+    cache->mshr = NULL;
+    cache->wbuf = NULL;
+    cache->misstrace = NULL;
+    cache->misstrace_read = READ_DATA;
+    cache->timing = NULL;
+    cache->latency = 0;
+    cache->directory = NULL;
+    cache->core = 0;
+    cache->sector_bits = cache->bytes_num_bits;
+    cache->sectors_num = 1;
+    cache->l2_read_bytes = 0;
+    cache->l2_write_bytes = 0;
+    cache->usage = NULL;
+    cache->usage_shift = 0;
+    cache->usage_hist = NULL;
+    cache->fa = NULL;
+    if(sets_num == 1)
+    {
+        cache->fa = fa_create(ways_assoc);
+        if(cache->fa == NULL)
+        {
+            destroy_cache(cache);
+            return NULL;
+        }
+    }
     
     return cache;
 }
 
+/**
+  * @brief      Release a cache created by create_cache(): its sets, and the
+  *             victim buffer, MSHR and write buffer attached to it.
+  *             The latency model and the directory are shared, they are
+  *             released by their owner.
+  * @param      cache: pointer to the cache instance, NULL is ignored.
+  * @retval     None.
+  */
+void destroy_cache(cache_t* cache)
+{
+    if(cache == NULL)
+    {
+        return;
+    }
+    cache_L1_clear(cache);
+    if(cache->arena != NULL)
+    {
+        munmap(cache->arena, cache->arena_size);
+    }
+    else
+    {
+        free(cache->sets);
+    }
+    fa_destroy(cache->fa);
+    free(cache->usage);
+    free(cache->usage_hist);
+    victim_destroy(cache->victim);
+    mshr_destroy(cache->mshr);
+    writebuf_destroy(cache->wbuf);
+    free(cache);
+}
+
+/**
+  * @brief      Write all the storage of a cache from the calling thread, so
+  *             its pages are placed on the NUMA node of this thread (first
+  *             touch). Call it from the thread owning the cache, before
+  *             the first access. Nothing to do for CACHE_ALLOC_MALLOC, its
+  *             sets are allocated by the first access.
+  * @param      cache: pointer to the cache instance.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cache_first_touch(cache_t* cache)
+{
+    size_t i;
+    if(cache == NULL)
+    {
+        return ERROR;
+    }
+    if(cache->arena == NULL)
+    {
+        return SUCCESS;
+    }
+    //one write per small page, the content is unchanged:
+    volatile uint8_t *arena = (volatile uint8_t*)cache->arena;
+    for(i = 0; i < cache->arena_size; i += 4 * K)
+    {
+        arena[i] = arena[i];
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Configure how the cache handles writes.
+  * @param      cache: pointer to the cache instance.
+  * @param      policy: WRITE_BACK, WRITE_THROUGH or WRITE_ONCE.
+  * @param      write_allocate: 1 to fill the line on a write miss,
+  *                             0 to send the write to L2 only.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cache_set_write_policy(cache_t* cache, write_policy_t policy, int write_allocate)
+{
+    if(cache == NULL || policy < WRITE_BACK || policy > WRITE_ONCE)
+    {
+        printf("Error: Invalid write policy.\n");
+        return ERROR;
+    }
+    cache->write_policy = policy;
+    cache->write_allocate = write_allocate ? 1 : 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Write the transactions of the cache to L2 in a miss trace,
+  *             see misstrace.c.
+  * @param      cache: pointer to the cache instance.
+  * @param      mt: miss trace writer, NULL to stop.
+  * @param      read_command: READ_DATA for a data cache, INSTRUCTION_FETCH
+  *                           for an instruction cache.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cache_set_misstrace(cache_t* cache, misstrace_t* mt, int read_command)
+{
+    if(cache == NULL || (read_command != READ_DATA && read_command != INSTRUCTION_FETCH))
+    {
+        printf("Error: Invalid miss trace.\n");
+        return ERROR;
+    }
+    cache->misstrace = mt;
+    cache->misstrace_read = read_command;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Cut the lines of an empty cache in sectors. A sector is
+  *             read from L2 on its first access, and written back only
+  *             if it is dirty.
+  * @param      cache: pointer to the cache instance, no line filled yet,
+  *                    no victim buffer.
+  * @param      sector_size: bytes of a sector, a power of 2, at least
+  *                          line size / CACHE_MAX_SECTORS. 0 or the line
+  *                          size for whole lines.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cache_set_sectors(cache_t* cache, int sector_size)
+{
+    int line_size;
+    if(cache == NULL)
+    {
+        printf("Error: Invalid sector size.\n");
+        return ERROR;
+    }
+    line_size = cache->bytes_mask + 1;
+    if(sector_size == 0)
+    {
+        sector_size = line_size;
+    }
+    if(!IS_POWER_OF_2(sector_size) || sector_size > line_size ||
+       line_size / sector_size > CACHE_MAX_SECTORS || cache->victim != NULL)
+    {
+        printf("Error: Invalid sector size %d for %d-byte lines.\n", sector_size, line_size);
+        return ERROR;
+    }
+    cache->sector_bits = LOG2(sector_size);
+    cache->sectors_num = line_size / sector_size;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Record the bytes used of each line, see cache_L1_use().
+  *             A line of more than CACHE_USAGE_PARTS bytes is cut in
+  *             CACHE_USAGE_PARTS parts, a part is used if any of its bytes is.
+  * @param      cache: pointer to the cache instance, no line filled yet.
+  * @param      enable: 1 to record, 0 to stop.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cache_set_usage(cache_t* cache, int enable)
+{
+    if(cache == NULL)
+    {
+        printf("Error: Cache is null.\n");
+        return ERROR;
+    }
+    free(cache->usage);
+    free(cache->usage_hist);
+    cache->usage = NULL;
+    cache->usage_hist = NULL;
+    if(!enable)
+    {
+        return SUCCESS;
+    }
+    //one bitmap per way of every set, no allocation on the access path:
+    cache->usage = (uint64_t*)calloc((size_t)cache->ways_assoc << cache->sets_num_bits, sizeof(uint64_t));
+    cache->usage_hist = (uint64_t*)calloc(CACHE_USAGE_BINS, sizeof(uint64_t));
+    if(cache->usage == NULL || cache->usage_hist == NULL)
+    {
+        printf("Error: Cannot create the line usage of the cache.\n");
+        free(cache->usage);
+        free(cache->usage_hist);
+        cache->usage = NULL;
+        cache->usage_hist = NULL;
+        return ERROR;
+    }
+    cache->usage_shift = (cache->bytes_num_bits > LOG2(CACHE_USAGE_PARTS)) ?
+                            cache->bytes_num_bits - LOG2(CACHE_USAGE_PARTS) : 0;
+    return SUCCESS;
+}
+
 /**
   * @attention  RESTRICTED API
   * @brief      Create an array of lines and return it for use.
@@ -206,534 +598,1258 @@ uint32_t get_bytes_offset(cache_t cache, uint32_t address)
   * @param      tag_array: tag array of a line
   * @retval     LRU bits from the line.
   */
-uint16_t get_line_LRU(cache_t cache, uint16_t tag_arr)
+uint16_t get_line_LRU(cache_t cache, uint32_t tag_arr)
 {
-    uint16_t lru = tag_arr & cache.LRU_line_mask;
+    uint32_t lru = tag_arr & cache.LRU_line_mask;
     lru = lru >> (1 + 1 + cache.tags_num_bits);
-    return lru;
+    return (uint16_t)lru;
+}
+
+/**
+  * @brief      rebuild the line address from the tag array of a line
+  * @param      cache: cache instance
+  * @param      tag_array: tag array of a line
+  * @param      set: index of the set holding the line
+  * @retval     address of the first byte of the line.
+  */
+uint32_t get_line_address(cache_t cache, uint32_t tag_arr, uint32_t set)
+{
+    uint32_t tag = tag_arr & (BIT(cache.tags_num_bits) - 1);
+    return (tag << (cache.sets_num_bits + cache.bytes_num_bits)) |
+           (set << cache.bytes_num_bits);
 }
 
 
 /* Cache request subfunctions ************************************************/
 
 /**
-  * @brief      Read request to L1 cache.
+  * @attention  RESTRICTED API
+  * @brief      Get the lines of a set, create the set on the first access.
+  *             A new set has all lines invalid.
   * @param      cache: pointer to cache instance.
-  * @param      address: byte address
-  * @param      data: pointer to return data.
-  *             Note: this is actually the return data to deliver to CPU.
-  * @retval     status of the read request:
-  *                 @arg    return_t
+  * @param      addr_set: set index.
+  * @retval     pointer to the lines array, NULL if failed.
   */
-int cache_L1_read(cache_t* cache, uint32_t address, uint8_t*data)
+static line_t* cache_L1_get_set(cache_t* cache, uint32_t addr_set)
 {
-    //int j;
-    
-    
-    // print_cache(*cache);
-    return_t ret = 0;
-    //Split tag, set, bytes offset of an address:
-    uint32_t addr_bytes_offset = get_bytes_offset(*cache, address);
-    uint32_t addr_set = get_set(*cache, address);
-    uint32_t addr_tag = get_tag(*cache, address);
-
-    if(!cache)
+    line_t *lines = (cache->sets)[addr_set].lines;
+    if(lines == NULL && cache->arena != NULL)
     {
-        //return error
-        printf("Error: Invalid cache access\n");
-        return ERROR;
+        //fixed place in the arena: lines after the sets, data after the lines.
+        int i;
+        size_t size = cache->bytes_mask + 1;
+        size_t first = (size_t)addr_set * cache->ways_assoc;
+        uint8_t *arena = (uint8_t*)cache->arena + cache_arena_sets_size(cache);
+        uint8_t *data = arena + cache_arena_lines_size(cache);
+        lines = (line_t*)arena + first;
+        for(i = 0; i < cache->ways_assoc; i++)
+        {
+            lines[i].tag_array = 0;
+            lines[i].flags = 0;
+            lines[i].sectors_valid = 0;
+            lines[i].sectors_dirty = 0;
+            lines[i].data = data + (first + i) * size;
+        }
+        (cache->sets)[addr_set].lines = lines;
     }
-
-    if((cache->sets)[addr_set].lines == NULL)
+    else if(lines == NULL)
     {
-        //there is no line in set:
-        //read miss: ret |= READ_MISS
-        //  - Create set first: ep. create [ways_assoc] lines append to set
-        //  - Call cache L2 read to get 1 line(ret |= READ_L2), place it in set
-        //      valid = 1, update tag, fake data = 64*DUMMY_BYTES.
-        
-        ret |= BIT(READ_MISS);
         int i;
-        // for(i = 0; i < cache->ways_assoc; i++)
-        // {
-        //     printf("lru:x");
-        // }
-        // printf("\n");
-        //Create the set: 
-        
-        line_t *lines = create_set(cache->ways_assoc);
+        int size = cache->bytes_mask + 1;//should be 64
+        lines = create_set(cache->ways_assoc);
         if(lines == NULL)
         {
             printf("Error: Cannot create set of %d line\n", cache->ways_assoc);
-            return ERROR;
+            return NULL;
         }
-        int size = pow(2, cache->bytes_num_bits);//should be 64
         for(i = 0; i < cache->ways_assoc; i++)
         {
             lines[i].tag_array = 0;
+            lines[i].flags = 0;
+            lines[i].sectors_valid = 0;
+            lines[i].sectors_dirty = 0;
             lines[i].data = create_line(size);
         }
         (cache->sets)[addr_set].lines = lines;
-        //Now the set is not null, but it all empty(all valid == 0, no data in it)
-        
-        uint8_t *line_data = create_line(size);
-        if(cache_L2_read(cache, address, line_data) < 0)
-        {
-            printf("Error: Read L2 error\n");
-            return ERROR;
-        }
+    }
+    return lines;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Bit of the sector of an address in line_t.sectors_valid and
+  *             line_t.sectors_dirty, 1 if the cache is not sectored.
+  */
+static inline uint32_t cache_sector_bit(cache_t* cache, uint32_t address)
+{
+    return 1U << ((address & cache->bytes_mask) >> cache->sector_bits);
+}
 
-        ret |= BIT(READ_L2);
-        lines[0].tag_array = 0;
-        lines[0].tag_array |= BIT(cache->V_BIT); //valid = 1;
+/**
+  * @attention  RESTRICTED API
+  * @brief      Check that the sector of an address is valid in a present line.
+  * @retval     non zero if valid, always if the cache is not sectored.
+  */
+static inline int cache_L1_sector_valid(cache_t* cache, line_t* line, uint32_t address)
+{
+    return cache->sectors_num == 1 || (line->sectors_valid & cache_sector_bit(cache, address));
+}
 
-        lines[0].tag_array += addr_tag;//update tag
-        for(i = 0; i < size; i++)
+/**
+  * @attention  RESTRICTED API
+  * @brief      Write a dirty line back to L2: the whole line, or only its
+  *             dirty sectors in a sectored cache.
+  * @param      cache: pointer to cache instance.
+  * @param      line: the dirty line.
+  * @param      line_addr: address of the first byte of the line.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int cache_L1_writeback(cache_t* cache, line_t* line, uint32_t line_addr)
+{
+    int i;
+    if(cache->sectors_num == 1)
+    {
+        return cache_L2_write(cache, line_addr, line->data);
+    }
+    for(i = 0; i < cache->sectors_num; i++)
+    {
+        uint32_t offset = (uint32_t)i << cache->sector_bits;
+        if((line->sectors_dirty & (1U << i)) &&
+           cache_L2_write(cache, line_addr + offset, line->data + offset) < 0)
         {
-            (lines[0].data)[i] = line_data[i];// copy from tmp_line to the 1st line.
+            return ERROR;
         }
-        //Now return the byte:
-        *data = (lines[0].data)[addr_bytes_offset];
-        //finish a read miss.
-        return ret;
     }
-    else{
-        //There are already some lines in set
-        //Or can be no line(all valid == 0).
-        //  - Use for loop to traverse the lines:
-        //      count the number of valids;
-        //      if valid :
-        //              + if line_tag == addr_tag: ret |= READ_HIT; get *data =...
-        //              + else: continue to search
-        //  - exit the loop: if still no where to get data ret |= READ_MISS
-        //              + if count_valids < ways_assoc, call cache_L2_read() to get line, ret |= READ_L2
-        //                  place it in the first available space in line.
-        //              + else count_valids == ways_assoc, -> need to replace LRU call index
-        //                  if lines[LRU] is not dirty -> no need to evict, call cache_L2_read(), ret |= READ_L2
-        //                      in place the line in the LRU index.
-        //                  else: the lines[LRU] is dirty, call cache_L2_write() to evict, ret |= WRITE_L2;
-        //                      call cache_L2_read() to get the line, ret |= READ_L2.
-        int i, count = 0, hit = 0;
-        line_t *lines = (cache->sets)[addr_set].lines;
-        // for(j = 0; j < 4; j++)
-        // {
-        //     if(lines[j].tag_array & BIT(cache->V_BIT))
-        //         printf("lru:%d", get_line_LRU(*cache, lines[j].tag_array));
-        //     else{
-        //         printf("lru:x");
-        //     }
-        // }
-        // printf("\n");
-        for(i = 0; i < cache->ways_assoc; i++)
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Search the valid line holding a tag in a set.
+  * @param      cache: pointer to cache instance.
+  * @param      lines: lines of the set.
+  * @param      addr_tag: tag of the address.
+  * @param      ways: associativity, a constant in cache_L1_lookup().
+  * @retval     index of the way if present, otherwise FALSE.
+  */
+static inline int cache_L1_lookup_ways(cache_t* cache, line_t* lines, uint32_t addr_tag, int ways)
+{
+    int i;
+    uint32_t valid = BIT(cache->V_BIT);
+    for(i = 0; i < ways; i++)
+    {
+        if((lines[i].tag_array & valid) &&
+           (lines[i].tag_array & cache->tag_line_mask) == addr_tag)
         {
-            if(lines[i].tag_array & BIT(cache->V_BIT))
-            {
-                // printf("Attemp hit\n");
-                count++;
-                uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-                tag_line_mask = ~tag_line_mask;
-                uint16_t line_tag = lines[i].tag_array & tag_line_mask;
-
-                if(line_tag == addr_tag){
-                    ret |= BIT(READ_HIT);
-                    hit = 1;
-                    *data = (lines[i].data)[addr_bytes_offset];
-                    uint16_t accessed_lru = get_line_LRU(*cache, lines[i].tag_array);
-                    if(update_line_LRU(*cache, lines, accessed_lru, ACCESS) < 0)
-                    {
-                        printf("Error: Cannot update LRU with addr=%x\n", address);
-                        return ERROR;
-                    }
-                    return ret;
-                }
-            }
+            return i;
         }
-        // printf("count: %d\n", count);
-        if(hit == 0)
-        {
-            ret |= BIT(READ_MISS);
-            if(count < cache->ways_assoc)
-            {
-                //still have space to fill in.
-                int index =0;
-                for(i = 0; i < cache->ways_assoc; i++)
-                {
-                    //if()
-                    if(!(lines[i].tag_array & BIT(cache->V_BIT)))
-                    {
-                        //this index is avaiable
-                        index = i;
-                        break;
-                    }
-                }
+    }
+    return FALSE;
+}
 
-                //Update old LRU bit of old lines, before adding new line
-                if(update_line_LRU(*cache, lines,0, NEW_LINE) < 0)
-                {
-                    printf("Error: Cannot update LRU with addr=%x.\n", address);
-                    return ERROR;
-                }
-                // int tmp_lru = get_line_LRU(*cache, lines[0].tag_array);
-                // printf("0 lru=%d\n", tmp_lru);
-                //Get a line from L2 cache:
-                int size = pow(2, cache->bytes_num_bits);//should be 64
-                uint8_t* line_data = create_line(size);
-                if(cache_L2_read(cache, address, line_data) < 0)
-                {
-                    printf("Error: Read L2 error\n");
-                    return ERROR;
-                }
-                ret |= BIT(READ_L2);
-                lines[index].tag_array |= BIT(cache->V_BIT); //valid = 1;
-                uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-                lines[index].tag_array &= tag_line_mask;// clear old tag
-                lines[index].tag_array += addr_tag;//update tag
-                for(i = 0; i < size; i++)
-                {
-                    (lines[index].data)[i] = line_data[i];// copy from tmp_line to the 1st line.
-                }
-                //Now return the byte:
-                *data = (lines[index].data)[addr_bytes_offset];
-                return ret;
-            }
-            else{
-                //Now the count == ways_assoc, mean that the set is full of lines,
-                //Now we need to replace one of the line in the set.
+static int cache_L1_lookup(cache_t* cache, line_t* lines, uint32_t addr_tag)
+{
+    if(cache->fa != NULL)
+    {
+        //fully associative: the way of the tag, valid once filled.
+        int i = fa_lookup(cache->fa, addr_tag);
+        return (i != FALSE && (lines[i].tag_array & BIT(cache->V_BIT))) ? i : FALSE;
+    }
+    //constant associativity: the usual geometries get an unrolled search.
+    switch(cache->ways_assoc)
+    {
+        case 1: return cache_L1_lookup_ways(cache, lines, addr_tag, 1);
+        case 2: return cache_L1_lookup_ways(cache, lines, addr_tag, 2);
+        case 4: return cache_L1_lookup_ways(cache, lines, addr_tag, 4);
+        case 8: return cache_L1_lookup_ways(cache, lines, addr_tag, 8);
+        default: return cache_L1_lookup_ways(cache, lines, addr_tag, cache->ways_assoc);
+    }
+}
 
-                //Update old LRU bit of old lines, before adding new line
-                int index = cal_LRU(*cache, lines);
-                uint16_t accessed_lru = get_line_LRU(*cache, lines[index].tag_array);
-                if(update_line_LRU(*cache, lines, accessed_lru, ACCESS) < 0)
-                {
-                    printf("Error: Cannot update LRU with addr=%x.\n", address);
-                    return ERROR;
-                }
-                // printf("lru index: %d\n", index);
-                if(!(lines[index].tag_array & BIT(cache->D_BIT)))
-                {
-                    //Line is not dirty:
-                    //Get a line from L2 cache:
-                    int size = pow(2, cache->bytes_num_bits);//should be 64
-                    uint8_t *line_data = create_line(size);
-                    if(cache_L2_read(cache, address, line_data) < 0)
-                    {
-                        printf("Error: Read L2 error\n");
-                        return ERROR;
-                    }
-                    ret |= BIT(READ_L2);
-                    lines[index].tag_array |= BIT(cache->V_BIT); //valid = 1;
-                    uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-                    lines[index].tag_array &= tag_line_mask;// clear old tag
-                    lines[index].tag_array += addr_tag;//update tag
-                    for(i = 0; i < size; i++)
-                    {
-                        (lines[index].data)[i] = line_data[i];// copy from tmp_line to the 1st line.
-                    }
-                }
-                else{
-                    //the line is dirty, now we need to evict it first:
-                    if(cache_L2_write(cache, address, lines[index].data) < 0)
-                    {
-                        printf("Error: Cannot evict line has addr=%x\n", address);
-                        return ERROR;
-                    }
-                    ret |= BIT(WRITE_L2);
-
-                    //Now we read new line
-                    //Get a line from L2 cache:
-                    int size = pow(2, cache->bytes_num_bits);//should be 64
-                    uint8_t *line_data =create_line(size);
-                    if(cache_L2_read(cache, address, line_data) < 0)
-                    {
-                        printf("Error: Read L2 error\n");
-                        return ERROR;
-                    }
-                    ret |= BIT(READ_L2);
-                    lines[index].tag_array |= BIT(cache->V_BIT); //valid = 1;
-                    uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-                    lines[index].tag_array &= tag_line_mask;// clear old tag
-                    lines[index].tag_array += addr_tag;//update tag
-                    for(i = 0; i < size; i++)
-                    {
-                        (lines[index].data)[i] = line_data[i];// copy from tmp_line to the 1st line.
-                    }
-                    //Now return the byte:
-                    *data = (lines[index].data)[addr_bytes_offset];
-                    return ret;
-                }
-            }
+/**
+  * @attention  RESTRICTED API
+  * @brief      Make a present line the most recently used of its set.
+  * @param      cache: pointer to cache instance.
+  * @param      lines: lines of the set.
+  * @param      index: way of the line.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static inline int cache_L1_touch(cache_t* cache, line_t* lines, int index)
+{
+    if(cache->fa != NULL)
+    {
+        fa_touch(cache->fa, index);
+        return SUCCESS;
+    }
+    uint16_t accessed_lru = get_line_LRU(*cache, lines[index].tag_array);
+    return update_line_LRU(*cache, lines, accessed_lru, ACCESS);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Mark the byte of a read or write as used in its line.
+  * @param      cache: pointer to cache instance.
+  * @param      addr_set: set index.
+  * @param      index: way of the line.
+  * @param      address: byte address.
+  * @retval     None.
+  */
+static inline void cache_L1_use(cache_t* cache, uint32_t addr_set, int index, uint32_t address)
+{
+    if(cache->usage != NULL)
+    {
+        cache->usage[((size_t)addr_set * cache->ways_assoc) + index] |=
+            1ULL << (get_bytes_offset(*cache, address) >> cache->usage_shift);
+    }
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Count the parts used of a line leaving its way, and clear
+  *             them for the next line.
+  * @param      cache: pointer to cache instance.
+  * @param      addr_set: set index.
+  * @param      index: way of the line.
+  * @param      warm: 1 for functional warming, the line is not counted.
+  * @retval     None.
+  */
+static inline void cache_L1_retire(cache_t* cache, uint32_t addr_set, int index, int warm)
+{
+    if(cache->usage != NULL)
+    {
+        uint64_t *used = &cache->usage[((size_t)addr_set * cache->ways_assoc) + index];
+        if(!warm)
+        {
+            cache->usage_hist[__builtin_popcountll(*used)]++;
+        }
+        *used = 0;
+    }
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Choose the way for a new line and update LRU bits.
+  *             The first invalid way is used if any, otherwise the LRU way
+  *             is replaced: it goes to the victim buffer if attached,
+  *             else a dirty line is written back to L2. Its MSHR entries
+  *             are dropped.
+  *             A fully-associative cache takes the way from cache->fa,
+  *             where the new line is placed as MRU at once.
+  * @param      cache: pointer to cache instance.
+  * @param      lines: lines of the set.
+  * @param      addr_set: set index.
+  * @param      address: byte address of the new line.
+  * @param      index: return the chosen way.
+  * @param      warm: 1 for functional warming, the write back is not sent
+  *                   to L2 (write buffer, latency), only reported.
+  * @retval     status bits of the replacement (WRITE_L2, PREFETCH_UNUSED).
+  *             ERROR if failed.
+  */
+static int cache_L1_replace(cache_t* cache, line_t* lines, uint32_t addr_set,
+                                uint32_t address, int* index, int warm)
+{
+    return_t ret = 0;
+    int i;
+    if(cache->fa != NULL)
+    {
+        //a free way, else the LRU one, in O(1):
+        i = fa_select(cache->fa);
+        fa_remove(cache->fa, i);
+        if(fa_insert(cache->fa, i, get_tag(*cache, address)) < 0)
+        {
+            return ERROR;
+        }
+        if(!(lines[i].tag_array & BIT(cache->V_BIT)))
+        {
+            lines[i].flags = 0;
+            *index = i;
+            return ret;
+        }
+    }
+    else
+    {
+        for(i = 0; i < cache->ways_assoc; i++)
+        {
+            if(!(lines[i].tag_array & BIT(cache->V_BIT)))
+            {
+                //still have space to fill in.
+                //Update old LRU bit of old lines, before adding new line
+                if(update_line_LRU(*cache, lines, 0, NEW_LINE) < 0)
+                {
+                    printf("Error: Cannot update LRU with addr=%x.\n", address);
+                    return ERROR;
+                }
+                lines[i].flags = 0;
+                *index = i;
+                return ret;
+            }
+        }
+        //Now the set is full of lines, replace the LRU one.
+        i = cal_LRU(*cache, lines);
+        if(cache_L1_touch(cache, lines, i) < 0)
+        {
+            printf("Error: Cannot update LRU with addr=%x.\n", address);
+            return ERROR;
+        }
+    }
+    if(lines[i].flags & LINE_PREFETCHED)
+    {
+        //victim was prefetched but never used:
+        ret |= BIT(PREFETCH_UNUSED);
+    }
+    cache_L1_retire(cache, addr_set, i, warm);
+    lines[i].flags = 0;
+    uint32_t victim_addr = get_line_address(*cache, lines[i].tag_array, addr_set);
+    if(cache->mshr != NULL)
+    {
+        //the fill of the old line is over, a new miss to it reads L2.
+        mshr_release(cache->mshr, victim_addr, ~cache->bytes_mask);
+    }
+    if(cache->victim != NULL)
+    {
+        //move the line to the victim buffer, write back what it pushes out:
+        victim_t *vc = cache->victim;
+        int slot = victim_select(vc);
+        if(vc->lines[slot] != VICTIM_INVALID_LINE && vc->dirty[slot])
+        {
+            if(!warm && cache_L2_write(cache, vc->lines[slot], VICTIM_DATA(vc, slot)) < 0)
+            {
+                printf("Error: Cannot evict line has addr=%x\n", vc->lines[slot]);
+                return ERROR;
+            }
+            ret |= BIT(WRITE_L2);
+        }
+        victim_place(vc, slot, victim_addr,
+                        lines[i].data, lines[i].tag_array & BIT(cache->D_BIT));
+    }
+    else if(lines[i].tag_array & BIT(cache->D_BIT))
+    {
+        //the line is dirty, now we need to evict it first:
+        if(!warm && cache_L1_writeback(cache, &lines[i], victim_addr) < 0)
+        {
+            printf("Error: Cannot evict line has addr=%x\n", victim_addr);
+            return ERROR;
+        }
+        ret |= BIT(WRITE_L2);
+    }
+    //the way holds no line until the fill, a snoop must not find the old one.
+    lines[i].tag_array &= ~BIT(cache->V_BIT);
+    if(cache->directory != NULL &&
+       directory_evict(cache->directory, cache, victim_addr) < 0)
+    {
+        return ERROR;
+    }
+    *index = i;
+    return ret;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Bring a line into the way chosen by cache_L1_replace().
+  *             A line read from L2 is clean, it does not keep the dirty
+  *             bit of the line it replaces.
+  *             The line comes from the victim buffer if present there,
+  *             otherwise it is read from L2, unless the miss is merged
+  *             into an outstanding one by the MSHR: then it costs no L2
+  *             read and adds no latency to the L1 hit of the access.
+  *             With a directory, the L2 read also snoops the other cores:
+  *             READ_L2_OWN invalidates their copies, other reads get the
+  *             line in S state if another core keeps it.
+  *             In a sectored cache only the sector of the address is read,
+  *             into the new line, or into the line still valid after a
+  *             SECTOR_MISS.
+  * @param      cache: pointer to cache instance.
+  * @param      line: the way to fill.
+  * @param      address: byte address.
+  * @param      read_type: READ_L2 or READ_L2_OWN, reported when L2 is read.
+  * @retval     status bits of the fill. ERROR if failed.
+  */
+static int cache_L1_fill(cache_t* cache, line_t* line, uint32_t address, return_t read_type)
+{
+    return_t ret = 0;
+    uint32_t addr_tag = get_tag(*cache, address);
+    uint32_t line_addr = address & ~cache->bytes_mask;
+    uint32_t fill_addr = address & ~(uint32_t)((1U << cache->sector_bits) - 1);
+    int slot = FALSE, dirty = 0, shared = 0;
+    if(cache->victim != NULL)
+    {
+        cache->victim->probes++;
+        slot = victim_lookup(cache->victim, line_addr);
+    }
+    if(slot != FALSE)
+    {
+        //swap back from the victim buffer:
+        victim_t *vc = cache->victim;
+        memcpy(line->data, VICTIM_DATA(vc, slot), vc->line_size);
+        dirty = vc->dirty[slot];
+        victim_invalidate(vc, slot);
+        vc->hits++;
+        ret |= BIT(VICTIM_HIT);
+        if(cache->timing != NULL)
+        {
+            cache->latency += cache->timing->l1_hit;
+        }
+    }
+    else
+    {
+        //a miss merged into an outstanding one issues no L2 read:
+        int merged = (cache->mshr != NULL && mshr_lookup(cache->mshr, fill_addr) != FALSE);
+        if(merged)
+        {
+            memset(line->data + (fill_addr & cache->bytes_mask), DUMMY_BYTE, 1U << cache->sector_bits);
+            ret |= BIT(MSHR_MERGE);
+        }
+        else
+        {
+            if(cache->wbuf != NULL)
+            {
+                //a pending write of the line must reach L2 before it is read.
+                writebuf_flush_line(cache->wbuf, address);
+            }
+            if(cache_L2_read(cache, address, line->data + (fill_addr & cache->bytes_mask)) < 0)
+            {
+                printf("Error: Read L2 error\n");
+                return ERROR;
+            }
+            if(cache->mshr != NULL)
+            {
+                mshr_allocate(cache->mshr, fill_addr);
+            }
+            if(cache->misstrace != NULL &&
+               misstrace_write(cache->misstrace,
+                               (read_type == READ_L2_OWN) ? WRITE_DATA : cache->misstrace_read,
+                               (read_type == READ_L2_OWN) ? MISSTRACE_OWN : MISSTRACE_READ,
+                               fill_addr, cache->core) < 0)
+            {
+                return ERROR;
+            }
+            ret |= BIT(read_type);
+        }
+        if(cache->directory != NULL)
+        {
+            //the directory learns the copy even when the miss is merged.
+            int status = directory_read(cache->directory, cache, address,
+                                        read_type == READ_L2_OWN);
+            if(status < 0)
+            {
+                return ERROR;
+            }
+            shared = status & DIR_SHARED;
+            if(cache->timing != NULL && !merged)
+            {
+                //a modified copy in another core is written back first:
+                cache->latency += (status & DIR_L2_HIT) ? cache->timing->l2_hit :
+                                                          cache->timing->memory;
+                cache->latency += (status & DIR_FLUSH) ? cache->timing->writeback : 0;
+            }
+        }
+        else if(cache->timing != NULL && !merged)
+        {
+            cache->latency += timing_l2_read(cache->timing, address);
+        }
+    }
+    if(line->tag_array & BIT(cache->V_BIT))
+    {
+        //sector miss, the line keeps its tag and its other sectors:
+        line->sectors_valid |= cache_sector_bit(cache, address);
+        return ret;
+    }
+    line->tag_array &= cache->LRU_line_mask;// clear old tag, V, D
+    line->tag_array |= BIT(cache->V_BIT); //valid = 1;
+    line->tag_array += addr_tag;//update tag
+    line->sectors_valid = cache_sector_bit(cache, address);
+    line->sectors_dirty = 0;
+    if(dirty)
+    {
+        line->tag_array |= BIT(cache->D_BIT);
+        line->sectors_dirty = line->sectors_valid;
+    }
+    if(shared)
+    {
+        line->flags |= LINE_SHARED;
+    }
+    return ret;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Functional warming version of cache_L1_fill(): only the tag,
+  *             V, D and sector bits of the line are set. The line still comes back
+  *             from the victim buffer, and the directory/L2 bitmap of the
+  *             latency model still learn the read, so the state of the
+  *             hierarchy is the same as after a detailed fill.
+  *             No data, no MSHR, no latency and no counter of the victim
+  *             buffer.
+  * @param      cache: pointer to cache instance.
+  * @param      line: the way to fill.
+  * @param      address: byte address.
+  * @param      exclusive: 1 to read for ownership (write allocate).
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int cache_L1_warm_fill(cache_t* cache, line_t* line, uint32_t address, int exclusive)
+{
+    uint32_t line_addr = address & ~cache->bytes_mask;
+    int slot = FALSE, dirty = 0, shared = 0;
+    if(cache->victim != NULL)
+    {
+        slot = victim_lookup(cache->victim, line_addr);
+    }
+    if(slot != FALSE)
+    {
+        dirty = cache->victim->dirty[slot];
+        victim_invalidate(cache->victim, slot);
+    }
+    else if(cache->directory != NULL)
+    {
+        int status = directory_read(cache->directory, cache, address, exclusive);
+        if(status < 0)
+        {
+            return ERROR;
+        }
+        shared = status & DIR_SHARED;
+    }
+    else if(cache->timing != NULL)
+    {
+        timing_l2_read(cache->timing, address);
+    }
+    if(line->tag_array & BIT(cache->V_BIT))
+    {
+        //sector miss:
+        line->sectors_valid |= cache_sector_bit(cache, address);
+        return SUCCESS;
+    }
+    line->tag_array &= cache->LRU_line_mask;// clear old tag, V, D
+    line->tag_array |= BIT(cache->V_BIT); //valid = 1;
+    line->tag_array += get_tag(*cache, address);//update tag
+    line->sectors_valid = cache_sector_bit(cache, address);
+    line->sectors_dirty = 0;
+    if(dirty)
+    {
+        line->tag_array |= BIT(cache->D_BIT);
+        line->sectors_dirty = line->sectors_valid;
+    }
+    if(shared)
+    {
+        line->flags |= LINE_SHARED;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Write a byte into a present line, following the write policy.
+  *             A line in S state is upgraded first (other copies invalidated).
+  * @param      cache: pointer to cache instance.
+  * @param      line: the line holding the address.
+  * @param      address: byte address.
+  * @param      data: byte value.
+  * @param      warm: 1 for functional warming, only the state of the line
+  *                   changes: no data, no write-through to L2.
+  * @retval     status bits of the write (WRITE_L2_THROUGH). ERROR if failed.
+  */
+static int cache_L1_store(cache_t* cache, line_t* line, uint32_t address, uint8_t data, int warm)
+{
+    return_t ret = 0;
+    if(line->flags & LINE_SHARED)
+    {
+        if(directory_upgrade(cache->directory, cache, address) < 0)
+        {
+            return ERROR;
+        }
+        line->flags &= ~LINE_SHARED;
+        ret |= BIT(UPGRADE_L2);
+    }
+    if(!warm)
+    {
+        (line->data)[get_bytes_offset(*cache, address)] = data;
+    }
+    if(cache->write_policy == WRITE_THROUGH ||
+       (cache->write_policy == WRITE_ONCE && !(line->flags & LINE_WRITTEN) &&
+        !(line->tag_array & BIT(cache->D_BIT))))
+    {
+        //write-through, the line stays clean:
+        if(!warm && cache_L2_write_through(cache, address, data) < 0)
+        {
+            printf("Error: Cannot write through addr=%x\n", address);
+            return ERROR;
+        }
+        line->flags |= LINE_WRITTEN;
+        ret |= BIT(WRITE_L2_THROUGH);
+        return ret;
+    }
+    line->tag_array |= BIT(cache->D_BIT);//dirty = 1;
+    line->sectors_dirty |= cache_sector_bit(cache, address);
+    return ret;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Invalidate a present line, drop its MSHR entries and
+  *             update LRU bits.
+  * @param      cache: pointer to cache instance.
+  * @param      lines: lines of the set.
+  * @param      addr_set: set index.
+  * @param      index: way of the line.
+  * @retval     status bits of the invalidation (EVICT_L2_OK, PREFETCH_UNUSED).
+  *             ERROR if failed.
+  */
+static int cache_L1_invalidate(cache_t* cache, line_t* lines, uint32_t addr_set, int index)
+{
+    return_t ret = BIT(EVICT_L2_OK);
+    if(cache->mshr != NULL)
+    {
+        mshr_release(cache->mshr, get_line_address(*cache, lines[index].tag_array, addr_set),
+                     ~cache->bytes_mask);
+    }
+    //clear V bit, indicate that the line is no longer avaiable.
+    if(cache->fa != NULL)
+    {
+        fa_remove(cache->fa, index);
+    }
+    else
+    {
+        uint16_t accessed_lru = get_line_LRU(*cache, lines[index].tag_array);
+        if(update_line_LRU(*cache, lines, accessed_lru, EVICT_LINE) < 0)
+        {
+            printf("Error: Cannot update LRU of way %d\n", index);
+            return ERROR;
+        }
+    }
+    lines[index].tag_array &= ~BIT(cache->V_BIT);
+    if(lines[index].flags & LINE_PREFETCHED)
+    {
+        ret |= BIT(PREFETCH_UNUSED);
+    }
+    cache_L1_retire(cache, addr_set, index, 0);
+    lines[index].flags = 0;
+    return ret;
+}
+
+/**
+  * @brief      Read request to L1 cache.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address
+  * @param      data: pointer to return data.
+  *             Note: this is actually the return data to deliver to CPU.
+  * @retval     status of the read request:
+  *                 @arg    return_t
+  */
+int cache_L1_read(cache_t* cache, uint32_t address, uint8_t*data)
+{
+    return_t ret = 0;
+    int index, status;
+    if(!cache)
+    {
+        //return error
+        printf("Error: Invalid cache access\n");
+        return ERROR;
+    }
+    //Split tag, set, bytes offset of an address:
+    uint32_t addr_bytes_offset = get_bytes_offset(*cache, address);
+    uint32_t addr_set = get_set(*cache, address);
+    uint32_t addr_tag = get_tag(*cache, address);
+
+    cache->latency = (cache->timing != NULL) ? cache->timing->l1_hit : 0;
+    if(cache->mshr != NULL)
+    {
+        mshr_tick(cache->mshr);
+    }
+    line_t *lines = cache_L1_get_set(cache, addr_set);
+    if(lines == NULL)
+    {
+        return ERROR;
+    }
+
+    index = cache_L1_lookup(cache, lines, addr_tag);
+    if(index != FALSE && cache_L1_sector_valid(cache, &lines[index], address))
+    {
+        ret |= BIT(READ_HIT);
+        if(lines[index].flags & LINE_PREFETCHED)
+        {
+            //first demand use of a prefetched line:
+            ret |= BIT(PREFETCH_HIT);
+            lines[index].flags &= ~LINE_PREFETCHED;
+        }
+        *data = (lines[index].data)[addr_bytes_offset];
+        cache_L1_use(cache, addr_set, index, address);
+        if(cache_L1_touch(cache, lines, index) < 0)
+        {
+            printf("Error: Cannot update LRU with addr=%x\n", address);
+            return ERROR;
+        }
+        return ret;
+    }
+
+    //read miss: make room for the line, then get it.
+    ret |= BIT(READ_MISS);
+    if(index != FALSE)
+    {
+        //sector miss: the line stays in its way, only the sector is read.
+        ret |= BIT(SECTOR_MISS);
+        status = cache_L1_touch(cache, lines, index);
+    }
+    else
+    {
+        status = cache_L1_replace(cache, lines, addr_set, address, &index, 0);
+    }
+    if(status < 0)
+    {
+        return ERROR;
+    }
+    ret |= status;
+    status = cache_L1_fill(cache, &lines[index], address, READ_L2);
+    if(status < 0)
+    {
+        return ERROR;
+    }
+    ret |= status;
+    //Now return the byte:
+    *data = (lines[index].data)[addr_bytes_offset];
+    cache_L1_use(cache, addr_set, index, address);
+    return ret;
+}
+
+/**
+  * @brief      Write request to L1 cache.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address
+  * @param      data: byte value.
+  *             Note: this is the data that CPU write to cache line.
+  * @retval     status of the write request:
+  *                 @arg    return_t
+  */
+int cache_L1_write(cache_t* cache, uint32_t address, uint8_t data)
+{
+    return_t ret = 0;
+    int index, status;
+    if(!cache)
+    {
+        //return error
+        printf("Error: Invalid cache access\n");
+        return ERROR;
+    }
+    //Split tag, set, bytes offset of an address:
+    uint32_t addr_set = get_set(*cache, address);
+    uint32_t addr_tag = get_tag(*cache, address);
+
+    cache->latency = (cache->timing != NULL) ? cache->timing->l1_hit : 0;
+    if(cache->mshr != NULL)
+    {
+        mshr_tick(cache->mshr);
+    }
+    line_t *lines = cache_L1_get_set(cache, addr_set);
+    if(lines == NULL)
+    {
+        return ERROR;
+    }
+
+    index = cache_L1_lookup(cache, lines, addr_tag);
+    if(index != FALSE && cache_L1_sector_valid(cache, &lines[index], address))
+    {
+        ret |= BIT(WRITE_HIT);
+        if(lines[index].flags & LINE_PREFETCHED)
+        {
+            //first demand use of a prefetched line:
+            ret |= BIT(PREFETCH_HIT);
+            lines[index].flags &= ~LINE_PREFETCHED;
+        }
+        status = cache_L1_store(cache, &lines[index], address, data, 0);
+        if(status < 0)
+        {
+            return ERROR;
+        }
+        ret |= status;
+        cache_L1_use(cache, addr_set, index, address);
+
+        if(cache_L1_touch(cache, lines, index) < 0)
+        {
+            printf("Error: Cannot update LRU with addr=%x\n", address);
+            return ERROR;
+        }
+        return ret;
+    }
+
+    ret |= BIT(WRITE_MISS);
+    if(index != FALSE)
+    {
+        ret |= BIT(SECTOR_MISS);
+    }
+    if(!cache->write_allocate)
+    {
+        //no write allocate: the byte goes to L2 only.
+        if(cache->directory != NULL &&
+           directory_upgrade(cache->directory, cache, address) < 0)
+        {
+            return ERROR;
+        }
+        if(cache_L2_write_through(cache, address, data) < 0)
+        {
+            printf("Error: Cannot write through addr=%x\n", address);
+            return ERROR;
+        }
+        ret |= BIT(WRITE_L2_THROUGH);
+        return ret;
+    }
+    //write allocate: read the line (or the sector) for ownership, then write.
+    if(index != FALSE)
+    {
+        status = cache_L1_touch(cache, lines, index);
+    }
+    else
+    {
+        status = cache_L1_replace(cache, lines, addr_set, address, &index, 0);
+    }
+    if(status < 0)
+    {
+        return ERROR;
+    }
+    ret |= status;
+    status = cache_L1_fill(cache, &lines[index], address, READ_L2_OWN);
+    if(status < 0)
+    {
+        return ERROR;
+    }
+    ret |= status;
+    //Now write the byte:
+    status = cache_L1_store(cache, &lines[index], address, data, 0);
+    if(status < 0)
+    {
+        return ERROR;
+    }
+    ret |= status;
+    cache_L1_use(cache, addr_set, index, address);
+    return ret;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Functional warming access: the common part of
+  *             cache_L1_warm_read() and cache_L1_warm_write().
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @param      write: 1 for a write, 0 for a read.
+  * @retval     READ_HIT/READ_MISS or WRITE_HIT/WRITE_MISS bit. ERROR if failed.
+  */
+static int cache_L1_warm_access(cache_t* cache, uint32_t address, int write)
+{
+    int index;
+    uint32_t addr_set = get_set(*cache, address);
+    line_t *lines = cache_L1_get_set(cache, addr_set);
+    if(lines == NULL)
+    {
+        return ERROR;
+    }
+    index = cache_L1_lookup(cache, lines, get_tag(*cache, address));
+    if(index != FALSE && cache_L1_sector_valid(cache, &lines[index], address))
+    {
+        lines[index].flags &= ~LINE_PREFETCHED;
+        if(write && cache_L1_store(cache, &lines[index], address, DUMMY_BYTE, 1) < 0)
+        {
+            return ERROR;
+        }
+        if(cache_L1_touch(cache, lines, index) < 0)
+        {
+            printf("Error: Cannot update LRU with addr=%x\n", address);
+            return ERROR;
+        }
+        return write ? BIT(WRITE_HIT) : BIT(READ_HIT);
+    }
+    if(write && !cache->write_allocate)
+    {
+        if(cache->directory != NULL &&
+           directory_upgrade(cache->directory, cache, address) < 0)
+        {
+            return ERROR;
+        }
+        return BIT(WRITE_MISS);
+    }
+    if(index != FALSE)
+    {
+        //sector miss:
+        if(cache_L1_touch(cache, lines, index) < 0)
+        {
+            printf("Error: Cannot update LRU with addr=%x\n", address);
+            return ERROR;
+        }
+    }
+    else if(cache_L1_replace(cache, lines, addr_set, address, &index, 1) < 0)
+    {
+        return ERROR;
+    }
+    if(cache_L1_warm_fill(cache, &lines[index], address, write) < 0)
+    {
+        return ERROR;
+    }
+    if(write && cache_L1_store(cache, &lines[index], address, DUMMY_BYTE, 1) < 0)
+    {
+        return ERROR;
+    }
+    return write ? BIT(WRITE_MISS) : BIT(READ_MISS);
+}
+
+/**
+  * @brief      Functional warming read: the line state (tag, LRU, victim
+  *             buffer, directory) is updated like cache_L1_read(), but no
+  *             data, latency, MSHR or write buffer activity. Used to fast
+  *             forward between sampled windows, the result is not meant
+  *             for cache_stat_update().
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @retval     BIT(READ_HIT) or BIT(READ_MISS). ERROR if failed.
+  */
+int cache_L1_warm_read(cache_t* cache, uint32_t address)
+{
+    return cache_L1_warm_access(cache, address, 0);
+}
+
+/**
+  * @brief      Functional warming write, see cache_L1_warm_read().
+  *             The dirty bit follows the write policy of the cache.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @retval     BIT(WRITE_HIT) or BIT(WRITE_MISS). ERROR if failed.
+  */
+int cache_L1_warm_write(cache_t* cache, uint32_t address)
+{
+    return cache_L1_warm_access(cache, address, 1);
+}
+
+/**
+  * @brief      Check that accesses to a line are plain hits, which change
+  *             nothing but the LRU bits: the line (and its sector) is
+  *             present and, for a write, dirty, not shared, and the write
+  *             policy is not write-through. It stays true until another
+  *             access to the cache or a snoop.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @param      write: 1 for writes, 0 for reads.
+  * @retval     index of the way holding the line if true, otherwise FALSE.
+  */
+int cache_L1_repeatable(cache_t* cache, uint32_t address, int write)
+{
+    int index = cache_L1_probe(cache, address);
+    if(index == FALSE)
+    {
+        return index;
+    }
+    line_t* lines = (cache->sets)[get_set(*cache, address)].lines;
+    if(!cache_L1_sector_valid(cache, &lines[index], address))
+    {
+        return FALSE;
+    }
+    if(!write)
+    {
+        return index;
+    }
+    if(cache->write_policy == WRITE_THROUGH ||
+       !(lines[index].tag_array & BIT(cache->D_BIT)) ||
+       (cache->sectors_num > 1 && !(lines[index].sectors_dirty & cache_sector_bit(cache, address))) ||
+       (lines[index].flags & LINE_SHARED))
+    {
+        return FALSE;
+    }
+    return index;
+}
+
+/**
+  * @brief      Usage bit of a byte in its line, see cache_set_usage().
+  *             A run of hits gathers the bits of its accesses for
+  *             cache_L1_repeat().
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @retval     the bit, 0 when the cache does not record its line usage.
+  */
+uint64_t cache_L1_usage_bit(cache_t* cache, uint32_t address)
+{
+    if(cache->usage == NULL)
+    {
+        return 0;
+    }
+    return 1ULL << (get_bytes_offset(*cache, address) >> cache->usage_shift);
+}
+
+/**
+  * @brief      Apply count hits to a line in O(1), when
+  *             cache_L1_repeatable() is true: the MSHR clock advances by
+  *             count, the line is touched once in LRU and the latency is
+  *             one L1 hit per access. Same state as count read/write hits.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @param      write: 1 for writes, 0 for reads.
+  * @param      count: number of accesses.
+  * @param      used: usage bits of the bytes accessed in the line besides
+  *             address (cache_L1_usage_bit()), 0 if none.
+  * @retval     BIT(READ_HIT) or BIT(WRITE_HIT), give it to cache_stat_repeat().
+  *             ERROR if the hits cannot be repeated.
+  */
+int cache_L1_repeat(cache_t* cache, uint32_t address, int write, uint32_t count, uint64_t used)
+{
+    int index = cache_L1_repeatable(cache, address, write);
+    if(index == FALSE)
+    {
+        printf("Error: Cannot repeat hits to addr=%x\n", address);
+        return ERROR;
+    }
+    uint32_t addr_set = get_set(*cache, address);
+    line_t* lines = (cache->sets)[addr_set].lines;
+    if(cache->mshr != NULL)
+    {
+        cache->mshr->now += count;
+    }
+    cache_L1_use(cache, addr_set, index, address);
+    if(cache->usage != NULL)
+    {
+        cache->usage[((size_t)addr_set * cache->ways_assoc) + index] |= used;
+    }
+    cache->latency = (cache->timing != NULL) ? cache->timing->l1_hit : 0;
+    if(cache_L1_touch(cache, lines, index) < 0)
+    {
+        printf("Error: Cannot update LRU with addr=%x\n", address);
+        return ERROR;
+    }
+    return write ? BIT(WRITE_HIT) : BIT(READ_HIT);
+}
+
+/**
+  * @brief      Prefetch into the host caches the memory a later request
+  *             to the address will touch, so that lookups of several
+  *             records in flight overlap their host misses. The stages
+  *             are issued in order, each one reading what the previous
+  *             brought. Only hints: no state of the cache changes and a
+  *             set not created yet is left alone.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @param      write: 1 for writes, 0 for reads.
+  * @param      stage: see host_prefetch_t.
+  * @retval     None.
+  */
+void cache_L1_host_prefetch(cache_t* cache, uint32_t address, int write, host_prefetch_t stage)
+{
+    size_t i, size;
+    if(cache == NULL || cache->sets == NULL)
+    {
+        return;
+    }
+    set_t *set = &(cache->sets)[get_set(*cache, address)];
+    if(stage == HOST_PREFETCH_SET)
+    {
+        __builtin_prefetch(set, 0);
+        return;
+    }
+    line_t *lines = set->lines;
+    if(lines == NULL)
+    {
+        return;
+    }
+    if(stage == HOST_PREFETCH_LINES && cache->fa != NULL)
+    {
+        //the bucket of the tag, not the thousands of ways:
+        fa_host_prefetch(cache->fa, get_tag(*cache, address));
+        return;
+    }
+    if(stage == HOST_PREFETCH_LINES)
+    {
+        size = (size_t)cache->ways_assoc * sizeof(line_t);
+        for(i = 0; i < size; i += 64)
+        {
+            __builtin_prefetch((uint8_t*)lines + i, 1);
+        }
+        return;
+    }
+    int index = cache_L1_lookup(cache, lines, get_tag(*cache, address));
+    if(index != FALSE)
+    {
+        uint8_t *byte = lines[index].data + get_bytes_offset(*cache, address);
+        if(cache->usage != NULL)
+        {
+            __builtin_prefetch(&cache->usage[((size_t)get_set(*cache, address) * cache->ways_assoc) + index], 1);
+        }
+        if(write)
+        {
+            __builtin_prefetch(byte, 1);
+        }
+        else
+        {
+            __builtin_prefetch(byte, 0);
         }
     }
-    //line_t *tmp_set = (cache->sets)[addr_set].lines;
-    
-    return ret;
 }
 
 /**
-  * @brief      Write request to L1 cache.
+  * @brief      Clear all state of L1 cache.
+  *             All sets are released, the configuration and attached
+  *             victim buffer/MSHR are kept but emptied.
   * @param      cache: pointer to cache instance.
-  * @param      address: byte address
-  * @param      data: byte value.
-  *             Note: this is the data that CPU write to cache line.
-  * @retval     status of the write request:
-  *                 @arg    return_t
+  * @retval     SUCCESS if clear success.
+  *             otherwise ERROR.
   */
-int cache_L1_write(cache_t* cache, uint32_t address, uint8_t data)
+int cache_L1_clear(cache_t* cache)
 {
-    return_t ret = 0;
-    //Split tag, set, bytes offset of an address:
-    uint32_t addr_bytes_offset = get_bytes_offset(*cache, address);
-    uint32_t addr_set = get_set(*cache, address);
-    uint32_t addr_tag = get_tag(*cache, address);
-
-    if(!cache)
+    int i, j;
+    if(cache == NULL)
     {
-        //return error
-        printf("Error: Invalid cache access\n");
         return ERROR;
     }
-
-    if((cache->sets)[addr_set].lines == NULL)
+    int sets_num = 1 << cache->sets_num_bits;
+    for(i = 0; i < sets_num; i++)
     {
-        //there is no line in set:
-        //write miss: ret |= BIT(WRITE_MISS)
-        //  - Create set first: ep. create [ways_assoc] lines append to set
-        //  - Call cache L2 read to get 1 line(ret |= BIT(READ_L2_OWN)), place it in set
-        //      valid = 1, update tag, fake data = 64*DUMMY_BYTES.
-        //      write a new dummy byte to bytes_offset, dirty = 1;
-        
-        ret |= BIT(WRITE_MISS);
-        int i;
-        //Create the set: 
-        //line_t *lines = (line_t*)malloc((cache->ways_assoc) * sizeof(line_t));
-        line_t *lines = create_set(cache->ways_assoc);
+        line_t *lines = (cache->sets)[i].lines;
         if(lines == NULL)
         {
-            printf("Error: Cannot create set of %d line\n", cache->ways_assoc);
-            return ERROR;
+            continue;
         }
-        int size = pow(2, cache->bytes_num_bits);//should be 64
-        for(i = 0; i < cache->ways_assoc; i++)
+        (cache->sets)[i].lines = NULL;
+        if(cache->arena != NULL)
         {
-            lines[i].tag_array = 0;
-            lines[i].data = create_line(size);
+            //the place of the set in the arena is reused by the next access.
+            continue;
         }
-        (cache->sets)[addr_set].lines = lines;
-        //Now the set is not null, but it all empty(all valid == 0, no data in it)
-        
-        uint8_t *line_data = create_line(size);
-        if(cache_L2_read(cache, address, line_data) < 0)
+        for(j = 0; j < cache->ways_assoc; j++)
         {
-            printf("Error: Read L2 error\n");
-            return ERROR;
+            free(lines[j].data);
         }
+        free(lines);
+    }
+    if(cache->fa != NULL)
+    {
+        fa_clear(cache->fa);
+    }
+    if(cache->usage != NULL)
+    {
+        //the lines are dropped, not evicted: they are not counted.
+        memset(cache->usage, 0, ((size_t)cache->ways_assoc << cache->sets_num_bits) * sizeof(uint64_t));
+    }
+    if(cache->victim != NULL)
+    {
+        victim_clear(cache->victim);
+    }
+    if(cache->mshr != NULL)
+    {
+        mshr_clear(cache->mshr);
+    }
+    if(cache->wbuf != NULL)
+    {
+        writebuf_clear(cache->wbuf);
+    }
+    return SUCCESS;
+}
 
-        ret |= BIT(READ_L2_OWN);
-        lines[0].tag_array = 0;
-        lines[0].tag_array |= BIT(cache->V_BIT); //valid = 1;
-
-        lines[0].tag_array += addr_tag;//update tag
-        for(i = 0; i < size; i++)
-        {
-            (lines[0].data)[i] = line_data[i];// copy from tmp_line to the 1st line.
-        }
+/**
+  * @brief      Check whether a line is present in L1 cache.
+  *             Note: this is a lookup only, LRU bits are not touched.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @retval     index of the way holding the line if present.
+  *             otherwise FALSE.
+  */
+int cache_L1_probe(cache_t* cache, uint32_t address)
+{
+    uint32_t addr_set = get_set(*cache, address);
+    uint32_t addr_tag = get_tag(*cache, address);
+    line_t* lines = (cache->sets)[addr_set].lines;
+    if(lines == NULL)
+    {
+        return FALSE;
+    }
+    return cache_L1_lookup(cache, lines, addr_tag);
+}
 
-        //Now we write a new bytes and set dirty = 1:
-        (lines[0].data)[addr_bytes_offset] = data;
-        lines[0].tag_array |= BIT(cache->D_BIT);
-        return ret;
+/**
+  * @brief      Prefetch fill to L1 cache.
+  *             The line is read from L2 and placed like a demand miss
+  *             (LRU replacement, dirty victim written back), but no hit/miss
+  *             is reported and the line is marked with LINE_PREFETCHED.
+  *             In a sectored cache, a missing sector of a present line is
+  *             read without touching the LRU bits or the mark of the line.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address of the line to prefetch.
+  * @retval     status of the prefetch request:
+  *                 @arg    return_t: PREFETCH_L2, WRITE_L2, PREFETCH_UNUSED.
+  *                         0 if the line is already present.
+  */
+int cache_L1_prefetch(cache_t* cache, uint32_t address)
+{
+    return_t ret = 0;
+    int status;
+    uint32_t addr_set = get_set(*cache, address);
+    int index = cache_L1_probe(cache, address);
+    line_t *lines = cache_L1_get_set(cache, addr_set);
+    if(lines == NULL)
+    {
+        return ERROR;
     }
-    else{
-        //There are already some lines in set
-        //Or can be no line(all valid == 0).
-        //  - Use for loop to traverse the lines:
-        //      count the number of valids;
-        //      if valid :
-        //              + if line_tag == addr_tag: ret |= BIT(WRITE_HIT); write data.
-        //              + else: continue to search
-        //  - exit the loop: if still no where to get data ret |= BIT(WRITE_MISS)
-        //              + if count_valids < ways_assoc, call cache_L2_read() to get line, ret |= BIT(READ_L2_OWN)
-        //                  place it in the first available space in line. Then write a byte to bytes_offset.
-        //              + else count_valids == ways_assoc, -> need to replace LRU call index
-        //                  if lines[LRU] is not dirty -> no need to evict, call cache_L2_read(), ret |= BIT(READ_L2_OWN)
-        //                      in place the line in the LRU index. Then write a byte to bytes_offset.
-        //                  else: the lines[LRU] is dirty, call cache_L2_write() to evict, ret |= BIT(WRITE_L2);
-        //                      call cache_L2_read() to get the line, ret |= BIT(READ_L2). write to a byte to bytes_offset.
-        int i, count = 0, hit = 0;
-        line_t *lines = (cache->sets)[addr_set].lines;
-        for(i = 0; i < cache->ways_assoc; i++)
-        {
-            if(lines[i].tag_array & BIT(cache->V_BIT))
-            {
-                // printf("Attemp hit\n");
-                count++;
-                uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-                tag_line_mask = ~tag_line_mask;
-                uint16_t line_tag = lines[i].tag_array & tag_line_mask;
-
-                if(line_tag == addr_tag){
-                    ret |= BIT(WRITE_HIT);
-                    hit = 1;
-                    (lines[i].data)[addr_bytes_offset] = data;
-                    lines[i].tag_array |= BIT(cache->D_BIT);//dirty = 1;
-
-                    uint16_t accessed_lru = get_line_LRU(*cache, lines[i].tag_array);
-                    if(update_line_LRU(*cache, lines, accessed_lru, ACCESS) < 0)
-                    {
-                        printf("Error: Cannot update LRU with addr=%x\n", address);
-                        return ERROR;
-                    }
-                    
-                    return ret;
-                }
-            }
-        }
-        // printf("count: %d\n", count);
-        if(hit == 0)
+    if(index != FALSE)
+    {
+        if(cache_L1_sector_valid(cache, &lines[index], address))
         {
-            ret |= BIT(WRITE_MISS);
-            if(count < cache->ways_assoc)
-            {
-                //still have space to fill in.
-                int index =0;
-                for(i = 0; i < cache->ways_assoc; i++)
-                {
-                    //if()
-                    if(!(lines[i].tag_array & BIT(cache->V_BIT)))
-                    {
-                        //this index is avaiable
-                        index = i;
-                        break;
-                    }
-                }
-                
-                //Update old LRU bit of old lines, before adding new line
-                if(update_line_LRU(*cache, lines, 0, NEW_LINE) < 0)
-                {
-                    printf("Error: Cannot update LRU with addr=%x.\n", address);
-                    return ERROR;
-                }
-                // int tmp_lru = get_line_LRU(*cache, lines[0].tag_array);
-                // printf("0 lru=%d\n", tmp_lru);
-                //Get a line from L2 cache:
-                int size = pow(2, cache->bytes_num_bits);//should be 64
-                uint8_t* line_data = create_line(size);
-                if(cache_L2_read(cache, address, line_data) < 0)
-                {
-                    printf("Error: Read L2 error\n");
-                    return ERROR;
-                }
-                ret |= BIT(READ_L2_OWN);
-                lines[index].tag_array |= BIT(cache->V_BIT); //valid = 1;
-                uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-                lines[index].tag_array &= tag_line_mask;// clear old tag
-                lines[index].tag_array += addr_tag;//update tag
-                for(i = 0; i < size; i++)
-                {
-                    (lines[index].data)[i] = line_data[i];// copy from tmp_line to the 1st line.
-                }
-                //Now write the byte:
-                (lines[index].data)[addr_bytes_offset] = data;
-                lines[index].tag_array |= BIT(cache->D_BIT);// dirty = 1
-                return ret;
-            }
-            else {
-                //Now the count == ways_assoc, mean that the set is full of lines,
-                //Now we need to replace one of the line in the set.
-
-                //Update old LRU bit of old lines, before adding new line
-                int index = cal_LRU(*cache, lines);
-                uint16_t accessed_lru = get_line_LRU(*cache, lines[index].tag_array);
-                if(update_line_LRU(*cache, lines, accessed_lru, ACCESS) < 0)
-                {
-                    printf("Error: Cannot update LRU with addr=%x.\n", address);
-                    return ERROR;
-                }
-                
-                // printf("lru index: %d\n", index);
-                // int j;
-                // for(j = 0; j < 4; j++)
-                // {
-                //     printf("lru:%d", get_line_LRU(*cache, lines[j].tag_array) );
-                // }
-                if(!(lines[index].tag_array & BIT(cache->D_BIT)))
-                {
-                    //Line is not dirty:
-                    //Get a line from L2 cache:
-                    int size = pow(2, cache->bytes_num_bits);//should be 64
-                    uint8_t *line_data = create_line(size);
-                    if(cache_L2_read(cache, address, line_data) < 0)
-                    {
-                        printf("Error: Read L2 error\n");
-                        return ERROR;
-                    }
-                    ret |= BIT(READ_L2_OWN);
-                    // lines[index].tag_array |= BIT(cache->V_BIT); //valid = 1;
-                    uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-                    lines[index].tag_array &= tag_line_mask;// clear old tag
-                    lines[index].tag_array += addr_tag;//update tag
-                    for(i = 0; i < size; i++)
-                    {
-                        (lines[index].data)[i] = line_data[i];// copy from tmp_line to the 1st line.
-                    }
-                }
-                else{
-                    //the line is dirty, now we need to evict it first:
-                    if(cache_L2_write(cache, address, lines[index].data) < 0)
-                    {
-                        printf("Error: Cannot evict line has addr=%x\n", address);
-                        return ERROR;
-                    }
-                    ret |= BIT(WRITE_L2);
-
-                    //Now we read new line
-                    //Get a line from L2 cache:
-                    int size = pow(2, cache->bytes_num_bits);//should be 64
-                    uint8_t *line_data =create_line(size);
-                    if(cache_L2_read(cache, address, line_data) < 0)
-                    {
-                        printf("Error: Read L2 error\n");
-                        return ERROR;
-                    }
-                    ret |= BIT(READ_L2_OWN);
-                    // lines[index].tag_array |= BIT(cache->V_BIT); //valid = 1;
-                    uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-                    lines[index].tag_array &= tag_line_mask;// clear old tag
-                    lines[index].tag_array += addr_tag;//update tag
-                    for(i = 0; i < size; i++)
-                    {
-                        (lines[index].data)[i] = line_data[i];// copy from tmp_line to the 1st line.
-                    }
-                    //Now return the byte:
-                    (lines[index].data)[addr_bytes_offset] = data;
-                    lines[index].tag_array |= BIT(cache->D_BIT);
-                    return ret;
-                }
-            }
+            return ret;
         }
+        return cache_L1_fill(cache, &lines[index], address, PREFETCH_L2);
+    }
+    status = cache_L1_replace(cache, lines, addr_set, address, &index, 0);
+    if(status < 0)
+    {
+        return ERROR;
+    }
+    ret |= status;
+    status = cache_L1_fill(cache, &lines[index], address, PREFETCH_L2);
+    if(status < 0)
+    {
+        return ERROR;
     }
+    ret |= status;
+    lines[index].flags |= LINE_PREFETCHED;
     return ret;
 }
 
 /**
-  * @brief      Clear all state of L1 cache.
+  * @brief      Snoop request from the directory (another core accessed the line).
+  *             A modified line is written back to L2 first, then the line
+  *             is invalidated, or kept in S state.
   * @param      cache: pointer to cache instance.
-  * @retval     SUCCESS if clear success.
-  *             otherwise ERROR.
+  * @param      address: byte address.
+  * @param      invalidate: 1 to invalidate the line, 0 to downgrade it to S.
+  * @retval     status of the snoop request:
+  *                 @arg    return_t: WRITE_L2 if the line was modified,
+  *                         EVICT_L2_OK, PREFETCH_UNUSED if invalidated.
+  *                         0 if the line is not present, ERROR if failed.
   */
-int cache_L1_clear(cache_t* cache)
+int cache_L1_snoop(cache_t* cache, uint32_t address, int invalidate)
 {
-    int sets_num = pow(2, cache->sets_num_bits);
-    int ways_assoc = cache->ways_assoc;
-    int line_size = pow(2, cache->bytes_num_bits);
-    free(cache);
-    cache = create_cache(sets_num, ways_assoc,line_size);
-    cache->sets = (set_t*)malloc(sets_num * sizeof(set_t));
-    return SUCCESS;
+    return_t ret = 0;
+    int i = cache_L1_probe(cache, address);
+    if(i == FALSE)
+    {
+        return ret;
+    }
+    line_t* lines = (cache->sets)[get_set(*cache, address)].lines;
+    if(lines[i].tag_array & BIT(cache->D_BIT))
+    {
+        if(cache_L1_writeback(cache, &lines[i], address & ~cache->bytes_mask) < 0)
+        {
+            printf("Error: Cannot write back addr=%x\n", address);
+            return ERROR;
+        }
+        lines[i].tag_array &= ~BIT(cache->D_BIT);
+        lines[i].sectors_dirty = 0;
+        ret |= BIT(WRITE_L2);
+    }
+    if(invalidate)
+    {
+        int status = cache_L1_invalidate(cache, lines, get_set(*cache, address), i);
+        if(status < 0)
+        {
+            return ERROR;
+        }
+        return ret | status;
+    }
+    lines[i].flags |= LINE_SHARED;
+    return ret;
 }
 
 /**
   * @brief      Evict command from L2. After this command a line should be invalidated.
+  *             The line is also removed from the victim buffer, if any.
   * @param      cache: pointer to cache instance.
   * @param      address: byte address.
   * @retval     status of the evict request:
@@ -748,33 +1864,28 @@ int cache_L2_evict(cache_t* cache, uint32_t address)
     uint32_t addr_tag = get_tag(*cache, address);
     line_t* lines = (cache->sets)[addr_set].lines;
     int i;
+    if(cache->timing != NULL)
+    {
+        timing_l2_evict(cache->timing, address);
+    }
     if(lines == NULL)
     {
         printf("Warning: The set with %x is null/empty\n", address);
-        return EVICT_L2_ERROR;
+        return BIT(EVICT_L2_ERROR);
     }
-    for(i =0 ; i < cache->ways_assoc; i++)
+    i = cache_L1_lookup(cache, lines, addr_tag);
+    if(i != FALSE)
     {
-        if(lines[i].tag_array & BIT(cache->V_BIT))
+        return cache_L1_invalidate(cache, lines, addr_set, i);
+    }
+    if(cache->victim != NULL)
+    {
+        i = victim_lookup(cache->victim, address & ~cache->bytes_mask);
+        if(i != FALSE)
         {
-            //Only consider valid line:
-            uint16_t tag_line_mask = cache->LRU_line_mask | BIT(cache->D_BIT) | BIT(cache->V_BIT);
-            tag_line_mask = ~tag_line_mask;
-            uint16_t line_tag = lines[i].tag_array & tag_line_mask;
-            if(line_tag == addr_tag)
-            {
-                ret |= BIT(EVICT_L2_OK);
-                //clear V bit, indicate that the line is no longer avaiable.
-                uint16_t accessed_lru = get_line_LRU(*cache, lines[i].tag_array);
-                if(update_line_LRU(*cache, lines,accessed_lru, EVICT_LINE) < 0)
-                {
-                    printf("Error: Cannot update LRU with addr=%x\n", address);
-                    return ERROR;
-                }
-                lines[i].tag_array &= ~BIT(cache->V_BIT);
-
-                return ret;
-            }
+            victim_invalidate(cache->victim, i);
+            ret |= BIT(EVICT_L2_OK);
+            return ret;
         }
     }
     ret |= BIT(EVICT_L2_ERROR);
@@ -783,7 +1894,8 @@ int cache_L2_evict(cache_t* cache, uint32_t address)
 }
 
 /**
-  * @brief      Read request to L2. To get a line from L2.
+  * @brief      Read request to L2. To get a line from L2, or a sector of
+  *             the line in a sectored cache.
   * @param      cache: pointer to cache instance.
   * @param      address: byte address.
   * @param      data: pointer to array of data, this array will be modify after get a line from L2
@@ -794,7 +1906,8 @@ int cache_L2_read(cache_t* cache, uint32_t address, uint8_t* data)
     //Just simulate the read from L2 cache:
     //Simply return a line with all dummy byte 0xFF
     int i;
-    int size = pow(2, cache->bytes_num_bits);
+    int size = 1 << cache->sector_bits;
+    cache->l2_read_bytes += size;
     if(data == NULL)
     {
         data = (uint8_t*)malloc(size * sizeof(uint8_t));
@@ -807,7 +1920,8 @@ int cache_L2_read(cache_t* cache, uint32_t address, uint8_t* data)
 }
 
 /**
-  * @brief      Write request to L2. To write/evict a line from L2.
+  * @brief      Write request to L2. To write/evict a line from L2, or a
+  *             sector of the line in a sectored cache.
   * @param      cache: pointer to cache instance.
   * @param      address: byte address.
   * @param      data: pointer to array of data, this array will be used to modify the line in L2.
@@ -817,6 +1931,52 @@ int cache_L2_write(cache_t* cache, uint32_t address, uint8_t* data)
 {
     //simulate that write to L2 (due to L1 eviction) is always success
     //further code can goes here.
+    int written = 1;
+    int size = 1 << cache->sector_bits;
+    if(cache->misstrace != NULL &&
+       misstrace_write(cache->misstrace, WRITE_DATA, MISSTRACE_WRITEBACK, address, cache->core) < 0)
+    {
+        return ERROR;
+    }
+    cache->l2_write_bytes += size;
+    if(cache->wbuf != NULL)
+    {
+        written = writebuf_write(cache->wbuf, address, size);
+    }
+    if(cache->timing != NULL && written)
+    {
+        //the write is not hidden by the write buffer:
+        cache->latency += cache->timing->writeback;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Write-through request to L2. To write one byte in a line of L2.
+  * @param      cache: pointer to cache instance.
+  * @param      address: byte address.
+  * @param      data: byte value.
+  * @retval     status of the write request L2.
+  */
+int cache_L2_write_through(cache_t* cache, uint32_t address, uint8_t data)
+{
+    //simulate that write-through to L2 is always success
+    int written = 1;
+    if(cache->misstrace != NULL &&
+       misstrace_write(cache->misstrace, WRITE_DATA, MISSTRACE_THROUGH, address, cache->core) < 0)
+    {
+        return ERROR;
+    }
+    cache->l2_write_bytes += sizeof(data);
+    if(cache->wbuf != NULL)
+    {
+        written = writebuf_write(cache->wbuf, address, sizeof(data));
+    }
+    if(cache->timing != NULL && written)
+    {
+        //the write is not hidden by the write buffer:
+        cache->latency += cache->timing->writeback;
+    }
     return SUCCESS;
 }
 
@@ -855,11 +2015,21 @@ cache_stat_t* cache_stat_create(char* cache_name, FILE* log_fp, int mode)
     stat->count = 0;
     stat->log_file = log_fp;
     stat->mode = mode;
+    stat->cache = NULL;
     stat->read_hits = 0;
     stat->read_misses = 0;
     stat->write_hits = 0;
     stat->write_misses = 0;
+    stat->l2_writebacks = 0;
+    stat->l2_write_throughs = 0;
+    stat->sector_misses = 0;
     stat->hit_rate = 1;
+    stat->cycles = 0;
+    stat->stall_cycles = 0;
+    memset(stat->latency_hist, 0, sizeof(stat->latency_hist));
+    stat->l2_read_bytes_base = 0;
+    stat->l2_write_bytes_base = 0;
+    memset(stat->usage_hist_base, 0, sizeof(stat->usage_hist_base));
     return stat;
 }
 
@@ -892,11 +2062,47 @@ int cache_stat_init(cache_stat_t* stat,char* cache_name, FILE* log_fp, int mode)
     stat->count = 0;
     stat->log_file = log_fp;
     stat->mode = mode;
+    stat->cache = NULL;
     stat->read_hits = 0;
     stat->read_misses = 0;
     stat->write_hits = 0;
     stat->write_misses = 0;
+    stat->l2_writebacks = 0;
+    stat->l2_write_throughs = 0;
+    stat->sector_misses = 0;
     stat->hit_rate = 1;
+    stat->cycles = 0;
+    stat->stall_cycles = 0;
+    memset(stat->latency_hist, 0, sizeof(stat->latency_hist));
+    stat->l2_read_bytes_base = 0;
+    stat->l2_write_bytes_base = 0;
+    memset(stat->usage_hist_base, 0, sizeof(stat->usage_hist_base));
+    return SUCCESS;
+}
+
+/**
+  * @brief      Bind a statistic instance to its cache.
+  *             When the cache has a latency model, the statistic sums the
+  *             latency of every read/write and cache_log() reports it.
+  * @param      stat: pointer to the statistic instance.
+  * @param      cache: pointer to the cache instance.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cache_stat_bind(cache_stat_t* stat, cache_t* cache)
+{
+    if(stat == NULL)
+    {
+        printf("Error: Stat is null.\n");
+        return ERROR;
+    }
+    stat->cache = cache;
+    stat->l2_read_bytes_base = (cache != NULL) ? cache->l2_read_bytes : 0;
+    stat->l2_write_bytes_base = (cache != NULL) ? cache->l2_write_bytes : 0;
+    memset(stat->usage_hist_base, 0, sizeof(stat->usage_hist_base));
+    if(cache != NULL && cache->usage_hist != NULL)
+    {
+        memcpy(stat->usage_hist_base, cache->usage_hist, sizeof(stat->usage_hist_base));
+    }
     return SUCCESS;
 }
 
@@ -930,6 +2136,27 @@ int cache_stat_update(cache_stat_t*stat, return_t update, uint32_t address)
     {
         stat->write_misses++;
     }
+    if(update & BIT(WRITE_L2))
+    {
+        stat->l2_writebacks++;
+    }
+    if(update & BIT(WRITE_L2_THROUGH))
+    {
+        stat->l2_write_throughs++;
+    }
+    if(update & BIT(SECTOR_MISS))
+    {
+        stat->sector_misses++;
+    }
+    if(stat->cache != NULL && stat->cache->timing != NULL &&
+       (update & (BIT(READ_HIT) | BIT(READ_MISS) | BIT(WRITE_HIT) | BIT(WRITE_MISS))))
+    {
+        //timing of a read/write request, prefetch fills are not counted:
+        uint32_t latency = stat->cache->latency;
+        stat->cycles += latency;
+        stat->stall_cycles += latency - stat->cache->timing->l1_hit;
+        stat->latency_hist[timing_hist_bin(latency)]++;
+    }
     if(stat->mode == 2)
     {
         //Activity log mode:
@@ -945,6 +2172,51 @@ int cache_stat_update(cache_stat_t*stat, return_t update, uint32_t address)
         {
             fprintf(stat->log_file, "[MESSAGE] %s read for Ownership from L2 %x\n", stat->name, address);
         }
+        if(update & BIT(PREFETCH_L2))
+        {
+            fprintf(stat->log_file, "[MESSAGE] %s prefetch from L2 %x\n", stat->name, address);
+        }
+        if(update & BIT(WRITE_L2_THROUGH))
+        {
+            fprintf(stat->log_file, "[MESSAGE] %s write through to L2 %x\n", stat->name, address);
+        }
+        if(update & BIT(UPGRADE_L2))
+        {
+            fprintf(stat->log_file, "[MESSAGE] %s upgrade at L2 %x\n", stat->name, address);
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Update the statistic with count hits from cache_L1_repeat().
+  *             Same as count calls of cache_stat_update(), hits have no
+  *             mode 2 message.
+  * @param      stat: pointer to the statistic instance.
+  * @param      update: BIT(READ_HIT) or BIT(WRITE_HIT).
+  * @param      count: number of hits.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cache_stat_repeat(cache_stat_t*stat, return_t update, uint32_t count)
+{
+    if(update & BIT(READ_HIT))
+    {
+        stat->read_hits += count;
+    }
+    else if(update & BIT(WRITE_HIT))
+    {
+        stat->write_hits += count;
+    }
+    else
+    {
+        return ERROR;
+    }
+    if(stat->cache != NULL && stat->cache->timing != NULL)
+    {
+        uint32_t latency = stat->cache->latency;
+        stat->cycles += (uint64_t)latency * count;
+        stat->stall_cycles += (uint64_t)(latency - stat->cache->timing->l1_hit) * count;
+        stat->latency_hist[timing_hist_bin(latency)] += count;
     }
     return SUCCESS;
 }
@@ -973,9 +2245,73 @@ int cache_log(cache_stat_t *stat)
     fprintf(fp, "> Read misses   : %d\n", stat->read_misses);
     fprintf(fp, "> Write hits    : %d\n", stat->write_hits);
     fprintf(fp, "> Write misses  : %d\n", stat->write_misses);
+    fprintf(fp, "> L2 writebacks : %d\n", stat->l2_writebacks);
+    fprintf(fp, "> L2 write-thru : %d\n", stat->l2_write_throughs);
     stat->hit_rate = (stat->read_hits + stat->write_hits)* 1.0 /
                          (stat->read_hits + stat->write_hits + stat->write_misses + stat->read_misses); 
     fprintf(fp, "> Hit rate: %.1f%%\n", stat-> hit_rate * 100);
+    if(stat->cache != NULL && stat->cache->sectors_num > 1)
+    {
+        fprintf(fp, "> Sector misses : %d\n", stat->sector_misses);
+        fprintf(fp, "> Line misses   : %d\n",
+                    stat->read_misses + stat->write_misses - stat->sector_misses);
+        fprintf(fp, "> L2 read bytes : %llu\n",
+                    (unsigned long long)(stat->cache->l2_read_bytes - stat->l2_read_bytes_base));
+        fprintf(fp, "> L2 write bytes: %llu\n",
+                    (unsigned long long)(stat->cache->l2_write_bytes - stat->l2_write_bytes_base));
+    }
+    if(stat->cache != NULL && stat->cache->usage_hist != NULL)
+    {
+        int i;
+        uint64_t lines = 0, parts = 0, count;
+        int part_size = 1 << stat->cache->usage_shift;
+        int parts_num = (int)(stat->cache->bytes_mask >> stat->cache->usage_shift) + 1;
+        for(i = 0; i <= parts_num; i++)
+        {
+            count = stat->cache->usage_hist[i] - stat->usage_hist_base[i];
+            lines += count;
+            parts += count * i;
+        }
+        //average bytes used of a line, in hundredths:
+        uint64_t used = lines ? parts * part_size * 100 / lines : 0;
+        fprintf(fp, "> Lines evicted : %llu\n", (unsigned long long)lines);
+        fprintf(fp, "> Bytes used    : %llu.%02llu of %d per line\n",
+                    (unsigned long long)(used / 100), (unsigned long long)(used % 100),
+                    parts_num * part_size);
+        fprintf(fp, "> Line usage histogram:\n");
+        for(i = 0; i <= parts_num; i++)
+        {
+            count = stat->cache->usage_hist[i] - stat->usage_hist_base[i];
+            if(count == 0)
+            {
+                continue;
+            }
+            fprintf(fp, ">   %4d bytes  : %llu\n", i * part_size, (unsigned long long)count);
+        }
+    }
+    if(stat->cache != NULL && stat->cache->timing != NULL && reads_num + writes_num > 0)
+    {
+        int i;
+        uint64_t accesses = reads_num + writes_num;
+        uint64_t amat = stat->cycles * 100 / accesses;
+        fprintf(fp, "> AMAT          : %llu.%02llu cycles\n",
+                    (unsigned long long)(amat / 100), (unsigned long long)(amat % 100));
+        fprintf(fp, "> Total cycles  : %llu\n", (unsigned long long)stat->cycles);
+        fprintf(fp, "> Stall cycles  : %llu\n", (unsigned long long)stat->stall_cycles);
+        fprintf(fp, "> Latency histogram:\n");
+        for(i = 0; i < TIMING_HIST_BINS; i++)
+        {
+            if(stat->latency_hist[i] == 0)
+            {
+                continue;
+            }
+            if(i == TIMING_HIST_BINS - 1)
+                fprintf(fp, ">   >= %-9u : %u\n", 1U << i, stat->latency_hist[i]);
+            else
+                fprintf(fp, ">   %4u..%-5u : %u\n", i ? 1U << i : 0, (1U << (i + 1)) - 1,
+                            stat->latency_hist[i]);
+        }
+    }
     fprintf(fp, "------------------------------\n");
     stat->count++;
     return SUCCESS;
@@ -999,7 +2335,22 @@ int clear_stat(cache_stat_t *stat)
     stat->read_misses = 0;
     stat->write_hits = 0;
     stat->write_misses = 0;
+    stat->l2_writebacks = 0;
+    stat->l2_write_throughs = 0;
+    stat->sector_misses = 0;
     stat->hit_rate = 1;
+    stat->cycles = 0;
+    stat->stall_cycles = 0;
+    memset(stat->latency_hist, 0, sizeof(stat->latency_hist));
+    if(stat->cache != NULL)
+    {
+        stat->l2_read_bytes_base = stat->cache->l2_read_bytes;
+        stat->l2_write_bytes_base = stat->cache->l2_write_bytes;
+        if(stat->cache->usage_hist != NULL)
+        {
+            memcpy(stat->usage_hist_base, stat->cache->usage_hist, sizeof(stat->usage_hist_base));
+        }
+    }
     return SUCCESS;
 }
 
@@ -1058,6 +2409,11 @@ int cal_LRU(cache_t cache, line_t* lines)
             list_query_size++;
         }
     }
+    if(list_query_size == 0)
+    {
+        //no valid line, nothing to replace: the first way.
+        return index;
+    }
     query_t max_lru_query;
     max_lru_query.index = list_query[0].index;
     max_lru_query.lru = list_query[0].lru;
@@ -0,0 +1,199 @@
+/**
+  ***********************************************************************
+  * @file       cachesim.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Public API of the simulator library.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    The library is built by "make lib": libcachesim.a and libcachesim.so.
+    Only the functions of cachesim.h are exported by the shared library,
+    the rest of the simulator is compiled with hidden visibility.
+    [..]
+    (#) Fill a cachesim_config_t by cachesim_config_init(), change the options.
+    (#) Create a simulator by cachesim_create(), log_path may be NULL.
+    (#) Send the accesses by arrays with cachesim_access_batch().
+    (#) Read the counters of a cache by cachesim_get_stats().
+    (#) Release the simulator by cachesim_destroy().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <string.h>
+#include "sim.h"
+#include "cachesim.h"
+
+//the public values must stay equal to the internal ones:
+_Static_assert(CACHESIM_READ == READ_DATA && CACHESIM_WRITE == WRITE_DATA &&
+               CACHESIM_FETCH == INSTRUCTION_FETCH && CACHESIM_EVICT == EVICT &&
+               CACHESIM_CLEAR == CLEAR_CACHE && CACHESIM_PRINT == PRINT_CONTENT,
+               "command values");
+_Static_assert(CACHESIM_PF_NEXT_LINE == PF_NEXT_LINE && CACHESIM_PF_STRIDE == PF_STRIDE &&
+               CACHESIM_PF_STREAM == PF_STREAM, "prefetcher values");
+_Static_assert(CACHESIM_WRITE_BACK == WRITE_BACK && CACHESIM_WRITE_THROUGH == WRITE_THROUGH &&
+               CACHESIM_WRITE_ONCE == WRITE_ONCE, "write policy values");
+_Static_assert(CACHESIM_INSTRUCTION == INSTRUCTION_CACHE && CACHESIM_DATA == DATA_CACHE,
+               "cache values");
+
+/* Cachesim function prototypes -------------------------------------------------*/
+/** @addtogroup Cachesim_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Version of the API the library was built with.
+  * @retval     CACHESIM_API_VERSION of the library.
+  */
+int cachesim_api_version(void)
+{
+    return CACHESIM_API_VERSION;
+}
+
+/**
+  * @brief      Fill a configuration with the defaults of prog.
+  * @param      config: pointer to the configuration.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cachesim_config_init(cachesim_config_t* config)
+{
+    sim_config_t defaults;
+    if(config == NULL || sim_config_init(&defaults) < 0)
+    {
+        return ERROR;
+    }
+    memset(config, 0, sizeof(cachesim_config_t));
+    config->cores = 0;
+    config->l2_sets = defaults.l2_sets;
+    config->l2_ways = defaults.l2_ways;
+    config->prefetch = defaults.prefetch_type;
+    config->prefetch_degree = defaults.prefetch_degree;
+    config->mshr_window = defaults.mshr_window;
+    config->write_policy = defaults.write_policy;
+    config->write_allocate = defaults.write_allocate;
+    memcpy(config->latencies, defaults.latencies, sizeof(config->latencies));
+    config->log_mode = defaults.mode;
+    memcpy(config->l1_sets, defaults.l1_sets, sizeof(config->l1_sets));
+    memcpy(config->l1_ways, defaults.l1_ways, sizeof(config->l1_ways));
+    config->line_size = defaults.line_size;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Create a simulator.
+  * @param      config: configuration.
+  * @param      log_path: log file of CACHESIM_PRINT, NULL for none.
+  * @retval     handle of the simulator, NULL if failed.
+  */
+cachesim_t* cachesim_create(const cachesim_config_t* config, const char* log_path)
+{
+    sim_config_t sim_config;
+    int i;
+    if(config == NULL || sim_config_init(&sim_config) < 0)
+    {
+        return NULL;
+    }
+    sim_config.mode = config->log_mode;
+    sim_config.cores_num = config->cores ? config->cores : 1;
+    sim_config.coherence = config->cores ? 1 : 0;
+    sim_config.l2_sets = config->l2_sets;
+    sim_config.l2_ways = config->l2_ways;
+    sim_config.prefetch_type = config->prefetch;
+    sim_config.prefetch_degree = config->prefetch_degree;
+    sim_config.victim_entries = config->victim_entries;
+    sim_config.mshr_entries = config->mshr_entries;
+    sim_config.mshr_window = config->mshr_window;
+    sim_config.write_policy = (write_policy_t)config->write_policy;
+    sim_config.write_allocate = config->write_allocate;
+    sim_config.write_buffer_entries = config->write_buffer_entries;
+    sim_config.timing_enabled = config->timing;
+    sim_config.huge_pages = config->huge_pages;
+    //0 keeps the default, for programs built before these fields:
+    for(i = 0; i < 2; i++)
+    {
+        if(config->l1_sets[i] > 0)
+            sim_config.l1_sets[i] = config->l1_sets[i];
+        if(config->l1_ways[i] > 0)
+            sim_config.l1_ways[i] = config->l1_ways[i];
+    }
+    if(config->line_size > 0)
+        sim_config.line_size = config->line_size;
+    memcpy(sim_config.latencies, config->latencies, sizeof(sim_config.latencies));
+    return sim_create(&sim_config, NULL, log_path);
+}
+
+/**
+  * @brief      Simulate an array of accesses, in order.
+  * @param      sim: handle of the simulator.
+  * @param      accesses: array of accesses.
+  * @param      accesses_num: number of accesses.
+  * @retval     number of accesses simulated. ERROR if failed, the accesses
+  *             before the failing one are simulated.
+  */
+int cachesim_access_batch(cachesim_t* sim, const cachesim_access_t* accesses, int accesses_num)
+{
+    int i;
+    if(sim == NULL || (accesses == NULL && accesses_num > 0))
+    {
+        return ERROR;
+    }
+    for(i = 0; i < accesses_num; i++)
+    {
+        if(sim_request(sim, accesses[i].command, accesses[i].address, accesses[i].core) < 0)
+        {
+            return ERROR;
+        }
+    }
+    return accesses_num;
+}
+
+/**
+  * @brief      Read the statistic of one cache.
+  * @param      sim: handle of the simulator.
+  * @param      core: core index, 0 for one core.
+  * @param      cache: CACHESIM_INSTRUCTION or CACHESIM_DATA.
+  * @param      stats: return the counters.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int cachesim_get_stats(cachesim_t* sim, int core, int cache, cachesim_stats_t* stats)
+{
+    cache_stat_t *stat;
+    if(sim == NULL || stats == NULL || core < 0 || core >= sim->config.cores_num)
+    {
+        return ERROR;
+    }
+    if(cache == CACHESIM_INSTRUCTION)
+        stat = &sim->instruction_cache_stats[core];
+    else if(cache == CACHESIM_DATA)
+        stat = &sim->data_cache_stats[core];
+    else
+        return ERROR;
+    stats->read_hits = stat->read_hits;
+    stats->read_misses = stat->read_misses;
+    stats->write_hits = stat->write_hits;
+    stats->write_misses = stat->write_misses;
+    stats->l2_writebacks = stat->l2_writebacks;
+    stats->l2_write_throughs = stat->l2_write_throughs;
+    stats->cycles = stat->cycles;
+    stats->stall_cycles = stat->stall_cycles;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Release a simulator.
+  * @param      sim: handle of the simulator, NULL is ignored.
+  * @retval     None.
+  */
+void cachesim_destroy(cachesim_t* sim)
+{
+    sim_destroy(sim);
+}
+/**
+  * @}
+  */
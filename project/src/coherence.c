@@ -0,0 +1,502 @@
+/**
+  ***********************************************************************
+  * @file       coherence.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Shared L2 directory driver (MESI).
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    In multi-core mode every core owns a private instruction and data
+    L1 cache. The directory is an inclusive L2 shared by all of them:
+    each L2 entry records which cores hold the line in an L1 cache, as
+    one bit per core (uint64_t sharer mask), in flat arrays allocated
+    once. The cache request APIs call the directory on:
+        (+) L1 miss       : directory_read(). Other copies are invalidated
+                            (read for ownership) or downgraded to S.
+        (+) Write to S    : directory_upgrade(), other copies invalidated.
+        (+) L1 replacement: directory_evict(), the core leaves the mask.
+    [..]
+    (#) Create by directory_create(), then directory_attach() the two
+        caches of each core. A cache with a victim buffer cannot be
+        attached, the buffer would hide lines from the directory.
+    (#) L2 evict command of the trace: directory_l2_evict(), every L1
+        copy is invalidated.
+    (#) A line replaced from L2 is also invalidated in every L1 cache
+        (back invalidation, to keep the inclusion).
+    (#) Log the L2 and snoop traffic statistic by directory_log().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#include "coherence.h"
+#include "simd.h"
+
+#define DIR_CORE(X)     ((uint64_t)1 << (X))
+
+
+/* Directory function prototypes -------------------------------------------------*/
+/** @addtogroup Directory_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Create the shared L2 directory.
+  * @param      cores_num: number of cores, 1..DIR_MAX_CORES.
+  * @param      sets_num: number of L2 sets, power of 2.
+  * @param      ways: L2 associativity.
+  * @param      line_size: line size of the L1 caches.
+  * @retval     pointer to the directory, NULL if failed.
+  */
+directory_t* directory_create(int cores_num, int sets_num, int ways, int line_size)
+{
+    if(cores_num <= 0 || cores_num > DIR_MAX_CORES)
+    {
+        printf("Error: Directory supports 1..%d cores.\n", DIR_MAX_CORES);
+        return NULL;
+    }
+    if(sets_num <= 0 || (sets_num & (sets_num - 1)) || ways <= 0)
+    {
+        printf("Error: L2 needs a power of 2 number of sets.\n");
+        return NULL;
+    }
+    directory_t *dir = (directory_t*)calloc(1, sizeof(directory_t));
+    if(dir == NULL)
+    {
+        return NULL;
+    }
+    int entries = sets_num * ways;
+    dir->cores_num = cores_num;
+    dir->sets_num = sets_num;
+    dir->ways = ways;
+    dir->line_bits = log2(line_size);
+    //the SIMD search of the last set may read past it:
+    dir->tags = (uint32_t*)malloc((entries + SIMD_LANES_U32) * sizeof(uint32_t));
+    dir->sharers = (uint64_t*)malloc(entries * sizeof(uint64_t));
+    dir->exclusive = (uint8_t*)malloc(entries * sizeof(uint8_t));
+    dir->stamp = (uint32_t*)malloc(entries * sizeof(uint32_t));
+    if(dir->tags == NULL || dir->sharers == NULL || dir->exclusive == NULL || dir->stamp == NULL)
+    {
+        free(dir->tags);
+        free(dir->sharers);
+        free(dir->exclusive);
+        free(dir->stamp);
+        free(dir);
+        return NULL;
+    }
+    directory_clear(dir);
+    return dir;
+}
+
+/**
+  * @brief      Attach the L1 caches of one core.
+  * @param      dir: pointer to directory.
+  * @param      core: core index.
+  * @param      icache: instruction cache of the core.
+  * @param      dcache: data cache of the core.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int directory_attach(directory_t* dir, int core, cache_t* icache, cache_t* dcache)
+{
+    if(dir == NULL || core < 0 || core >= dir->cores_num)
+    {
+        printf("Error: Invalid core %d.\n", core);
+        return ERROR;
+    }
+    if(icache->victim != NULL || dcache->victim != NULL)
+    {
+        printf("Error: Victim buffers are not supported with coherence.\n");
+        return ERROR;
+    }
+    dir->icaches[core] = icache;
+    dir->dcaches[core] = dcache;
+    icache->directory = dir;
+    icache->core = core;
+    dcache->directory = dir;
+    dcache->core = core;
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Search a line in its L2 set.
+  * @param      dir: pointer to directory.
+  * @param      line: line address.
+  * @retval     entry index if present, otherwise FALSE.
+  */
+static int directory_find(directory_t* dir, uint32_t line)
+{
+    int base = ((line >> dir->line_bits) & (dir->sets_num - 1)) * dir->ways;
+    //entries of the next set never match: their set bits differ.
+    int way = simd_find_u32(dir->tags + base, SIMD_ROUND_U32(dir->ways), line);
+    return (way < 0) ? FALSE : base + way;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Send a snoop to the L1 caches of one core.
+  * @param      dir: pointer to directory.
+  * @param      core: core to snoop.
+  * @param      line: line address.
+  * @param      invalidate: 1 to invalidate the copies, 0 to downgrade them to S.
+  * @retval     DIR_FLUSH if a modified copy was written back, 0 if not.
+  *             ERROR if failed.
+  */
+static int directory_snoop(directory_t* dir, int core, uint32_t line, int invalidate)
+{
+    int ret = 0;
+    int k;
+    cache_t *caches[2] = {dir->icaches[core], dir->dcaches[core]};
+    dir->snoops++;
+    for(k = 0; k < 2; k++)
+    {
+        if(caches[k] == NULL)
+        {
+            continue;
+        }
+        int status = cache_L1_snoop(caches[k], line, invalidate);
+        if(status < 0)
+        {
+            return ERROR;
+        }
+        if(status & BIT(WRITE_L2))
+        {
+            dir->flushes++;
+            ret |= DIR_FLUSH;
+        }
+        if(status & BIT(EVICT_L2_OK))
+        {
+            dir->invalidations++;
+        }
+    }
+    if(!invalidate)
+    {
+        dir->downgrades++;
+    }
+    return ret;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Invalidate the copies of every core in a mask.
+  * @param      dir: pointer to directory.
+  * @param      mask: sharer mask of the cores to snoop.
+  * @param      line: line address.
+  * @retval     DIR_FLUSH if a modified copy was written back, 0 if not.
+  *             ERROR if failed.
+  */
+static int directory_invalidate(directory_t* dir, uint64_t mask, uint32_t line)
+{
+    int ret = 0;
+    while(mask)
+    {
+        int core = __builtin_ctzll(mask);
+        int status = directory_snoop(dir, core, line, 1);
+        if(status < 0)
+        {
+            return ERROR;
+        }
+        ret |= status;
+        mask &= mask - 1;
+    }
+    return ret;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Allocate an L2 entry for a line: an empty way first, otherwise
+  *             the least recently used one. The replaced line is invalidated
+  *             in every L1 cache holding it.
+  * @param      dir: pointer to directory.
+  * @param      line: line address.
+  * @retval     entry index. ERROR if failed.
+  */
+static int directory_allocate(directory_t* dir, uint32_t line)
+{
+    int base = ((line >> dir->line_bits) & (dir->sets_num - 1)) * dir->ways;
+    int i, index = base;
+    for(i = base; i < base + dir->ways; i++)
+    {
+        if(dir->tags[i] == DIR_INVALID_LINE)
+        {
+            index = i;
+            break;
+        }
+        if(dir->clock - dir->stamp[i] > dir->clock - dir->stamp[index])
+        {
+            index = i;
+        }
+    }
+    if(dir->tags[index] != DIR_INVALID_LINE)
+    {
+        dir->l2_evictions++;
+        dir->back_invalidations += __builtin_popcountll(dir->sharers[index]);
+        if(directory_invalidate(dir, dir->sharers[index], dir->tags[index]) < 0)
+        {
+            return ERROR;
+        }
+    }
+    dir->tags[index] = line;
+    dir->sharers[index] = 0;
+    dir->exclusive[index] = 0;
+    return index;
+}
+
+/**
+  * @brief      L1 miss of a core. Find or allocate the line in L2, then
+  *             snoop the other cores holding it.
+  * @param      dir: pointer to directory.
+  * @param      cache: L1 cache requesting the line.
+  * @param      address: byte address.
+  * @param      exclusive: 1 for a read for ownership (write miss):
+  *                        the other copies are invalidated.
+  *                        0 for a read: an E/M copy is downgraded to S.
+  * @retval     DIR_L2_HIT, DIR_SHARED (fill the line in S state),
+  *             DIR_FLUSH bits. ERROR if failed.
+  */
+int directory_read(directory_t* dir, cache_t* cache, uint32_t address, int exclusive)
+{
+    int ret = 0;
+    int status;
+    uint32_t line = address & ~((1U << dir->line_bits) - 1);
+    int i = directory_find(dir, line);
+    if(i != FALSE)
+    {
+        dir->l2_hits++;
+        ret |= DIR_L2_HIT;
+    }
+    else
+    {
+        dir->l2_misses++;
+        i = directory_allocate(dir, line);
+        if(i < 0)
+        {
+            return ERROR;
+        }
+    }
+    dir->stamp[i] = dir->clock++;
+    uint64_t others = dir->sharers[i] & ~DIR_CORE(cache->core);
+    if(others && exclusive)
+    {
+        status = directory_invalidate(dir, others, line);
+        if(status < 0)
+        {
+            return ERROR;
+        }
+        ret |= status;
+        dir->sharers[i] &= ~others;
+    }
+    else if(others)
+    {
+        if(dir->exclusive[i])
+        {
+            //the only other sharer may hold the line in E/M:
+            status = directory_snoop(dir, __builtin_ctzll(others), line, 0);
+            if(status < 0)
+            {
+                return ERROR;
+            }
+            ret |= status;
+        }
+        ret |= DIR_SHARED;
+    }
+    dir->sharers[i] |= DIR_CORE(cache->core);
+    dir->exclusive[i] = !(ret & DIR_SHARED);
+    return ret;
+}
+
+/**
+  * @brief      Write of a core to a line it may share (S state), or write
+  *             without allocate. Every copy of the other cores is invalidated.
+  * @param      dir: pointer to directory.
+  * @param      cache: L1 cache writing the line.
+  * @param      address: byte address.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int directory_upgrade(directory_t* dir, cache_t* cache, uint32_t address)
+{
+    uint32_t line = address & ~((1U << dir->line_bits) - 1);
+    int i = directory_find(dir, line);
+    if(i == FALSE)
+    {
+        //no L1 copy, L2 is inclusive.
+        return SUCCESS;
+    }
+    uint64_t others = dir->sharers[i] & ~DIR_CORE(cache->core);
+    if(dir->sharers[i] & DIR_CORE(cache->core))
+    {
+        dir->upgrades++;
+    }
+    if(directory_invalidate(dir, others, line) < 0)
+    {
+        return ERROR;
+    }
+    dir->sharers[i] &= ~others;
+    dir->exclusive[i] = (dir->sharers[i] != 0);
+    return SUCCESS;
+}
+
+/**
+  * @brief      A line is replaced in an L1 cache. The core leaves the sharer
+  *             mask unless its other L1 cache still holds the line.
+  * @param      dir: pointer to directory.
+  * @param      cache: L1 cache replacing the line.
+  * @param      address: line address.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int directory_evict(directory_t* dir, cache_t* cache, uint32_t address)
+{
+    uint32_t line = address & ~((1U << dir->line_bits) - 1);
+    int i = directory_find(dir, line);
+    if(i == FALSE)
+    {
+        return SUCCESS;
+    }
+    cache_t *sibling = (dir->icaches[cache->core] == cache) ? dir->dcaches[cache->core]
+                                                            : dir->icaches[cache->core];
+    if(sibling != NULL && cache_L1_probe(sibling, line) != FALSE)
+    {
+        return SUCCESS;
+    }
+    dir->sharers[i] &= ~DIR_CORE(cache->core);
+    if(dir->sharers[i] == 0)
+    {
+        dir->exclusive[i] = 0;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Evict command from the trace: the line leaves L2, every L1
+  *             copy is invalidated.
+  * @param      dir: pointer to directory.
+  * @param      address: byte address.
+  * @retval     status of the evict request:
+  *                 @arg    return_t: EVICT_L2_OK if an L1 copy was invalidated,
+  *                         otherwise EVICT_L2_ERROR. ERROR if failed.
+  */
+int directory_l2_evict(directory_t* dir, uint32_t address)
+{
+    return_t ret = 0;
+    uint32_t line = address & ~((1U << dir->line_bits) - 1);
+    int i = directory_find(dir, line);
+    if(i == FALSE || dir->sharers[i] == 0)
+    {
+        ret |= BIT(EVICT_L2_ERROR);
+    }
+    else
+    {
+        ret |= BIT(EVICT_L2_OK);
+    }
+    if(i == FALSE)
+    {
+        printf("Warning: There is no line affected\n");
+        return ret;
+    }
+    if(directory_invalidate(dir, dir->sharers[i], line) < 0)
+    {
+        return ERROR;
+    }
+    dir->tags[i] = DIR_INVALID_LINE;
+    dir->sharers[i] = 0;
+    dir->exclusive[i] = 0;
+    return ret;
+}
+
+/**
+  * @brief      Release the directory. The attached caches are not released.
+  * @param      dir: pointer to directory, NULL is ignored.
+  * @retval     None.
+  */
+void directory_destroy(directory_t* dir)
+{
+    if(dir == NULL)
+    {
+        return;
+    }
+    free(dir->tags);
+    free(dir->sharers);
+    free(dir->exclusive);
+    free(dir->stamp);
+    free(dir);
+}
+
+/**
+  * @brief      Clear all entries and statistic of the directory.
+  *             The attached caches are kept.
+  * @param      dir: pointer to directory.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int directory_clear(directory_t* dir)
+{
+    int i;
+    if(dir == NULL)
+    {
+        return ERROR;
+    }
+    int entries = dir->sets_num * dir->ways;
+    for(i = 0; i < entries + SIMD_LANES_U32; i++)
+    {
+        dir->tags[i] = DIR_INVALID_LINE;
+    }
+    memset(dir->sharers, 0, entries * sizeof(uint64_t));
+    memset(dir->exclusive, 0, entries * sizeof(uint8_t));
+    memset(dir->stamp, 0, entries * sizeof(uint32_t));
+    dir->clock = 0;
+    dir->l2_hits = 0;
+    dir->l2_misses = 0;
+    dir->l2_evictions = 0;
+    dir->snoops = 0;
+    dir->invalidations = 0;
+    dir->back_invalidations = 0;
+    dir->downgrades = 0;
+    dir->flushes = 0;
+    dir->upgrades = 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Log the shared L2 and coherence traffic statistic to file,
+  *             after the cache_log() of every core.
+  *             Nothing is written when the directory is NULL (single core).
+  * @param      dir: pointer to directory.
+  * @param      fp: log file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int directory_log(directory_t* dir, FILE* fp)
+{
+    if(dir == NULL)
+    {
+        return SUCCESS;
+    }
+    if(fp == NULL)
+    {
+        return ERROR;
+    }
+    fprintf(fp, "------------------------------\n");
+    fprintf(fp, "> Shared L2     : %d cores, %d sets, %d-way\n",
+                dir->cores_num, dir->sets_num, dir->ways);
+    fprintf(fp, "> L2 hits       : %d\n", dir->l2_hits);
+    fprintf(fp, "> L2 misses     : %d\n", dir->l2_misses);
+    fprintf(fp, "> L2 evictions  : %d\n", dir->l2_evictions);
+    fprintf(fp, "> Snoops        : %d\n", dir->snoops);
+    fprintf(fp, "> Invalidations : %d\n", dir->invalidations);
+    fprintf(fp, "> Back-invalid. : %d\n", dir->back_invalidations);
+    fprintf(fp, "> Downgrades    : %d\n", dir->downgrades);
+    fprintf(fp, "> Flushes       : %d\n", dir->flushes);
+    fprintf(fp, "> Upgrades      : %d\n", dir->upgrades);
+    fprintf(fp, "------------------------------\n");
+    return SUCCESS;
+}
+/**
+  * @}
+  */
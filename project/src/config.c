@@ -0,0 +1,430 @@
+/**
+  ***********************************************************************
+  * @file       config.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Configuration file driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    The whole simulated hierarchy can be described at run time, without
+    rebuilding: one "key = value" per line, '#' starts a comment.
+        (+) Caches  : l1i.sets, l1i.ways, l1d.sets, l1d.ways (1 set is
+                      fully associative, up to FA_MAX_ENTRIES ways), line (bytes,
+                      every level), sector (bytes of a sector of the L1
+                      lines, 0 for none), l1d.write_policy = wb|wt|once,
+                      l1d.write_allocate = 0|1, l1d.write_buffer, victim,
+                      mshr, mshr_window, prefetch, prefetch_degree,
+                      usage = 0|1 (bytes used of the L1 lines).
+        (+) L2      : cores (> 0 enables the shared L2 with MESI), l2.sets,
+                      l2.ways.
+        (+) Timing  : latency = L1,L2,MEM,WB|default|off.
+        (+) Routing : route = BASE-END:TARGET[,...], see route.c.
+        (+) Engine  : sample = PERIOD,WINDOW[,WARMUP], rle = 0|1,
+                      huge_pages = 0|1, interleave = records in flight,
+                      pipeline = 0|1, decoder and logger threads,
+                      decoders = parser threads of a native trace,
+                      start, end = records replayed (end 0 for all).
+        (+) Export  : stats = FILE|off, stats_format = auto|json|csv|binary,
+                      see stats.c.
+        (+) Trace   : trace_format = auto|native|lackey|dinero|champsim,
+                      see trace.c, miss_trace = FILE|off, the L1 to L2
+                      transactions, see misstrace.c.
+    Example:
+        # 32 KB 8-way data cache, 64 KB instruction cache
+        line = 64
+        l1d.sets = 64
+        l1d.ways = 8
+        l1i.sets = 512
+        l1i.ways = 2
+    [..]
+    (#) Start from sim_config_init(), then config_load() a file and/or
+        config_set_option() "key=value" strings, in command line order.
+    (#) Check the result by sim_config_check(), sim_create() does it too.
+    (#) config_print() writes the configuration in the same format, it
+        can be loaded again.
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "config.h"
+
+
+/* Config function prototypes -------------------------------------------------*/
+/** @addtogroup Config_data_structures
+  * @{
+  */
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Parse a non-negative integer, decimal or 0x hex.
+  * @retval     SUCCESS if the whole value is a number. Otherwise ERROR.
+  */
+static int config_int(const char* value, int* result)
+{
+    char *end;
+    long number = strtol(value, &end, 0);
+    if(end == value || *end != '\0' || number < 0 || number > 0x7fffffff)
+    {
+        return ERROR;
+    }
+    *result = (int)number;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Set one option of a configuration.
+  * @param      config: pointer to the configuration.
+  * @param      key: name of the option, see the header of this file.
+  * @param      value: value of the option.
+  * @retval     SUCCESS if success. Otherwise ERROR, the configuration
+  *             is unchanged.
+  */
+int config_set(sim_config_t* config, const char* key, const char* value)
+{
+    //integer options:
+    static const struct {
+        const char* key;
+        size_t offset;
+    } ints[] = {
+        {"l1i.sets",            offsetof(sim_config_t, l1_sets[INSTRUCTION_CACHE])},
+        {"l1i.ways",            offsetof(sim_config_t, l1_ways[INSTRUCTION_CACHE])},
+        {"l1d.sets",            offsetof(sim_config_t, l1_sets[DATA_CACHE])},
+        {"l1d.ways",            offsetof(sim_config_t, l1_ways[DATA_CACHE])},
+        {"line",                offsetof(sim_config_t, line_size)},
+        {"sector",              offsetof(sim_config_t, sector_size)},
+        {"usage",               offsetof(sim_config_t, line_usage)},
+        {"l1d.write_allocate",  offsetof(sim_config_t, write_allocate)},
+        {"l1d.write_buffer",    offsetof(sim_config_t, write_buffer_entries)},
+        {"victim",              offsetof(sim_config_t, victim_entries)},
+        {"mshr",                offsetof(sim_config_t, mshr_entries)},
+        {"mshr_window",         offsetof(sim_config_t, mshr_window)},
+        {"prefetch_degree",     offsetof(sim_config_t, prefetch_degree)},
+        {"l2.sets",             offsetof(sim_config_t, l2_sets)},
+        {"l2.ways",             offsetof(sim_config_t, l2_ways)},
+        {"rle",                 offsetof(sim_config_t, rle)},
+        {"huge_pages",          offsetof(sim_config_t, huge_pages)},
+        {"interleave",          offsetof(sim_config_t, interleave)},
+        {"pipeline",            offsetof(sim_config_t, pipeline)},
+        {"decoders",            offsetof(sim_config_t, decoders)},
+    };
+    size_t i;
+    int number;
+    if(config == NULL || key == NULL || value == NULL)
+    {
+        return ERROR;
+    }
+    for(i = 0; i < sizeof(ints) / sizeof(ints[0]); i++)
+    {
+        if(strcmp(key, ints[i].key) == 0)
+        {
+            if(config_int(value, &number) < 0)
+            {
+                printf("Error: %s needs a number, not %s.\n", key, value);
+                return ERROR;
+            }
+            *(int*)((char*)config + ints[i].offset) = number;
+            return SUCCESS;
+        }
+    }
+    if(strcmp(key, "cores") == 0)
+    {
+        if(config_int(value, &number) < 0)
+        {
+            printf("Error: %s needs a number, not %s.\n", key, value);
+            return ERROR;
+        }
+        //0: one core without L2 directory.
+        config->cores_num = number ? number : 1;
+        config->coherence = number ? 1 : 0;
+    }
+    else if(strcmp(key, "l1d.write_policy") == 0)
+    {
+        if(strcmp(value, "wb") == 0)
+            config->write_policy = WRITE_BACK;
+        else if(strcmp(value, "wt") == 0)
+            config->write_policy = WRITE_THROUGH;
+        else if(strcmp(value, "once") == 0)
+            config->write_policy = WRITE_ONCE;
+        else
+        {
+            printf("Error: Unknown write policy %s.\n", value);
+            return ERROR;
+        }
+    }
+    else if(strcmp(key, "prefetch") == 0)
+    {
+        int type = prefetch_parse_type(value);
+        if(type == ERROR)
+        {
+            printf("Error: Unknown prefetcher %s.\n", value);
+            return ERROR;
+        }
+        config->prefetch_type = type;
+    }
+    else if(strcmp(key, "latency") == 0)
+    {
+        uint32_t latencies[4];
+        if(strcmp(value, "off") == 0)
+        {
+            config->timing_enabled = 0;
+            return SUCCESS;
+        }
+        if(timing_parse(value, latencies) < 0)
+        {
+            printf("Error: Wrong latency format %s.\n", value);
+            return ERROR;
+        }
+        memcpy(config->latencies, latencies, sizeof(latencies));
+        config->timing_enabled = 1;
+    }
+    else if(strcmp(key, "route") == 0)
+    {
+        if(strlen(value) >= sizeof(config->route_map))
+        {
+            printf("Error: Address map longer than %d characters.\n", SIM_ROUTE_SIZE - 1);
+            return ERROR;
+        }
+        strcpy(config->route_map, value);
+    }
+    else if(strcmp(key, "stats") == 0)
+    {
+        if(strlen(value) >= sizeof(config->stats_path))
+        {
+            printf("Error: Export path longer than %d characters.\n", SIM_PATH_SIZE - 1);
+            return ERROR;
+        }
+        strcpy(config->stats_path, (strcmp(value, "off") == 0) ? "" : value);
+    }
+    else if(strcmp(key, "stats_format") == 0)
+    {
+        int format = stats_parse_format(value);
+        if(format == ERROR)
+        {
+            printf("Error: Unknown export format %s.\n", value);
+            return ERROR;
+        }
+        config->stats_format = format;
+    }
+    else if(strcmp(key, "miss_trace") == 0)
+    {
+        if(strlen(value) >= sizeof(config->miss_trace_path))
+        {
+            printf("Error: Miss trace path longer than %d characters.\n", SIM_PATH_SIZE - 1);
+            return ERROR;
+        }
+        strcpy(config->miss_trace_path, (strcmp(value, "off") == 0) ? "" : value);
+    }
+    else if(strcmp(key, "trace_format") == 0)
+    {
+        int format = trace_parse_format(value);
+        if(format == ERROR)
+        {
+            printf("Error: Unknown trace format %s.\n", value);
+            return ERROR;
+        }
+        config->trace_format = format;
+    }
+    else if(strcmp(key, "start") == 0 || strcmp(key, "end") == 0)
+    {
+        char *end;
+        unsigned long long record = strtoull(value, &end, 0);
+        if(end == value || *end != '\0' || value[0] == '-')
+        {
+            printf("Error: %s needs a record number, not %s.\n", key, value);
+            return ERROR;
+        }
+        if(key[0] == 's')
+            config->trace_start = record;
+        else
+            config->trace_end = record;
+    }
+    else if(strcmp(key, "sample") == 0)
+    {
+        uint32_t period = 0, window = 0, warmup = 0;
+        if(strcmp(value, "off") != 0 && sample_parse(value, &period, &window, &warmup) < 0)
+        {
+            printf("Error: Wrong sampling format %s.\n", value);
+            return ERROR;
+        }
+        config->sample_period = period;
+        config->sample_window = window;
+        config->sample_warmup = warmup;
+    }
+    else
+    {
+        printf("Error: Unknown option %s.\n", key);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Set one option given as "key=value", spaces around the key
+  *             and the value are ignored.
+  * @param      config: pointer to the configuration.
+  * @param      option: input string.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int config_set_option(sim_config_t* config, const char* option)
+{
+    char key[CONFIG_KEY_SIZE];
+    char value[CONFIG_LINE_SIZE];
+    const char *equal = strchr(option, '=');
+    const char *start = option, *end;
+    size_t length;
+    if(equal == NULL)
+    {
+        printf("Error: Option %s is not key=value.\n", option);
+        return ERROR;
+    }
+    //key, trimmed:
+    while(start < equal && isspace((unsigned char)*start))
+        start++;
+    for(end = equal; end > start && isspace((unsigned char)end[-1]); end--);
+    length = end - start;
+    if(length == 0 || length >= sizeof(key))
+    {
+        printf("Error: Wrong option name in %s.\n", option);
+        return ERROR;
+    }
+    memcpy(key, start, length);
+    key[length] = '\0';
+    //value, trimmed:
+    start = equal + 1;
+    while(isspace((unsigned char)*start))
+        start++;
+    for(end = start + strlen(start); end > start && isspace((unsigned char)end[-1]); end--);
+    length = end - start;
+    if(length >= sizeof(value))
+    {
+        printf("Error: Value of %s too long.\n", key);
+        return ERROR;
+    }
+    memcpy(value, start, length);
+    value[length] = '\0';
+    return config_set(config, key, value);
+}
+
+/**
+  * @brief      Load a configuration file over a configuration. All lines
+  *             are read, every wrong line is reported with its number.
+  * @param      config: pointer to the configuration.
+  * @param      path: configuration file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int config_load(sim_config_t* config, const char* path)
+{
+    char line[CONFIG_LINE_SIZE];
+    int number = 0, status = SUCCESS;
+    FILE *fp = fopen(path, "r");
+    if(fp == NULL)
+    {
+        printf("Error: Failed to open file %s.\n", path);
+        return ERROR;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        char *p = line;
+        number++;
+        if(strchr(line, '\n') == NULL && !feof(fp))
+        {
+            printf("Error: %s:%d: line longer than %d characters.\n", path, number, CONFIG_LINE_SIZE - 2);
+            status = ERROR;
+            break;
+        }
+        line[strcspn(line, "#\r\n")] = '\0';
+        while(isspace((unsigned char)*p))
+            p++;
+        if(*p == '\0')
+        {
+            continue;
+        }
+        if(config_set_option(config, p) < 0)
+        {
+            printf("Error: %s:%d: %s\n", path, number, p);
+            status = ERROR;
+        }
+    }
+    fclose(fp);
+    return status;
+}
+
+/**
+  * @brief      Write a configuration as a configuration file.
+  * @param      config: pointer to the configuration.
+  * @param      fp: output file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int config_print(const sim_config_t* config, FILE* fp)
+{
+    static const char* policies[] = {"wb", "wt", "once"};
+    char prefetch[32] = "none";
+    if(config == NULL || fp == NULL)
+    {
+        return ERROR;
+    }
+    if(config->prefetch_type != PF_NONE)
+    {
+        snprintf(prefetch, sizeof(prefetch), "%s%s%s",
+                    (config->prefetch_type & PF_NEXT_LINE) ? ",next" : "",
+                    (config->prefetch_type & PF_STRIDE) ? ",stride" : "",
+                    (config->prefetch_type & PF_STREAM) ? ",stream" : "");
+        memmove(prefetch, prefetch + 1, strlen(prefetch));
+    }
+    fprintf(fp, "cores = %d\n", config->coherence ? config->cores_num : 0);
+    fprintf(fp, "line = %d\n", config->line_size);
+    fprintf(fp, "sector = %d\n", config->sector_size);
+    fprintf(fp, "l1i.sets = %d\n", config->l1_sets[INSTRUCTION_CACHE]);
+    fprintf(fp, "l1i.ways = %d\n", config->l1_ways[INSTRUCTION_CACHE]);
+    fprintf(fp, "l1d.sets = %d\n", config->l1_sets[DATA_CACHE]);
+    fprintf(fp, "l1d.ways = %d\n", config->l1_ways[DATA_CACHE]);
+    fprintf(fp, "l1d.write_policy = %s\n", policies[config->write_policy]);
+    fprintf(fp, "l1d.write_allocate = %d\n", config->write_allocate);
+    fprintf(fp, "l1d.write_buffer = %d\n", config->write_buffer_entries);
+    fprintf(fp, "victim = %d\n", config->victim_entries);
+    fprintf(fp, "mshr = %d\n", config->mshr_entries);
+    fprintf(fp, "mshr_window = %d\n", config->mshr_window);
+    fprintf(fp, "prefetch = %s\n", prefetch);
+    fprintf(fp, "prefetch_degree = %d\n", config->prefetch_degree);
+    fprintf(fp, "usage = %d\n", config->line_usage);
+    fprintf(fp, "l2.sets = %d\n", config->l2_sets);
+    fprintf(fp, "l2.ways = %d\n", config->l2_ways);
+    if(config->timing_enabled)
+        fprintf(fp, "latency = %u,%u,%u,%u\n", config->latencies[0], config->latencies[1],
+                    config->latencies[2], config->latencies[3]);
+    else
+        fprintf(fp, "latency = off\n");
+    if(config->route_map[0] != '\0')
+        fprintf(fp, "route = %s\n", config->route_map);
+    if(config->sample_period > 0)
+        fprintf(fp, "sample = %u,%u,%u\n", config->sample_period, config->sample_window,
+                    config->sample_warmup);
+    else
+        fprintf(fp, "sample = off\n");
+    fprintf(fp, "rle = %d\n", config->rle);
+    fprintf(fp, "huge_pages = %d\n", config->huge_pages);
+    fprintf(fp, "interleave = %d\n", config->interleave);
+    fprintf(fp, "pipeline = %d\n", config->pipeline);
+    fprintf(fp, "decoders = %d\n", config->decoders);
+    fprintf(fp, "start = %llu\n", (unsigned long long)config->trace_start);
+    fprintf(fp, "end = %llu\n", (unsigned long long)config->trace_end);
+    fprintf(fp, "stats = %s\n", (config->stats_path[0] != '\0') ? config->stats_path : "off");
+    fprintf(fp, "stats_format = %s\n", stats_format_name(config->stats_format));
+    fprintf(fp, "trace_format = %s\n", trace_format_name(config->trace_format));
+    fprintf(fp, "miss_trace = %s\n", (config->miss_trace_path[0] != '\0') ? config->miss_trace_path : "off");
+    return SUCCESS;
+}
+/**
+  * @}
+  */
@@ -0,0 +1,309 @@
+/**
+  ***********************************************************************
+  * @file       fullassoc.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Fully-associative table driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    A cache of one set holds any line in any of its ways. Searching the
+    ways and aging their LRU bits is O(ways) per access, and the LRU bits
+    of thousands of ways do not fit in the tag array. The table keeps,
+    for the ways of such a cache:
+        (+) a hash table from the tag of a line to its way, open
+            addressing with linear probing, at most half full.
+        (+) the LRU order, a doubly-linked list through the entries,
+            preallocated: no allocation after fa_create().
+    Lookup, touch, fill and eviction are O(1). create_cache() attaches a
+    table to every cache of one set (cache->fa), the cache request APIs
+    use it instead of the LRU bits, so a fully-associative L1, a TLB or
+    an ideal cache is a geometry of 1 set and up to FA_MAX_ENTRIES ways.
+    [..]
+    (#) Create by fa_create(), release by fa_destroy().
+    (#) fa_lookup() finds the way of a tag, fa_touch() makes it the MRU.
+    (#) For a new line, fa_select() gives a free way, else the LRU one:
+        the caller evicts its line and fa_remove()s it, then
+        fa_insert()s the new tag in the way, as MRU.
+    (#) fa_remove() frees the way of an invalidated line.
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include "cache.h"
+#include "fullassoc.h"
+
+
+/* Fully-associative table function prototypes -------------------------------------------------*/
+/** @addtogroup Fully_associative_data_structures
+  * @{
+  */
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Home bucket of a key (Fibonacci hashing: the high bits of
+  *             the product, the tags of consecutive lines spread).
+  */
+static inline uint32_t fa_hash(fa_table_t* fa, uint32_t key)
+{
+    return (uint32_t)(key * 0x9E3779B1u) >> (32 - fa->buckets_bits);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Take an entry out of the LRU list.
+  */
+static inline void fa_unlink(fa_table_t* fa, int index)
+{
+    fa_entry_t *entry = &fa->entries[index];
+    if(entry->prev != FA_NONE)
+        fa->entries[entry->prev].next = entry->next;
+    else
+        fa->head = entry->next;
+    if(entry->next != FA_NONE)
+        fa->entries[entry->next].prev = entry->prev;
+    else
+        fa->tail = entry->prev;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Put an entry at the MRU end of the LRU list.
+  */
+static inline void fa_push_front(fa_table_t* fa, int index)
+{
+    fa_entry_t *entry = &fa->entries[index];
+    entry->prev = FA_NONE;
+    entry->next = fa->head;
+    if(fa->head != FA_NONE)
+        fa->entries[fa->head].prev = index;
+    else
+        fa->tail = index;
+    fa->head = index;
+}
+
+/**
+  * @brief      Create a fully-associative table, all entries free.
+  * @param      entries_num: number of ways, 1..FA_MAX_ENTRIES.
+  * @retval     pointer to the table, NULL if failed.
+  */
+fa_table_t* fa_create(int entries_num)
+{
+    if(entries_num <= 0 || entries_num > FA_MAX_ENTRIES)
+    {
+        printf("Error: Fully-associative table supports 1..%d entries.\n", FA_MAX_ENTRIES);
+        return NULL;
+    }
+    fa_table_t *fa = (fa_table_t*)malloc(sizeof(fa_table_t));
+    if(fa == NULL)
+    {
+        return NULL;
+    }
+    fa->entries_num = entries_num;
+    //at least twice the entries, the probe sequences stay short:
+    fa->buckets_bits = 1;
+    while((1 << fa->buckets_bits) < 2 * entries_num)
+    {
+        fa->buckets_bits++;
+    }
+    fa->buckets_mask = (1U << fa->buckets_bits) - 1;
+    fa->buckets = (int32_t*)malloc(((size_t)fa->buckets_mask + 1) * sizeof(int32_t));
+    fa->entries = (fa_entry_t*)malloc(entries_num * sizeof(fa_entry_t));
+    if(fa->buckets == NULL || fa->entries == NULL)
+    {
+        fa_destroy(fa);
+        return NULL;
+    }
+    fa_clear(fa);
+    return fa;
+}
+
+/**
+  * @brief      Search the entry holding a key.
+  * @param      fa: pointer to the table.
+  * @param      key: tag of the line.
+  * @retval     index of the entry if present, otherwise FALSE.
+  */
+int fa_lookup(fa_table_t* fa, uint32_t key)
+{
+    uint32_t bucket = fa_hash(fa, key);
+    int32_t index;
+    while((index = fa->buckets[bucket]) != FA_NONE)
+    {
+        if(fa->entries[index].key == key)
+        {
+            return index;
+        }
+        bucket = (bucket + 1) & fa->buckets_mask;
+    }
+    return FALSE;
+}
+
+/**
+  * @brief      Make a used entry the most recently used one.
+  * @param      fa: pointer to the table.
+  * @param      index: the entry.
+  * @retval     None.
+  */
+void fa_touch(fa_table_t* fa, int index)
+{
+    if(fa->head == index)
+    {
+        return;
+    }
+    fa_unlink(fa, index);
+    fa_push_front(fa, index);
+}
+
+/**
+  * @brief      Select the entry for a new line: a free entry first,
+  *             otherwise the least recently used one.
+  *             Note: a used entry must be fa_remove()d (after the caller
+  *             evicted its line) before fa_insert().
+  * @param      fa: pointer to the table.
+  * @retval     index of the entry.
+  */
+int fa_select(fa_table_t* fa)
+{
+    return (fa->free != FA_NONE) ? fa->free : fa->tail;
+}
+
+/**
+  * @brief      Place a key in the entry given by fa_select(), as the most
+  *             recently used entry.
+  * @param      fa: pointer to the table.
+  * @param      index: the entry, free.
+  * @param      key: tag of the new line, not in the table.
+  * @retval     SUCCESS, ERROR if the entry is not the one to fill.
+  */
+int fa_insert(fa_table_t* fa, int index, uint32_t key)
+{
+    uint32_t bucket = fa_hash(fa, key);
+    if(index != fa->free)
+    {
+        printf("Error: Entry %d of the fully-associative table is not free.\n", index);
+        return ERROR;
+    }
+    fa->free = fa->entries[index].next;
+    while(fa->buckets[bucket] != FA_NONE)
+    {
+        bucket = (bucket + 1) & fa->buckets_mask;
+    }
+    fa->buckets[bucket] = index;
+    fa->entries[index].key = key;
+    fa_push_front(fa, index);
+    fa->used++;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Free an entry: its key leaves the hash table and the entry
+  *             the LRU list. A free entry is ignored.
+  * @param      fa: pointer to the table.
+  * @param      index: the entry.
+  * @retval     None.
+  */
+void fa_remove(fa_table_t* fa, int index)
+{
+    uint32_t hole, bucket, home;
+    int32_t moved;
+    if(fa->entries[index].prev == FA_FREE)
+    {
+        return;
+    }
+    hole = fa_hash(fa, fa->entries[index].key);
+    while(fa->buckets[hole] != index)
+    {
+        hole = (hole + 1) & fa->buckets_mask;
+    }
+    //shift back the keys of the run that can move closer to their home:
+    bucket = hole;
+    while(1)
+    {
+        bucket = (bucket + 1) & fa->buckets_mask;
+        moved = fa->buckets[bucket];
+        if(moved == FA_NONE)
+        {
+            break;
+        }
+        home = fa_hash(fa, fa->entries[moved].key);
+        if(((bucket - home) & fa->buckets_mask) >= ((bucket - hole) & fa->buckets_mask))
+        {
+            fa->buckets[hole] = moved;
+            hole = bucket;
+        }
+    }
+    fa->buckets[hole] = FA_NONE;
+    fa_unlink(fa, index);
+    fa->entries[index].prev = FA_FREE;
+    fa->entries[index].next = fa->free;
+    fa->free = index;
+    fa->used--;
+}
+
+/**
+  * @brief      Prefetch into the host caches the home bucket of a key, see
+  *             cache_L1_host_prefetch(). No state changes.
+  * @param      fa: pointer to the table.
+  * @param      key: tag of the line.
+  * @retval     None.
+  */
+void fa_host_prefetch(fa_table_t* fa, uint32_t key)
+{
+    __builtin_prefetch(&fa->buckets[fa_hash(fa, key)], 0);
+}
+
+/**
+  * @brief      Free every entry. The free entries are taken in index order.
+  * @param      fa: pointer to the table.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int fa_clear(fa_table_t* fa)
+{
+    int i;
+    if(fa == NULL)
+    {
+        return ERROR;
+    }
+    for(i = 0; i <= (int)fa->buckets_mask; i++)
+    {
+        fa->buckets[i] = FA_NONE;
+    }
+    for(i = 0; i < fa->entries_num; i++)
+    {
+        fa->entries[i].key = 0;
+        fa->entries[i].prev = FA_FREE;
+        fa->entries[i].next = (i + 1 < fa->entries_num) ? i + 1 : FA_NONE;
+    }
+    fa->head = FA_NONE;
+    fa->tail = FA_NONE;
+    fa->free = 0;
+    fa->used = 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Release a table.
+  * @param      fa: pointer to the table, NULL is ignored.
+  * @retval     None.
+  */
+void fa_destroy(fa_table_t* fa)
+{
+    if(fa == NULL)
+    {
+        return;
+    }
+    free(fa->buckets);
+    free(fa->entries);
+    free(fa);
+}
+/**
+  * @}
+  */
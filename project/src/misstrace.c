@@ -0,0 +1,167 @@
+/**
+  ***********************************************************************
+  * @file       misstrace.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      L1 to L2 transaction trace driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    Studies of L2 and below only need what the L1 caches send to L2,
+    usually 10 to 100 times less than the trace. This driver writes that
+    stream as a trace of the project, so it can be replayed by prog (or
+    by another L2/L3/DRAM model) without simulating L1 again:
+        (+) line read (READ_L2, PREFETCH_L2): "0 <line address> <core> 1 r"
+            from a data cache, "2 <line address> <core> 1 r" from an
+            instruction cache.
+        (+) read for ownership (READ_L2_OWN): "1 <line address> <core> 1 o".
+        (+) writeback (WRITE_L2): "1 <line address> <core> 1 w", the
+            victim line.
+        (+) write-through (WRITE_L2_THROUGH): "1 <byte address> <core> 1 t".
+    The commands are the ones of a native trace, so prog replays it (the
+    fifth field, the transaction type, is ignored: the three writes look
+    alike). An L2 model reads the type, see misstrace_type_t.
+    Misses served by the victim buffer or merged by an MSHR do not reach
+    L2 and are not written, neither are the accesses of functional
+    warming (sampling).
+    The records are the requests of L1, before the write buffer.
+    [..]
+    (#) Create the writer by misstrace_create(), the file is truncated.
+    (#) Attach it to the caches by cache_set_misstrace(), they write
+        their transactions by misstrace_write().
+    (#) Everything goes through one buffer of MISSTRACE_BUFFER_SIZE bytes,
+        misstrace_flush() writes it, misstrace_destroy() flushes and
+        closes.
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#include "misstrace.h"
+
+
+/* Miss trace function prototypes -------------------------------------------------*/
+/** @addtogroup Miss_trace_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Create a miss trace writer.
+  * @param      path: output trace, truncated.
+  * @retval     pointer to the writer, NULL if failed.
+  */
+misstrace_t* misstrace_create(const char* path)
+{
+    misstrace_t *mt;
+    if(path == NULL)
+    {
+        return NULL;
+    }
+    mt = (misstrace_t*)malloc(sizeof(misstrace_t));
+    if(mt == NULL)
+    {
+        printf("Error: Cannot create miss trace.\n");
+        return NULL;
+    }
+    mt->records = 0;
+    mt->used = 0;
+    mt->fp = fopen(path, "w");
+    if(mt->fp == NULL)
+    {
+        printf("Error: Failed to open file %s.\n", path);
+        free(mt);
+        return NULL;
+    }
+    //the buffer above is the only one:
+    setvbuf(mt->fp, NULL, _IONBF, 0);
+    return mt;
+}
+
+/**
+  * @brief      Append one transaction,
+  *             "<command> <address in hex> <core> 1 <type>".
+  * @param      mt: pointer to the writer.
+  * @param      command: READ_DATA, WRITE_DATA or INSTRUCTION_FETCH.
+  * @param      type: the transaction, see misstrace_type_t.
+  * @param      address: line address, byte address of a write-through.
+  * @param      core: core of the cache.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int misstrace_write(misstrace_t* mt, int command, misstrace_type_t type, uint32_t address, int core)
+{
+    static const char digits[] = "0123456789abcdef";
+    static const char types[] = "rowt";
+    char *p;
+    int shift;
+    if(mt->used + MISSTRACE_RECORD_SIZE > sizeof(mt->buffer) && misstrace_flush(mt) < 0)
+    {
+        return ERROR;
+    }
+    p = mt->buffer + mt->used;
+    *p++ = (char)('0' + command);
+    *p++ = ' ';
+    //hex without leading zeros, like "%x":
+    for(shift = 28; shift > 0 && (address >> shift) == 0; shift -= 4);
+    for(; shift >= 0; shift -= 4)
+    {
+        *p++ = digits[(address >> shift) & 0xf];
+    }
+    //the core and the count come first, the type is the fifth field:
+    *p++ = ' ';
+    if(core >= 10)
+    {
+        *p++ = (char)('0' + core / 10);
+    }
+    *p++ = (char)('0' + core % 10);
+    *p++ = ' ';
+    *p++ = '1';
+    *p++ = ' ';
+    *p++ = types[type];
+    *p++ = '\n';
+    mt->used = p - mt->buffer;
+    mt->records++;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Write the buffer to the file.
+  * @param      mt: pointer to the writer.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int misstrace_flush(misstrace_t* mt)
+{
+    if(mt->used > 0 && fwrite(mt->buffer, 1, mt->used, mt->fp) != mt->used)
+    {
+        printf("Error: Cannot write the miss trace.\n");
+        return ERROR;
+    }
+    mt->used = 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Flush and close a writer.
+  * @param      mt: pointer to the writer, NULL is ignored.
+  * @retval     None.
+  */
+void misstrace_destroy(misstrace_t* mt)
+{
+    if(mt == NULL)
+    {
+        return;
+    }
+    misstrace_flush(mt);
+    fclose(mt->fp);
+    free(mt);
+}
+/**
+  * @}
+  */
@@ -0,0 +1,212 @@
+/**
+  ***********************************************************************
+  * @file       mshr.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Miss-status holding register driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    Attach an MSHR table to a cache by setting cache->mshr. The cache
+    request APIs tick it once per read/write and check it on every miss:
+        (+) Line outstanding  : the miss is merged (return bit MSHR_MERGE),
+                                L2 is not read again and no latency is
+                                added to the L1 hit of the access.
+        (+) Line not present  : an entry is allocated and L2 is read.
+                                If all entries are busy the oldest one
+                                is reused and counted as full.
+    [..]
+    (#) Create by mshr_create(), entries_num <= MSHR_MAX_ENTRIES.
+    (#) Lookup is a SIMD compare over the line address array.
+    (#) The cache drops the entries of a line it replaces or invalidates
+        by mshr_release(): the fill is not outstanding any more, and a
+        later miss to the line reads L2 again.
+    (#) Log the statistic next to cache_log() by mshr_log().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include "cache.h"
+#include "mshr.h"
+#include "simd.h"
+
+
+/* MSHR function prototypes -------------------------------------------------*/
+/** @addtogroup MSHR_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Create an MSHR table.
+  * @param      entries_num: number of registers, 1..MSHR_MAX_ENTRIES.
+  * @param      window: number of cache accesses a miss stays outstanding.
+  * @retval     pointer to the MSHR table, NULL if failed.
+  */
+mshr_t* mshr_create(int entries_num, uint32_t window)
+{
+    if(entries_num <= 0 || entries_num > MSHR_MAX_ENTRIES || window == 0)
+    {
+        printf("Error: MSHR supports 1..%d entries and window > 0.\n", MSHR_MAX_ENTRIES);
+        return NULL;
+    }
+    mshr_t *mshr = (mshr_t*)malloc(sizeof(mshr_t));
+    if(mshr == NULL)
+    {
+        return NULL;
+    }
+    mshr->entries_num = entries_num;
+    mshr->window = window;
+    mshr_clear(mshr);
+    return mshr;
+}
+
+/**
+  * @brief      Advance the MSHR clock by one cache access.
+  * @param      mshr: pointer to MSHR table.
+  * @retval     None.
+  */
+void mshr_tick(mshr_t* mshr)
+{
+    mshr->now++;
+}
+
+/**
+  * @brief      Search an outstanding miss to a line.
+  * @param      mshr: pointer to MSHR table.
+  * @param      line: line address.
+  * @retval     index of the register if the miss is outstanding, otherwise FALSE.
+  */
+int mshr_lookup(mshr_t* mshr, uint32_t line)
+{
+    int index = simd_find_u32(mshr->lines, SIMD_ROUND_U32(mshr->entries_num), line);
+    if(index < 0 || mshr->now - mshr->issue[index] >= mshr->window)
+    {
+        return FALSE;
+    }
+    mshr->merges++;
+    return index;
+}
+
+/**
+  * @brief      Allocate a register for a new miss.
+  *             Reuse the register of the same line or a retired one,
+  *             otherwise take the oldest and count the table as full.
+  * @param      mshr: pointer to MSHR table.
+  * @param      line: line address.
+  * @retval     index of the register.
+  */
+int mshr_allocate(mshr_t* mshr, uint32_t line)
+{
+    int i;
+    int index = simd_find_u32(mshr->lines, SIMD_ROUND_U32(mshr->entries_num), line);
+    if(index < 0)
+    {
+        index = 0;
+        for(i = 0; i < mshr->entries_num; i++)
+        {
+            if(mshr->now - mshr->issue[i] > mshr->now - mshr->issue[index])
+            {
+                index = i;
+            }
+        }
+        if(mshr->lines[index] != MSHR_INVALID_LINE &&
+           mshr->now - mshr->issue[index] < mshr->window)
+        {
+            mshr->full++;
+        }
+    }
+    mshr->lines[index] = line;
+    mshr->issue[index] = mshr->now;
+    mshr->allocations++;
+    return index;
+}
+
+/**
+  * @brief      Drop the registers of a line that leaves the cache.
+  * @param      mshr: pointer to MSHR table.
+  * @param      line: line address.
+  * @param      mask: address bits compared, so that every sector of the
+  *             line is dropped.
+  * @retval     None.
+  */
+void mshr_release(mshr_t* mshr, uint32_t line, uint32_t mask)
+{
+    int i;
+    for(i = 0; i < mshr->entries_num; i++)
+    {
+        if(mshr->lines[i] != MSHR_INVALID_LINE && (mshr->lines[i] & mask) == line)
+        {
+            mshr->lines[i] = MSHR_INVALID_LINE;
+            mshr->issue[i] = 0;
+        }
+    }
+}
+
+/**
+  * @brief      Release an MSHR table.
+  * @param      mshr: pointer to MSHR table, NULL is ignored.
+  * @retval     None.
+  */
+void mshr_destroy(mshr_t* mshr)
+{
+    free(mshr);
+}
+
+/**
+  * @brief      Clear all registers and statistic of the MSHR table.
+  * @param      mshr: pointer to MSHR table.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int mshr_clear(mshr_t* mshr)
+{
+    int i;
+    if(mshr == NULL)
+    {
+        return ERROR;
+    }
+    mshr->now = mshr->window;
+    for(i = 0; i < MSHR_MAX_ENTRIES; i++)
+    {
+        mshr->lines[i] = MSHR_INVALID_LINE;
+        mshr->issue[i] = 0;
+    }
+    mshr->allocations = 0;
+    mshr->merges = 0;
+    mshr->full = 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Log MSHR statistic to file, right after cache_log().
+  *             Nothing is written when the table is NULL (disabled).
+  * @param      mshr: pointer to MSHR table.
+  * @param      fp: log file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int mshr_log(mshr_t* mshr, FILE* fp)
+{
+    if(mshr == NULL)
+    {
+        return SUCCESS;
+    }
+    if(fp == NULL)
+    {
+        return ERROR;
+    }
+    fprintf(fp, "> MSHR          : %d entries, window %u\n", mshr->entries_num, mshr->window);
+    fprintf(fp, "> MSHR allocs   : %d\n", mshr->allocations);
+    fprintf(fp, "> MSHR merges   : %d\n", mshr->merges);
+    fprintf(fp, "> MSHR full     : %d\n", mshr->full);
+    fprintf(fp, "------------------------------\n");
+    return SUCCESS;
+}
+/**
+  * @}
+  */
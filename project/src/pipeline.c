@@ -0,0 +1,601 @@
+/**
+  ***********************************************************************
+  * @file       pipeline.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Simulation pipeline driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    Without it one thread parses the trace, simulates and formats the
+    log, and waits for every read and write of the files. The pipeline
+    runs three stages on their own threads:
+        (+) decoder   : reads the trace by trace_read() into batches of
+                        PIPELINE_BATCH records. A native trace in a file
+                        can be parsed by several decoders instead: the
+                        file is mapped and cut in chunks of about
+                        PIPELINE_TEXT_CHUNK bytes after a new line, chunk
+                        i is parsed by decoder i % decoders into its own
+                        ring (trace_parse_text()).
+        (+) simulation: the thread calling sim_step_batch(), takes the
+                        records of the batches in trace order.
+        (+) logger    : writes the log and the miss trace. The simulation
+                        formats them as before into streams of this
+                        driver, which hand chunks of PIPELINE_CHUNK_SIZE
+                        bytes to the logger instead of the files.
+    The stages are connected by single-producer/single-consumer rings of
+    PIPELINE_SLOTS slots, lock-free: each index is written by one thread
+    only (release) and read by the other (acquire), and the two indexes
+    are on different host cache lines. A slot is filled in place, so a
+    batch or a chunk is never copied again. When a ring is full its
+    producer waits (backpressure), so the decoder is never more than
+    PIPELINE_SLOTS batches ahead and the output in flight is bounded.
+    The order of the records and of the bytes of each file is kept (the
+    simulation takes the chunks from the decoders in turn, so the print
+    and clear commands stay in place), the results are the same as
+    without the pipeline.
+    [..]
+    (#) Open the trace, then create the pipeline by pipeline_create(), it
+        starts the decoders and the logger. The trace belongs to the
+        decoder until pipeline_destroy().
+    (#) Read the records by pipeline_read() until it returns FALSE.
+    (#) Move an output file to the logger by pipeline_open(), write and
+        close the returned stream instead of the file: closing it closes
+        the file once its chunks are written.
+    (#) Close the streams, then stop the threads by pipeline_destroy().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "pipeline.h"
+
+
+/* Pipeline function prototypes -------------------------------------------------*/
+/** @addtogroup Pipeline_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Initialize an empty ring of PIPELINE_SLOTS slots.
+  * @param      ring: pointer to the ring.
+  * @param      slot_size: bytes of one slot.
+  * @retval     SUCCESS, ERROR if failed.
+  */
+int spsc_ring_init(spsc_ring_t* ring, size_t slot_size)
+{
+    //whole cache lines, so two slots never share one:
+    slot_size = (slot_size + PIPELINE_ALIGN - 1) & ~(size_t)(PIPELINE_ALIGN - 1);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->tail_seen = 0;
+    ring->head_seen = 0;
+    ring->slot_size = slot_size;
+    ring->slots = (uint8_t*)aligned_alloc(PIPELINE_ALIGN, slot_size * PIPELINE_SLOTS);
+    if(ring->slots == NULL)
+    {
+        printf("Error: Cannot create pipeline ring.\n");
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Producer: slot to fill next.
+  * @param      ring: pointer to the ring.
+  * @retval     pointer to the slot, NULL if the ring is full.
+  */
+void* spsc_ring_write_slot(spsc_ring_t* ring)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if(tail - ring->head_seen == PIPELINE_SLOTS)
+    {
+        ring->head_seen = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if(tail - ring->head_seen == PIPELINE_SLOTS)
+        {
+            return NULL;
+        }
+    }
+    return ring->slots + (tail & (PIPELINE_SLOTS - 1)) * ring->slot_size;
+}
+
+/**
+  * @brief      Producer: publish the slot of spsc_ring_write_slot().
+  * @param      ring: pointer to the ring.
+  * @retval     None.
+  */
+void spsc_ring_push(spsc_ring_t* ring)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+/**
+  * @brief      Consumer: oldest slot published.
+  * @param      ring: pointer to the ring.
+  * @retval     pointer to the slot, NULL if the ring is empty.
+  */
+void* spsc_ring_read_slot(spsc_ring_t* ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if(head == ring->tail_seen)
+    {
+        ring->tail_seen = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if(head == ring->tail_seen)
+        {
+            return NULL;
+        }
+    }
+    return ring->slots + (head & (PIPELINE_SLOTS - 1)) * ring->slot_size;
+}
+
+/**
+  * @brief      Consumer: give the slot of spsc_ring_read_slot() back to
+  *             the producer.
+  * @param      ring: pointer to the ring.
+  * @retval     None.
+  */
+void spsc_ring_pop(spsc_ring_t* ring)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/**
+  * @brief      Release the slots of a ring.
+  * @param      ring: pointer to the ring.
+  * @retval     None.
+  */
+void spsc_ring_free(spsc_ring_t* ring)
+{
+    free(ring->slots);
+    ring->slots = NULL;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Wait a little for the other end of a ring: poll first, then
+  *             yield the core, then sleep so an idle stage costs nothing.
+  * @param      spins: polls so far, 0 when the wait starts.
+  */
+static void pipeline_pause(int* spins)
+{
+    static const struct timespec nap = {0, 50000};
+    (*spins)++;
+    if(*spins > 2 * PIPELINE_SPIN)
+        nanosleep(&nap, NULL);
+    else if(*spins > PIPELINE_SPIN)
+        sched_yield();
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Empty batch of a decoder, wait for a free slot.
+  * @retval     pointer to the batch, NULL if pipeline_destroy() stops it.
+  */
+static pipeline_batch_t* pipeline_next_batch(pipeline_decoder_t* decoder)
+{
+    pipeline_batch_t *batch;
+    int spins = 0;
+    while((batch = (pipeline_batch_t*)spsc_ring_write_slot(&decoder->batches)) == NULL)
+    {
+        if(atomic_load_explicit(&decoder->pipeline->stop, memory_order_relaxed))
+        {
+            return NULL;
+        }
+        pipeline_pause(&spins);
+    }
+    batch->count = 0;
+    batch->last = 0;
+    batch->end = 0;
+    return batch;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Decoder thread reading the trace: fill batches until the end
+  *             of the trace or pipeline_destroy().
+  */
+static void* pipeline_decode(void* arg)
+{
+    pipeline_decoder_t *decoder = (pipeline_decoder_t*)arg;
+    int end = 0;
+    while(!end)
+    {
+        pipeline_batch_t *batch = pipeline_next_batch(decoder);
+        if(batch == NULL)
+        {
+            return NULL;
+        }
+        while(batch->count < PIPELINE_BATCH &&
+              trace_read(decoder->pipeline->trace, &batch->records[batch->count]) == TRUE)
+        {
+            batch->count++;
+        }
+        end = batch->end = (batch->count < PIPELINE_BATCH);
+        spsc_ring_push(&decoder->batches);
+    }
+    return NULL;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Decoder thread parsing text: its chunks of the mapped trace,
+  *             each ends with a last batch, maybe empty.
+  */
+static void* pipeline_parse(void* arg)
+{
+    pipeline_decoder_t *decoder = (pipeline_decoder_t*)arg;
+    pipeline_t *pipeline = decoder->pipeline;
+    size_t chunk;
+    for(chunk = decoder->index; chunk < pipeline->chunks_num; chunk += pipeline->decoders_num)
+    {
+        const char *p = pipeline->text + pipeline->bounds[chunk];
+        const char *end = pipeline->text + pipeline->bounds[chunk + 1];
+        int last = 0;
+        while(!last)
+        {
+            pipeline_batch_t *batch = pipeline_next_batch(decoder);
+            if(batch == NULL)
+            {
+                return NULL;
+            }
+            while(batch->count < PIPELINE_BATCH &&
+                  trace_parse_text(&p, end, &batch->records[batch->count]) == TRUE)
+            {
+                batch->count++;
+            }
+            last = batch->last = (p == end);
+            batch->end = last && (chunk == pipeline->chunks_num - 1);
+            spsc_ring_push(&decoder->batches);
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Map a native trace file and cut it in chunks for the
+  *             parsing decoders, from the position of the reader (see
+  *             traceidx_seek()).
+  * @retval     SUCCESS, ERROR if it cannot be mapped (not a regular file):
+  *             one decoder reads it then.
+  */
+static int pipeline_map(pipeline_t* pipeline)
+{
+    struct stat st;
+    off_t start = ftello(pipeline->trace->fp);
+    size_t capacity;
+    void *text;
+    if(start < 0 || fstat(fileno(pipeline->trace->fp), &st) < 0 || !S_ISREG(st.st_mode) ||
+       start >= st.st_size)
+    {
+        return ERROR;
+    }
+    text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(pipeline->trace->fp), 0);
+    if(text == MAP_FAILED)
+    {
+        return ERROR;
+    }
+    madvise(text, st.st_size, MADV_SEQUENTIAL);
+    pipeline->text = (const char*)text;
+    pipeline->text_size = st.st_size;
+    capacity = pipeline->text_size / PIPELINE_TEXT_CHUNK + 2;
+    pipeline->bounds = (size_t*)malloc(capacity * sizeof(size_t));
+    if(pipeline->bounds == NULL)
+    {
+        return ERROR;
+    }
+    pipeline->bounds[0] = start;
+    while((size_t)start < pipeline->text_size)
+    {
+        //a chunk ends after the first new line from its nominal size:
+        size_t next = (size_t)start + PIPELINE_TEXT_CHUNK;
+        if(next >= pipeline->text_size)
+        {
+            next = pipeline->text_size;
+        }
+        else
+        {
+            const char *newline = memchr(pipeline->text + next - 1, '\n', pipeline->text_size - next + 1);
+            next = (newline != NULL) ? (size_t)(newline - pipeline->text) + 1 : pipeline->text_size;
+        }
+        pipeline->bounds[++pipeline->chunks_num] = next;
+        start = next;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Logger thread: write the chunks in order until the one
+  *             without a file.
+  */
+static void* pipeline_log(void* arg)
+{
+    pipeline_t *pipeline = (pipeline_t*)arg;
+    while(1)
+    {
+        pipeline_chunk_t *chunk;
+        int spins = 0;
+        while((chunk = (pipeline_chunk_t*)spsc_ring_read_slot(&pipeline->chunks)) == NULL)
+        {
+            pipeline_pause(&spins);
+        }
+        if(chunk->fp == NULL)
+        {
+            spsc_ring_pop(&pipeline->chunks);
+            break;
+        }
+        if(chunk->length > 0 && fwrite(chunk->data, 1, chunk->length, chunk->fp) != chunk->length)
+        {
+            atomic_store(&pipeline->failed, 1);
+        }
+        if(chunk->close && fclose(chunk->fp) != 0)
+        {
+            atomic_store(&pipeline->failed, 1);
+        }
+        spsc_ring_pop(&pipeline->chunks);
+    }
+    return NULL;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Hand bytes of a file to the logger, in chunks.
+  * @param      close: 1 to close the file after them.
+  */
+static void pipeline_send(pipeline_t* pipeline, FILE* fp, const char* data, size_t length, int close)
+{
+    do
+    {
+        pipeline_chunk_t *chunk;
+        int spins = 0;
+        while((chunk = (pipeline_chunk_t*)spsc_ring_write_slot(&pipeline->chunks)) == NULL)
+        {
+            pipeline_pause(&spins);
+        }
+        chunk->fp = fp;
+        chunk->length = (length > PIPELINE_CHUNK_SIZE) ? PIPELINE_CHUNK_SIZE : length;
+        if(chunk->length > 0)
+        {
+            memcpy(chunk->data, data, chunk->length);
+        }
+        data += chunk->length;
+        length -= chunk->length;
+        chunk->close = (length == 0) ? close : 0;
+        spsc_ring_push(&pipeline->chunks);
+    } while(length > 0);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Write and close functions of the streams of pipeline_open().
+  *             A write fails once the logger failed to write a file.
+  */
+static ssize_t pipeline_stream_write(void* cookie, const char* buf, size_t size)
+{
+    pipeline_stream_t *stream = (pipeline_stream_t*)cookie;
+    if(atomic_load(&stream->pipeline->failed))
+    {
+        return 0;
+    }
+    if(size > 0)
+    {
+        pipeline_send(stream->pipeline, stream->fp, buf, size, 0);
+    }
+    return size;
+}
+
+static int pipeline_stream_close(void* cookie)
+{
+    pipeline_stream_t *stream = (pipeline_stream_t*)cookie;
+    pipeline_send(stream->pipeline, stream->fp, NULL, 0, 1);
+    free(stream);
+    return 0;
+}
+
+/**
+  * @brief      Create a pipeline and start its decoder and logger threads.
+  * @param      trace: trace read by the decoder, not closed by the pipeline.
+  * @param      decoders: parser threads of a native trace file, 0 or 1 for
+  *                       one decoder reading the trace. Other formats and
+  *                       files that cannot be mapped use one decoder.
+  * @retval     pointer to the pipeline, NULL if failed.
+  */
+pipeline_t* pipeline_create(trace_t* trace, int decoders)
+{
+    int i;
+    if(trace == NULL)
+    {
+        return NULL;
+    }
+    pipeline_t *pipeline = (pipeline_t*)aligned_alloc(PIPELINE_ALIGN,
+        (sizeof(pipeline_t) + PIPELINE_ALIGN - 1) & ~(size_t)(PIPELINE_ALIGN - 1));
+    if(pipeline == NULL)
+    {
+        printf("Error: Cannot create pipeline.\n");
+        return NULL;
+    }
+    memset(pipeline, 0, sizeof(pipeline_t));
+    atomic_init(&pipeline->stop, 0);
+    atomic_init(&pipeline->failed, 0);
+    pipeline->trace = trace;
+    pipeline->decoders_num = 1;
+    if(decoders > 1 && trace->format == TRACE_NATIVE && pipeline_map(pipeline) == SUCCESS)
+    {
+        pipeline->decoders_num = (decoders > PIPELINE_MAX_DECODERS) ? PIPELINE_MAX_DECODERS : decoders;
+    }
+    if(spsc_ring_init(&pipeline->chunks, sizeof(pipeline_chunk_t)) < 0)
+    {
+        pipeline_destroy(pipeline);
+        return NULL;
+    }
+    for(i = 0; i < pipeline->decoders_num; i++)
+    {
+        pipeline_decoder_t *decoder = &pipeline->decoders[i];
+        decoder->pipeline = pipeline;
+        decoder->index = i;
+        if(spsc_ring_init(&decoder->batches, sizeof(pipeline_batch_t)) < 0)
+        {
+            pipeline_destroy(pipeline);
+            return NULL;
+        }
+        if(pthread_create(&decoder->thread, NULL, (pipeline->decoders_num > 1) ? pipeline_parse : pipeline_decode,
+                          decoder) != 0)
+        {
+            printf("Error: Cannot start decoder thread.\n");
+            pipeline_destroy(pipeline);
+            return NULL;
+        }
+        decoder->started = 1;
+    }
+    if(pthread_create(&pipeline->logger, NULL, pipeline_log, pipeline) != 0)
+    {
+        printf("Error: Cannot start logger thread.\n");
+        pipeline_destroy(pipeline);
+        return NULL;
+    }
+    pipeline->logger_started = 1;
+    return pipeline;
+}
+
+/**
+  * @brief      Read the next record of the trace from the decoders, in
+  *             the order of the trace, wait for it if they are behind.
+  * @param      pipeline: pointer to the pipeline.
+  * @param      record: the record read.
+  * @retval     TRUE if a record was read, FALSE at the end of the trace.
+  */
+int pipeline_read(pipeline_t* pipeline, trace_record_t* record)
+{
+    while(1)
+    {
+        if(pipeline->batch == NULL)
+        {
+            int spins = 0;
+            spsc_ring_t *batches = &pipeline->decoders[pipeline->current].batches;
+            while((pipeline->batch = (pipeline_batch_t*)spsc_ring_read_slot(batches)) == NULL)
+            {
+                pipeline_pause(&spins);
+            }
+            pipeline->next = 0;
+        }
+        if(pipeline->next < pipeline->batch->count)
+        {
+            *record = pipeline->batch->records[pipeline->next++];
+            return TRUE;
+        }
+        //the last batch stays, later calls return FALSE too:
+        if(pipeline->batch->end)
+        {
+            return FALSE;
+        }
+        int last = pipeline->batch->last;
+        spsc_ring_pop(&pipeline->decoders[pipeline->current].batches);
+        //the next chunk is on the next decoder:
+        if(last)
+        {
+            pipeline->current = (pipeline->current + 1) % pipeline->decoders_num;
+        }
+        pipeline->batch = NULL;
+    }
+}
+
+/**
+  * @brief      Move an output file to the logger.
+  * @param      pipeline: pointer to the pipeline.
+  * @param      fp: file opened for writing, written and closed by the
+  *                 logger from now on.
+  * @param      buffered: 1 to gather small writes (fprintf) into chunks,
+  *                       0 if the writer already writes large blocks.
+  * @retval     stream to use instead of fp, NULL if failed (fp is then
+  *             still the caller's).
+  */
+FILE* pipeline_open(pipeline_t* pipeline, FILE* fp, int buffered)
+{
+    static const cookie_io_functions_t functions = {
+        .read = NULL,
+        .write = pipeline_stream_write,
+        .seek = NULL,
+        .close = pipeline_stream_close
+    };
+    FILE *stream_fp;
+    if(pipeline == NULL || fp == NULL)
+    {
+        return NULL;
+    }
+    pipeline_stream_t *stream = (pipeline_stream_t*)malloc(sizeof(pipeline_stream_t));
+    if(stream == NULL)
+    {
+        printf("Error: Cannot create pipeline stream.\n");
+        return NULL;
+    }
+    stream->pipeline = pipeline;
+    stream->fp = fp;
+    stream_fp = fopencookie(stream, "w", functions);
+    if(stream_fp == NULL)
+    {
+        printf("Error: Cannot create pipeline stream.\n");
+        free(stream);
+        return NULL;
+    }
+    if(buffered)
+        setvbuf(stream_fp, NULL, _IOFBF, PIPELINE_CHUNK_SIZE);
+    else
+        setvbuf(stream_fp, NULL, _IONBF, 0);
+    return stream_fp;
+}
+
+/**
+  * @brief      Stop the decoder and the logger, and release the pipeline.
+  *             The streams must be closed before, the logger writes
+  *             everything they sent first.
+  * @param      pipeline: pointer to the pipeline, NULL is ignored.
+  * @retval     None.
+  */
+void pipeline_destroy(pipeline_t* pipeline)
+{
+    int i;
+    if(pipeline == NULL)
+    {
+        return;
+    }
+    atomic_store(&pipeline->stop, 1);
+    for(i = 0; i < PIPELINE_MAX_DECODERS; i++)
+    {
+        if(pipeline->decoders[i].started)
+        {
+            pthread_join(pipeline->decoders[i].thread, NULL);
+        }
+        spsc_ring_free(&pipeline->decoders[i].batches);
+    }
+    if(pipeline->logger_started)
+    {
+        pipeline_send(pipeline, NULL, NULL, 0, 1);
+        pthread_join(pipeline->logger, NULL);
+    }
+    spsc_ring_free(&pipeline->chunks);
+    if(pipeline->text != NULL)
+    {
+        munmap((void*)pipeline->text, pipeline->text_size);
+    }
+    free(pipeline->bounds);
+    free(pipeline);
+}
+/**
+  * @}
+  */
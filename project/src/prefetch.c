@@ -0,0 +1,408 @@
+/**
+  ***********************************************************************
+  * @file       prefetch.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Hardware prefetcher models.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    A prefetcher watches the demand accesses of one L1 cache and fills
+    lines ahead of use through cache_L1_prefetch().
+    [..]
+    (#) Initialize an instance by prefetch_init(), choose the enabled
+        prefetchers by a mask of prefetch_type_t (see prefetch_parse_type()).
+    (#) After every cache request, pass its return value to
+        prefetch_update(). It will:
+            (++) Account useful/polluting prefetches from the return bits.
+            (++) Train next-line, stride and stream prefetchers.
+            (++) Push candidate lines into a bounded queue.
+            (++) Drain up to fill_rate lines from the queue into the cache.
+    (#) A demand miss on a line still waiting in the queue is counted as
+        a late prefetch.
+    (#) Log the statistic next to cache_log() by prefetch_log().
+    (#) Reset state and statistic by prefetch_clear().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <string.h>
+#include "prefetch.h"
+
+
+/* Prefetch queue functions **************************************************/
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Push a line into the prefetch queue.
+  *             Lines already in the cache or in the queue are skipped,
+  *             and the request is dropped when the queue is full.
+  * @param      pf: pointer to prefetcher instance.
+  * @param      cache: pointer to cache instance.
+  * @param      line: line address.
+  * @retval     None.
+  */
+static void prefetch_enqueue(prefetch_t* pf, cache_t* cache, uint32_t line)
+{
+    int i;
+    if(cache_L1_probe(cache, line) != FALSE)
+    {
+        return;
+    }
+    for(i = 0; i < pf->queue_count; i++)
+    {
+        if(pf->queue[(pf->queue_head + i) & (PF_QUEUE_SIZE - 1)] == line)
+        {
+            return;
+        }
+    }
+    if(pf->queue_count == PF_QUEUE_SIZE)
+    {
+        pf->dropped++;
+        return;
+    }
+    pf->queue[(pf->queue_head + pf->queue_count) & (PF_QUEUE_SIZE - 1)] = line;
+    pf->queue_count++;
+    pf->issued++;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Cancel a queued line, the demand access fetched it first.
+  * @param      pf: pointer to prefetcher instance.
+  * @param      line: line address.
+  * @retval     TRUE if the line was waiting in the queue. Otherwise FALSE.
+  */
+static int prefetch_cancel(prefetch_t* pf, uint32_t line)
+{
+    int i;
+    for(i = 0; i < pf->queue_count; i++)
+    {
+        int index = (pf->queue_head + i) & (PF_QUEUE_SIZE - 1);
+        if(pf->queue[index] == line)
+        {
+            pf->queue[index] = PF_INVALID_LINE;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/* Prefetcher training functions *********************************************/
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Train the stride table with a demand address.
+  *             Table is indexed by memory region, since there is no PC.
+  * @retval     None.
+  */
+static void prefetch_stride(prefetch_t* pf, cache_t* cache, uint32_t address)
+{
+    uint32_t region = address >> PF_STRIDE_REGION_BITS;
+    uint32_t line = address & ~cache->bytes_mask;
+    stride_entry_t *entry = NULL;
+    int i;
+    for(i = 0; i < PF_STRIDE_ENTRIES; i++)
+    {
+        if(pf->stride_table[i].valid && pf->stride_table[i].region == region)
+        {
+            entry = &pf->stride_table[i];
+            break;
+        }
+    }
+    if(entry == NULL)
+    {
+        //replace entries round robin:
+        entry = &pf->stride_table[pf->stride_victim];
+        pf->stride_victim = (pf->stride_victim + 1) % PF_STRIDE_ENTRIES;
+        entry->valid = 1;
+        entry->region = region;
+        entry->last_addr = address;
+        entry->stride = 0;
+        entry->confidence = 0;
+        return;
+    }
+    int32_t stride = (int32_t)(address - entry->last_addr);
+    if(stride == 0)
+    {
+        return;
+    }
+    if(stride == entry->stride)
+    {
+        if(entry->confidence < 3)
+        {
+            entry->confidence++;
+        }
+    }
+    else
+    {
+        entry->stride = stride;
+        entry->confidence = 0;
+    }
+    entry->last_addr = address;
+    if(entry->confidence >= PF_STRIDE_CONFIDENCE)
+    {
+        for(i = 1; i <= pf->degree; i++)
+        {
+            uint32_t target = (address + i * entry->stride) & ~cache->bytes_mask;
+            if(target != line)
+            {
+                prefetch_enqueue(pf, cache, target);
+            }
+        }
+    }
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Advance the stream buffers with a demand access.
+  *             A miss outside of every stream allocates the LRU buffer.
+  * @retval     None.
+  */
+static void prefetch_stream(prefetch_t* pf, cache_t* cache, uint32_t line, int miss)
+{
+    uint32_t line_size = cache->bytes_mask + 1;
+    stream_buffer_t *stream = NULL;
+    int i;
+    for(i = 0; i < PF_STREAM_BUFFERS; i++)
+    {
+        stream_buffer_t *s = &pf->streams[i];
+        s->lru++;
+        if(s->valid && line >= s->head && line < s->tail)
+        {
+            stream = s;
+        }
+    }
+    if(stream == NULL)
+    {
+        if(!miss)
+        {
+            return;
+        }
+        stream = &pf->streams[0];
+        for(i = 1; i < PF_STREAM_BUFFERS; i++)
+        {
+            if(!pf->streams[i].valid)
+            {
+                stream = &pf->streams[i];
+                break;
+            }
+            if(stream->valid && pf->streams[i].lru > stream->lru)
+            {
+                stream = &pf->streams[i];
+            }
+        }
+        stream->valid = 1;
+        stream->tail = line + line_size;
+    }
+    stream->lru = 0;
+    stream->head = line + line_size;
+    while(stream->tail < stream->head + PF_STREAM_DEPTH * line_size)
+    {
+        prefetch_enqueue(pf, cache, stream->tail);
+        stream->tail += line_size;
+    }
+}
+
+/* Prefetch function prototypes -------------------------------------------------*/
+/** @addtogroup Prefetch_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Initialize a prefetcher instance.
+  * @param      pf: pointer to prefetcher instance, must NOT be NULL.
+  * @param      type: mask of prefetch_type_t, PF_NONE to disable.
+  * @param      degree: number of lines issued by next-line and stride.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int prefetch_init(prefetch_t* pf, int type, int degree)
+{
+    if(pf == NULL || degree <= 0)
+    {
+        printf("Error: Invalid prefetcher config.\n");
+        return ERROR;
+    }
+    memset(pf, 0, sizeof(prefetch_t));
+    pf->type = type;
+    pf->degree = degree;
+    pf->fill_rate = PF_DEFAULT_FILL_RATE;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Convert a list of prefetcher names into a mask.
+  * @param      str: comma separated names: "next", "stride", "stream",
+  *                  or "all", "none".
+  * @retval     mask of prefetch_type_t. ERROR if unknown name.
+  */
+int prefetch_parse_type(const char* str)
+{
+    int type = PF_NONE;
+    char buf[64];
+    char *token, *saveptr;
+    if(str == NULL || strlen(str) >= sizeof(buf))
+    {
+        return ERROR;
+    }
+    strcpy(buf, str);
+    for(token = strtok_r(buf, ",", &saveptr); token != NULL; token = strtok_r(NULL, ",", &saveptr))
+    {
+        if(strcmp(token, "next") == 0)
+            type |= PF_NEXT_LINE;
+        else if(strcmp(token, "stride") == 0)
+            type |= PF_STRIDE;
+        else if(strcmp(token, "stream") == 0)
+            type |= PF_STREAM;
+        else if(strcmp(token, "all") == 0)
+            type |= PF_NEXT_LINE | PF_STRIDE | PF_STREAM;
+        else if(strcmp(token, "none") != 0)
+            return ERROR;
+    }
+    return type;
+}
+
+/**
+  * @brief      Update the prefetcher after a cache request.
+  *             This function should be called after cache_stat_update(),
+  *             with the same return value of the request.
+  * @param      pf: pointer to prefetcher instance.
+  * @param      cache: pointer to the cache that the prefetcher fills.
+  * @param      stat: statistic of that cache, receives the prefetch fills.
+  * @param      address: address of the request.
+  * @param      update: return value of the cache request.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int prefetch_update(prefetch_t* pf, cache_t* cache, cache_stat_t* stat,
+                        uint32_t address, int update)
+{
+    if(pf->type == PF_NONE)
+    {
+        return SUCCESS;
+    }
+    uint32_t line = address & ~cache->bytes_mask;
+    uint32_t line_size = cache->bytes_mask + 1;
+    int miss = update & (BIT(READ_MISS) | BIT(WRITE_MISS));
+    int demand = miss || (update & (BIT(READ_HIT) | BIT(WRITE_HIT)));
+    int i;
+
+    if(update & BIT(PREFETCH_HIT))
+    {
+        pf->useful++;
+    }
+    if(update & BIT(PREFETCH_UNUSED))
+    {
+        pf->polluting++;
+    }
+    if(!demand)
+    {
+        //evict command, nothing to train.
+        return SUCCESS;
+    }
+    if(miss && prefetch_cancel(pf, line) == TRUE)
+    {
+        pf->late++;
+    }
+
+    //Train and issue:
+    if((pf->type & PF_NEXT_LINE) && (miss || (update & BIT(PREFETCH_HIT))))
+    {
+        for(i = 1; i <= pf->degree; i++)
+        {
+            prefetch_enqueue(pf, cache, line + i * line_size);
+        }
+    }
+    if(pf->type & PF_STRIDE)
+    {
+        prefetch_stride(pf, cache, address);
+    }
+    if(pf->type & PF_STREAM)
+    {
+        prefetch_stream(pf, cache, line, miss);
+    }
+
+    //Drain the queue into the fill path:
+    for(i = 0; i < pf->fill_rate && pf->queue_count > 0; i++)
+    {
+        uint32_t pf_line = pf->queue[pf->queue_head];
+        pf->queue_head = (pf->queue_head + 1) & (PF_QUEUE_SIZE - 1);
+        pf->queue_count--;
+        if(pf_line == PF_INVALID_LINE)
+        {
+            continue;
+        }
+        int ret = cache_L1_prefetch(cache, pf_line);
+        if(ret < 0)
+        {
+            printf("Error: Prefetch fill failed addr=%x\n", pf_line);
+            return ERROR;
+        }
+        if(ret & BIT(PREFETCH_UNUSED))
+        {
+            pf->polluting++;
+        }
+        if(cache_stat_update(stat, ret, pf_line) < 0)
+        {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Log prefetcher statistic to file, right after cache_log().
+  *             Nothing is written when the prefetcher is disabled.
+  * @param      pf: pointer to prefetcher instance.
+  * @param      fp: log file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int prefetch_log(prefetch_t* pf, FILE* fp)
+{
+    if(pf->type == PF_NONE)
+    {
+        return SUCCESS;
+    }
+    if(fp == NULL)
+    {
+        return ERROR;
+    }
+    fprintf(fp, "> Prefetch      :%s%s%s\n",
+                (pf->type & PF_NEXT_LINE) ? " next-line" : "",
+                (pf->type & PF_STRIDE) ? " stride" : "",
+                (pf->type & PF_STREAM) ? " stream" : "");
+    fprintf(fp, "> PF issued     : %d\n", pf->issued);
+    fprintf(fp, "> PF useful     : %d\n", pf->useful);
+    fprintf(fp, "> PF late       : %d\n", pf->late);
+    fprintf(fp, "> PF polluting  : %d\n", pf->polluting);
+    fprintf(fp, "> PF dropped    : %d\n", pf->dropped);
+    if(pf->issued > 0)
+    {
+        fprintf(fp, "> PF accuracy   : %.1f%%\n", pf->useful * 100.0 / pf->issued);
+    }
+    fprintf(fp, "------------------------------\n");
+    return SUCCESS;
+}
+
+/**
+  * @brief      Clear prefetcher state and statistic, keep the configuration.
+  * @param      pf: pointer to prefetcher instance.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int prefetch_clear(prefetch_t* pf)
+{
+    if(pf == NULL)
+    {
+        printf("Error: Prefetcher is null.\n");
+        return ERROR;
+    }
+    return prefetch_init(pf, pf->type, pf->degree);
+}
+/**
+  * @}
+  */
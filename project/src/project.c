@@ -2,303 +2,389 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include "cache.h"
+#include <getopt.h>
+#include "config.h"
 
 
-//The rest is instruction memory:
-#define INSTR_BASE_ADDR 0x0
-#define INSTR_END_ADDR  0xffffff
-#define INSTRUCTION_CACHE               0
-#define INSTRUCTION_CACHE_ASSOC_WAYS    2
-#define INSTRUCTION_CACHE_NUM_SETS      16*K
-#define INSTRUCTION_CACHE_LINE_SIZE     64
-
-//data memory from 0-> 3/4 * 2^32 -1
-#define DATA_BASE_ADDR  0x1000000
-#define DATA_END_ADDR   0xffffffff
-#define DATA_CACHE                      1
-#define DATA_CACHE_ASSOC_WAYS           4
-#define DATA_CACHE_NUM_SETS             16*K
-#define DATA_CACHE_LINE_SIZE            64
-
 #define MAX_SIZE    512
+#define BATCH_SIZE  4096
 char* log_dir="log/";
 char* log_file_name = "log";
 // char* trace_file_name = "trace.txt" 
-FILE *trace_file;
-FILE *log_file = NULL;
-cache_stat_t instruction_cache_stat, data_cache_stat;
-cache_t *instruction_cache, *data_cache;
-
-int sysInit(char*trace_file_path,char*log_file_name, int mode);
-void sysDenit(void);
-int get_invalidate_cache(uint32_t address);
 
-//Receive all request to cache L1:
-int cache_request(int command, uint32_t address,
-                    cache_stat_t* instr_stat,
-                    cache_stat_t* data_stat);
-
-char *currTime(const char *format);
+char *currTime(const char *format, char *buf, size_t size);
+void usage(char *prog);
 int main(int argc, char**argv)
 {
     char*trace_file_path;
     int mode;
-    if(argc < 2)
-    {
-        printf("Error: Not enough arguments.\n");
-        printf("Usage: %s [input_trace] [mode(optional)]\n", argv[0]);
-        return ERROR;
-    }
-    trace_file_path = argv[1];
-    if(argc == 2)
-    {    
-        mode = 1;
-    }
-    else if (argc == 3)
+    int opt;
+    int print_config = 0;
+    int print_index = 0;
+    sim_config_t config;
+    sim_config_init(&config);
+    static struct option long_options[] = {
+        {"prefetch",        required_argument, 0, 'p'},
+        {"prefetch-degree", required_argument, 0, 'd'},
+        {"victim",          required_argument, 0, 'v'},
+        {"mshr",            required_argument, 0, 'm'},
+        {"mshr-window",     required_argument, 0, 'w'},
+        {"write-policy",    required_argument, 0, 'W'},
+        {"no-write-allocate", no_argument,     0, 'n'},
+        {"write-buffer",    required_argument, 0, 'b'},
+        {"latency",         required_argument, 0, 'l'},
+        {"cores",           required_argument, 0, 'c'},
+        {"l2",              required_argument, 0, 'L'},
+        {"sample",          required_argument, 0, 's'},
+        {"rle",             no_argument,       0, 'r'},
+        {"huge-pages",      no_argument,       0, 'H'},
+        {"route",           required_argument, 0, 'R'},
+        {"config",          required_argument, 0, 'f'},
+        {"option",          required_argument, 0, 'o'},
+        {"print-config",    no_argument,       0, 'P'},
+        {"stats",           required_argument, 0, 'e'},
+        {"stats-format",    required_argument, 0, 'E'},
+        {"interleave",      required_argument, 0, 'i'},
+        {"trace-format",    required_argument, 0, 'T'},
+        {"miss-trace",      required_argument, 0, 'M'},
+        {"pipeline",        no_argument,       0, 'j'},
+        {"decoders",        required_argument, 0, 'D'},
+        {"start",           required_argument, 0, 'S'},
+        {"end",             required_argument, 0, 'U'},
+        {"index",           no_argument,       0, 'X'},
+        {"sector",          required_argument, 0, 'k'},
+        {"usage",           no_argument,       0, 'u'},
+        {0, 0, 0, 0}
+    };
+    while((opt = getopt_long(argc, argv, "p:d:v:m:w:W:nb:l:c:L:s:rHR:f:o:Pe:E:i:T:M:jD:S:U:Xk:u", long_options, NULL)) != -1)
     {
-        if(strlen(argv[2]) > 1 || ((strcmp(argv[2], "1") != 0) && (strcmp(argv[2],"2")!= 0)))
+        if(opt == 'p')
         {
-            printf("Error: Wrong arguments format.\n");
-            printf("Usage: %s [input_trace] [mode(optional)]\n", argv[0]);
-            return ERROR;
-        } 
-        mode = argv[2][0] - '0';
-        
-    }
-    printf("Mode: %d\n",mode);
-    //Initialize 2 cache, trace file, log file.
-    int ret = sysInit(trace_file_path,log_file_name, mode); 
-    if (ret == ERROR)
-    {
-        printf("Error: System Initialize failed!\n");
-        return ERROR;
-    }
-    while(!feof(trace_file))
-    {
-        int command;
-        uint32_t address;
-        fscanf(trace_file, "%d %x",&command, &address);
-        // printf("%d %x\n",command, address);
-        // printf("Requesting...\n");
-        int ret = cache_request(command, address, &instruction_cache_stat, &data_cache_stat);
-        // printf("Request done.\n");
-        if(ret == ERROR)
+            config.prefetch_type = prefetch_parse_type(optarg);
+            if(config.prefetch_type == ERROR)
+            {
+                printf("Error: Unknown prefetcher %s.\n", optarg);
+                usage(argv[0]);
+                return ERROR;
+            }
+        }
+        else if(opt == 'd')
         {
-            printf("Error: Internal error while simulating.\n");
-            return ERROR;
+            config.prefetch_degree = atoi(optarg);
         }
-    }
-    sysDenit();
-    printf("> Finished.\n");
-    return SUCCESS;
-}
-
-int sysInit(char*trace_file_path,char*log_file_name, int mode)
-{
-    printf("> Sys Init...\n");
-    instruction_cache = create_cache(INSTRUCTION_CACHE_NUM_SETS,
-                                     INSTRUCTION_CACHE_ASSOC_WAYS,
-                                     INSTRUCTION_CACHE_LINE_SIZE);
-    if(instruction_cache == NULL)
-    {
-        printf("Error: Cannot create instruction cache.\n");
-        return ERROR;
-    }
-    data_cache = create_cache(DATA_CACHE_NUM_SETS,
-                                DATA_CACHE_ASSOC_WAYS,
-                                DATA_CACHE_LINE_SIZE);
-    if(data_cache == NULL)
-    {
-        printf("Error: Cannot create data cache.\n");
-        return ERROR;
-    }
-
-    trace_file = fopen(trace_file_path, "r");
-    if(trace_file == NULL)
-    {
-        printf("Error: Failed to open file %s.\n", trace_file_path);
-        return ERROR;
-    }
-    char *time_label = currTime("%F_%X");
-    char log_path[MAX_SIZE] = {0};
-    strcat(log_path, log_dir);
-    strcat(log_path, log_file_name);
-    strcat(log_path, time_label);
-    strcat(log_path, ".log");
-    printf("%s\n", log_path);
-    log_file = fopen(log_path, "w");
-    
-    if(cache_stat_init(&instruction_cache_stat, "Instruction", log_file, mode) < 0)
-    {
-        printf("Error: Instruction stat init failed\n");
-        return ERROR;
-    }
-    if(cache_stat_init(&data_cache_stat, "Data", log_file, mode) < 0)
-    {
-        printf("Error: Data stat init failed\n");
-        return ERROR;
-    }
-
-    return SUCCESS;
-}
-void sysDenit(void)
-{
-    printf("> Sys Denit...\n");
-    free(instruction_cache);
-    free(data_cache);
-    fclose(trace_file);
-    if(log_file!= NULL)
-    {
-        fclose(log_file);
-    }
-}
-
-int get_invalidate_cache(uint32_t address)
-{
-    if(address >= DATA_BASE_ADDR && address <= DATA_END_ADDR)
-    {
-        return DATA_CACHE;//indicate the data cache.
-    }
-    if(address >= INSTR_BASE_ADDR && address <= INSTR_END_ADDR)
-    {
-        return INSTRUCTION_CACHE;//indicate the instruction cache.
-    }
-    return ERROR;
-}
-
-//Handle request from trace file:
-int cache_request(int command, uint32_t address, cache_stat_t* instruction_cache_stat, cache_stat_t* data_cache_stat)
-{
-    int update;
-    // printf("%d %x\n",command, address);
-    if(command == READ_DATA)
-    {
-        uint8_t data;
-        update = cache_L1_read(data_cache, address,&data);
-        if(cache_stat_update(data_cache_stat, update, address) < 0)
+        else if(opt == 'v')
         {
-            printf("Error: Stat update failed code=%d!\n", update);
-            return ERROR;
+            config.victim_entries = atoi(optarg);
         }
-        return SUCCESS;
-    }
-    else if(command == WRITE_DATA)
-    {
-        uint8_t data = DUMMY_BYTE;
-        update = cache_L1_write(data_cache, address, data);
-        if(cache_stat_update(data_cache_stat, update, address) < 0)
+        else if(opt == 'm')
         {
-            printf("Error: Stat update failed code=%d!\n", update);
-            return ERROR;
+            config.mshr_entries = atoi(optarg);
         }
-
-    }
-    else if(command == INSTRUCTION_FETCH)
-    {
-        uint8_t data;
-        update = cache_L1_read(instruction_cache, address, &data);
-        if(cache_stat_update(instruction_cache_stat, update, address) < 0)
+        else if(opt == 'w')
         {
-            printf("Error: Stat update failed code=%d!\n", update);
-            return ERROR;
+            config.mshr_window = atoi(optarg);
         }
-    }
-    else if(command == EVICT)
-    {
-        int cache_num = get_invalidate_cache(address);
-        cache_t *cache;
-        cache_stat_t* stat;
-        if(cache_num == DATA_CACHE)
+        else if(opt == 'W')
         {
-            cache = data_cache;
-            stat = data_cache_stat;
-            // update = cache_L2_evict(data_cache, address);
+            if(strcmp(optarg, "wb") == 0)
+                config.write_policy = WRITE_BACK;
+            else if(strcmp(optarg, "wt") == 0)
+                config.write_policy = WRITE_THROUGH;
+            else if(strcmp(optarg, "once") == 0)
+                config.write_policy = WRITE_ONCE;
+            else
+            {
+                printf("Error: Unknown write policy %s.\n", optarg);
+                usage(argv[0]);
+                return ERROR;
+            }
         }
-        else if(cache_num == INSTRUCTION_CACHE)
+        else if(opt == 'n')
         {
-            cache = instruction_cache;
-            stat = instruction_cache_stat;
-            // update = cache_L2_evict(instruction_cache, address);
+            config.write_allocate = 0;
         }
-        else{
-            printf("Error: Unknown cache.\n");
-            return ERROR;
+        else if(opt == 'b')
+        {
+            config.write_buffer_entries = atoi(optarg);
         }
-        update = cache_L2_evict(cache, address);
-        if(cache_stat_update(stat, update, address) < 0)
+        else if(opt == 'l')
         {
-            printf("Error: Stat update failed code=%d!\n", update);
-            return ERROR;
+            if(timing_parse(optarg, config.latencies) < 0)
+            {
+                printf("Error: Wrong latency format %s.\n", optarg);
+                usage(argv[0]);
+                return ERROR;
+            }
+            config.timing_enabled = 1;
         }
-        return SUCCESS;
-        // update = cache_L2_evict()
-    }
-    else if(command == CLEAR_CACHE)
-    {
-        if(cache_L1_clear(data_cache) < 0)
+        else if(opt == 'c')
         {
-            printf("Error: Cannot clear cache: %s\n", data_cache_stat->name);
-            return ERROR;
+            config.cores_num = atoi(optarg);
+            if(config.cores_num <= 0 || config.cores_num > DIR_MAX_CORES)
+            {
+                printf("Error: Number of cores must be 1..%d.\n", DIR_MAX_CORES);
+                usage(argv[0]);
+                return ERROR;
+            }
+            config.coherence = 1;
         }
-
-        if(clear_stat(data_cache_stat) < 0)
+        else if(opt == 'L')
         {
-            printf("Error: Cannot clear cache statistics: %s\n", data_cache_stat->name);
-            return ERROR;
+            if(sscanf(optarg, "%d,%d", &config.l2_sets, &config.l2_ways) != 2)
+            {
+                printf("Error: Wrong L2 format %s.\n", optarg);
+                usage(argv[0]);
+                return ERROR;
+            }
         }
-
-        if(cache_L1_clear(instruction_cache) < 0)
+        else if(opt == 's')
         {
-            printf("Error: Cannot clear cache state: %s\n", instruction_cache_stat->name);
-            return ERROR;
+            if(sample_parse(optarg, &config.sample_period, &config.sample_window,
+                            &config.sample_warmup) < 0)
+            {
+                printf("Error: Wrong sampling format %s.\n", optarg);
+                usage(argv[0]);
+                return ERROR;
+            }
         }
-
-        if(clear_stat(instruction_cache_stat) < 0)
+        else if(opt == 'r')
         {
-            printf("Error: Cannot clear cache statistics: %s\n", instruction_cache_stat->name);
-            return ERROR;
+            config.rle = 1;
         }
-        return SUCCESS;
-    }
-    else if(command == PRINT_CONTENT)
-    {
-        printf("Logged data cache at %d\n",data_cache_stat->count);
-        if(cache_log(data_cache_stat) < 0)
+        else if(opt == 'H')
         {
-            printf("Error: Cannot log cache state: %s\n", data_cache_stat->name);
-            return ERROR;
+            config.huge_pages = 1;
+        }
+        else if(opt == 'R')
+        {
+            if(config_set(&config, "route", optarg) < 0)
+            {
+                usage(argv[0]);
+                return ERROR;
+            }
+        }
+        else if(opt == 'f')
+        {
+            if(config_load(&config, optarg) < 0)
+            {
+                printf("Error: Wrong configuration file %s.\n", optarg);
+                return ERROR;
+            }
+        }
+        else if(opt == 'o')
+        {
+            if(config_set_option(&config, optarg) < 0)
+            {
+                usage(argv[0]);
+                return ERROR;
+            }
+        }
+        else if(opt == 'P')
+        {
+            print_config = 1;
+        }
+        else if(opt == 'i')
+        {
+            config.interleave = atoi(optarg);
+        }
+        else if(opt == 'j')
+        {
+            config.pipeline = 1;
+        }
+        else if(opt == 'D')
+        {
+            config.pipeline = 1;
+            config.decoders = atoi(optarg);
+        }
+        else if(opt == 'S' || opt == 'U')
+        {
+            if(config_set(&config, (opt == 'S') ? "start" : "end", optarg) < 0)
+            {
+                usage(argv[0]);
+                return ERROR;
+            }
+        }
+        else if(opt == 'X')
+        {
+            print_index = 1;
+        }
+        else if(opt == 'k')
+        {
+            config.sector_size = atoi(optarg);
+        }
+        else if(opt == 'u')
+        {
+            config.line_usage = 1;
+        }
+        else if(opt == 'T' || opt == 'M')
+        {
+            if(config_set(&config, (opt == 'T') ? "trace_format" : "miss_trace", optarg) < 0)
+            {
+                usage(argv[0]);
+                return ERROR;
+            }
+        }
+        else if(opt == 'e' || opt == 'E')
+        {
+            if(config_set(&config, (opt == 'e') ? "stats" : "stats_format", optarg) < 0)
+            {
+                usage(argv[0]);
+                return ERROR;
+            }
         }
-        printf("Logged instruction cache at %d\n",instruction_cache_stat->count);
-        if(cache_log(instruction_cache_stat) < 0)
+        else
         {
-            printf("Error: Cannot log cache state: %s\n", instruction_cache_stat->name);
+            usage(argv[0]);
             return ERROR;
         }
-        return SUCCESS;
+    }
+    if(print_config)
+    {
+        config_print(&config, stdout);
+        return sim_config_check(&config);
+    }
+    if(argc - optind < 1)
+    {
+        printf("Error: Not enough arguments.\n");
+        usage(argv[0]);
+        return ERROR;
+    }
+    trace_file_path = argv[optind];
+    if(print_index)
+    {
+        trace_index_t *index = traceidx_open(trace_file_path);
+        int status = traceidx_log(index, stdout);
+        traceidx_destroy(index);
+        return status;
+    }
+    if(argc - optind == 1)
+    {    
+        mode = 1;
+    }
+    else if (argc - optind == 2)
+    {
+        char *mode_arg = argv[optind + 1];
+        if(strlen(mode_arg) > 1 || ((strcmp(mode_arg, "1") != 0) && (strcmp(mode_arg,"2")!= 0)))
+        {
+            printf("Error: Wrong arguments format.\n");
+            usage(argv[0]);
+            return ERROR;
+        } 
+        mode = mode_arg[0] - '0';
+        
     }
     else
     {
-        //do nothing;
-        printf("Error: Unknown command.\n");
-        sysDenit();
+        printf("Error: Too many arguments.\n");
+        usage(argv[0]);
         return ERROR;
     }
-    
+    printf("Mode: %d\n",mode);
+    config.mode = mode;
+    //Initialize the caches, trace file, log file.
+    printf("> Sys Init...\n");
+    char time_label[100];
+    char log_path[MAX_SIZE] = {0};
+    if(currTime("%F_%X", time_label, sizeof(time_label)) == NULL)
+    {
+        time_label[0] = '\0';
+    }
+    snprintf(log_path, sizeof(log_path), "%s%s%s.log", log_dir, log_file_name, time_label);
+    printf("%s\n", log_path);
+    sim_context_t *sim = sim_create(&config, trace_file_path, log_path);
+    if (sim == NULL)
+    {
+        printf("Error: System Initialize failed!\n");
+        return ERROR;
+    }
+    int ret;
+    do
+    {
+        ret = sim_step_batch(sim, BATCH_SIZE);
+    } while(ret > 0);
+    //last snapshot of the export, if any:
+    if(ret != ERROR && sim_export(sim, "exit") < 0)
+    {
+        ret = ERROR;
+    }
+    printf("> Sys Denit...\n");
+    sim_destroy(sim);
+    if(ret == ERROR)
+    {
+        printf("Error: Internal error while simulating.\n");
+        return ERROR;
+    }
+    printf("> Finished.\n");
     return SUCCESS;
 }
 
-char *currTime(const char *format)
+char *currTime(const char *format, char *buf, size_t size)
 {
-    static char buf[100];
     time_t t;
     size_t s;
-    struct tm *tm;
-    /* Nonreentrant */
+    struct tm tm;
     t = time(NULL);
-    tm = localtime(&t);
-    if (tm == NULL)
+    if (localtime_r(&t, &tm) == NULL)
     return NULL;
-    s = strftime(buf, 100, (format != NULL) ? format : "%c", tm);
+    s = strftime(buf, size, (format != NULL) ? format : "%c", &tm);
     return (s == 0) ? NULL : buf;
-}
\ No newline at end of file
+}
+void usage(char *prog)
+{
+    printf("Usage: %s [input_trace] [mode(optional)] [options]\n", prog);
+    printf("Options:\n");
+    printf("  -p, --prefetch=next,stride,stream|all  enable L1 prefetchers.\n");
+    printf("  -d, --prefetch-degree=N                lines issued per trigger (default %d).\n", PF_DEFAULT_DEGREE);
+    printf("  -v, --victim=N                         victim buffer of N lines (max %d).\n", VICTIM_MAX_ENTRIES);
+    printf("  -m, --mshr=N                           N miss-status holding registers (max %d).\n", MSHR_MAX_ENTRIES);
+    printf("  -w, --mshr-window=W                    accesses a miss stays outstanding (default %d).\n", MSHR_DEFAULT_WINDOW);
+    printf("  -W, --write-policy=wb|wt|once          data cache write policy (default once:\n");
+    printf("                                         first write to a line is write-through).\n");
+    printf("  -n, --no-write-allocate                write misses go to L2 only.\n");
+    printf("  -b, --write-buffer=N                   coalescing write buffer of N lines (max %d).\n", WB_MAX_ENTRIES);
+    printf("  -l, --latency=L1,L2,MEM,WB|default     latency model in cycles (default %d,%d,%d,%d).\n",
+                TIMING_DEFAULT_L1_HIT, TIMING_DEFAULT_L2_HIT, TIMING_DEFAULT_MEMORY, TIMING_DEFAULT_WRITEBACK);
+    printf("  -c, --cores=N                          N cores (max %d) with MESI coherence, the\n", DIR_MAX_CORES);
+    printf("                                         trace gives the core as a 3rd field.\n");
+    printf("  -L, --l2=SETS,WAYS                     shared L2 of the cores (default %d,%d).\n",
+                DIR_DEFAULT_L2_SETS, DIR_DEFAULT_L2_WAYS);
+    printf("  -s, --sample=PERIOD,WINDOW[,WARMUP]    sampled simulation: WINDOW accesses measured\n");
+    printf("                                         every PERIOD, after WARMUP detailed ones\n");
+    printf("                                         (default WINDOW), the rest warms the caches.\n");
+    printf("  -r, --rle                              merge consecutive accesses to the same line,\n");
+    printf("                                         repeated hits are applied at once.\n");
+    printf("  -H, --huge-pages                       cache storage on 2 MB pages (hugetlbfs or\n");
+    printf("                                         transparent huge pages, else malloc).\n");
+    printf("  -R, --route=BASE-END:TARGET[,...]      address map, hex addresses, TARGET: i, d,\n");
+    printf("                                         id/di (both, first one reports evicts of\n");
+    printf("                                         absent lines), spm (scratchpad), mmio.\n");
+    printf("  -f, --config=FILE                      load \"key = value\" options (geometry, policies,\n");
+    printf("                                         latencies, routing), see src/config.c.\n");
+    printf("  -o, --option=KEY=VALUE                 one option of the configuration file.\n");
+    printf("  -P, --print-config                     print the configuration, check it and exit.\n");
+    printf("  -e, --stats=FILE                       export every counter at each print (9) and at\n");
+    printf("                                         the end, see src/stats.c.\n");
+    printf("  -E, --stats-format=json|csv|binary     export format (default from the extension,\n");
+    printf("                                         .json, .csv, else binary, appended).\n");
+    printf("  -i, --interleave=N                     read N records ahead and prefetch the host\n");
+    printf("                                         memory of their sets (max %d).\n", SIM_MAX_INFLIGHT);
+    printf("  -T, --trace-format=FORMAT              native, lackey, dinero or champsim (default from\n");
+    printf("                                         the extension .din/.champsimtrace and the text).\n");
+    printf("  -M, --miss-trace=FILE                  write the L1 to L2 transactions (line reads,\n");
+    printf("                                         writebacks, write-throughs) as a new trace,\n");
+    printf("                                         the type (r, o, w, t) in the fifth field.\n");
+    printf("  -j, --pipeline                         decode the trace and write the log on their\n");
+    printf("                                         own threads, overlapped with the simulation.\n");
+    printf("  -D, --decoders=N                       -j with N threads parsing a native trace (max %d).\n",
+           PIPELINE_MAX_DECODERS);
+    printf("  -S, --start=N, -U, --end=N             replay the records N (from 0) to before end only,\n");
+    printf("                                         a native trace jumps there by its index.\n");
+    printf("  -X, --index                            build the index of the trace (<trace>.idx), print\n");
+    printf("                                         its records and print/clear records, and exit.\n");
+    printf("  -k, --sector=N                         L1 lines of N-byte sectors (max %d per line),\n",
+           CACHE_MAX_SECTORS);
+    printf("                                         a miss reads only its sector from L2.\n");
+    printf("  -u, --usage                            log the bytes used of the L1 lines when they\n");
+    printf("                                         leave the cache (histogram).\n");
+    printf("Options apply in order, a later one overrides an earlier one.\n");
+}
@@ -0,0 +1,307 @@
+/**
+  ***********************************************************************
+  * @file       route.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Address map driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    The address map splits the 32-bit address space in regions, kept
+    sorted by base address. A request finds its region by a binary
+    search, O(log n) in the number of regions:
+        (+) cached region: a fetch goes to the instruction cache, a read
+            or write to the data cache, if the region allows that cache.
+            An L2 evict probes every cache allowed in the region, and
+            invalidates the line in each cache holding it.
+        (+) scratchpad and uncached (MMIO) regions: the access goes around
+            the caches, it is only counted in the region.
+    [..]
+    (#) Create an empty map by route_create(), add the regions by
+        route_add(), or by route_parse() from a string:
+            "BASE-END:TARGET[,BASE-END:TARGET...]", addresses in hex,
+            TARGET: i, d, id, di (cached, the first cache is the home of
+            the evicts of lines held nowhere), spm (scratchpad), mmio.
+    (#) Find the region of an address by route_lookup(), NULL if no
+        region holds it. route_cached() tells if it uses a cache,
+        otherwise count the access by route_bypass().
+    (#) Log the map and its counters by route_log(), reset the counters
+        by route_clear(), release it by route_destroy().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#include "route.h"
+
+
+/* Route function prototypes -------------------------------------------------*/
+/** @addtogroup Route_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Create an empty address map.
+  * @retval     pointer to the map, NULL if failed.
+  */
+route_t* route_create(void)
+{
+    route_t *route = (route_t*)malloc(sizeof(route_t));
+    if(route == NULL)
+    {
+        return NULL;
+    }
+    route->regions_num = 0;
+    route->custom = 0;
+    return route;
+}
+
+/**
+  * @brief      Add a region, the map stays sorted.
+  * @param      route: pointer to the map.
+  * @param      base: first byte address of the region.
+  * @param      end: last byte address of the region.
+  * @param      kind: see route_kind_t.
+  * @param      caches: caches allowed to hold the lines, ROUTE_CACHED only.
+  * @param      home: cache reporting the evicts of lines held nowhere.
+  * @retval     SUCCESS if success. Otherwise ERROR (full, overlapping).
+  */
+int route_add(route_t* route, uint32_t base, uint32_t end, route_kind_t kind, uint8_t caches, uint8_t home)
+{
+    int i;
+    if(route == NULL || base > end || route->regions_num >= ROUTE_MAX_REGIONS)
+    {
+        printf("Error: Cannot add region %x-%x (max %d regions).\n", base, end, ROUTE_MAX_REGIONS);
+        return ERROR;
+    }
+    //insertion: move the regions above to the right.
+    for(i = route->regions_num; i > 0 && route->regions[i - 1].base > base; i--)
+    {
+        route->regions[i] = route->regions[i - 1];
+    }
+    if((i > 0 && route->regions[i - 1].end >= base) ||
+       (i < route->regions_num && route->regions[i + 1].base <= end))
+    {
+        //undo, the region overlaps a neighbour:
+        for(; i < route->regions_num; i++)
+        {
+            route->regions[i] = route->regions[i + 1];
+        }
+        printf("Error: Region %x-%x overlaps another region.\n", base, end);
+        return ERROR;
+    }
+    route_region_t *region = &route->regions[i];
+    memset(region, 0, sizeof(route_region_t));
+    region->base = base;
+    region->end = end;
+    region->kind = kind;
+    region->caches = (kind == ROUTE_CACHED) ? caches : 0;
+    region->home = home;
+    route->regions_num++;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Replace the map by "BASE-END:TARGET[,...]", see the header.
+  * @param      route: pointer to the map.
+  * @param      str: input string.
+  * @retval     SUCCESS if success. Otherwise ERROR, the map is then empty.
+  */
+int route_parse(route_t* route, const char* str)
+{
+    const char *p = str;
+    if(route == NULL || str == NULL)
+    {
+        return ERROR;
+    }
+    route->regions_num = 0;
+    route->custom = 1;
+    while(*p != '\0')
+    {
+        uint32_t base, end;
+        char target[ROUTE_TARGET_SIZE];
+        int used;
+        uint8_t caches = 0, home = ROUTE_DATA;
+        route_kind_t kind = ROUTE_CACHED;
+        if(sscanf(p, "%x-%x:%7[a-z]%n", &base, &end, target, &used) != 3)
+        {
+            printf("Error: Wrong region format %s.\n", p);
+            route->regions_num = 0;
+            return ERROR;
+        }
+        if(strcmp(target, "spm") == 0)
+            kind = ROUTE_SCRATCHPAD;
+        else if(strcmp(target, "mmio") == 0)
+            kind = ROUTE_UNCACHED;
+        else if(strcmp(target, "i") == 0 || strcmp(target, "id") == 0 ||
+                strcmp(target, "d") == 0 || strcmp(target, "di") == 0)
+        {
+            home = (target[0] == 'i') ? ROUTE_INSTRUCTION : ROUTE_DATA;
+            caches = BIT(home);
+            if(target[1] != '\0')
+            {
+                caches = BIT(ROUTE_INSTRUCTION) | BIT(ROUTE_DATA);
+            }
+        }
+        else
+        {
+            printf("Error: Unknown region target %s.\n", target);
+            route->regions_num = 0;
+            return ERROR;
+        }
+        if(route_add(route, base, end, kind, caches, home) < 0)
+        {
+            route->regions_num = 0;
+            return ERROR;
+        }
+        p += used;
+        if(*p == ',')
+        {
+            p++;
+        }
+        else if(*p != '\0')
+        {
+            printf("Error: Wrong region separator %s.\n", p);
+            route->regions_num = 0;
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Find the region of an address, binary search.
+  * @param      route: pointer to the map.
+  * @param      address: byte address.
+  * @retval     pointer to the region, NULL if the address is not mapped.
+  */
+route_region_t* route_lookup(route_t* route, uint32_t address)
+{
+    int low = 0, high = route->regions_num - 1;
+    while(low <= high)
+    {
+        int middle = (low + high) / 2;
+        route_region_t *region = &route->regions[middle];
+        if(address < region->base)
+            high = middle - 1;
+        else if(address > region->end)
+            low = middle + 1;
+        else
+            return region;
+    }
+    return NULL;
+}
+
+/**
+  * @brief      Check that an access of a region goes to a cache.
+  * @param      region: region of the access.
+  * @param      cache: ROUTE_INSTRUCTION for a fetch, ROUTE_DATA otherwise.
+  * @retval     TRUE if it goes to the cache, FALSE if it goes around.
+  */
+int route_cached(route_region_t* region, int cache)
+{
+    if(region->kind == ROUTE_CACHED && (region->caches & BIT(cache)))
+    {
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+  * @brief      Count an access going around the caches.
+  * @param      region: region of the access.
+  * @param      command: READ_DATA, WRITE_DATA or INSTRUCTION_FETCH.
+  * @retval     None.
+  */
+void route_bypass(route_region_t* region, int command)
+{
+    if(command == WRITE_DATA)
+        region->writes++;
+    else if(command == INSTRUCTION_FETCH)
+        region->fetches++;
+    else
+        region->reads++;
+}
+
+/**
+  * @brief      Reset the counters of every region.
+  * @param      route: pointer to the map.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int route_clear(route_t* route)
+{
+    int i;
+    if(route == NULL)
+    {
+        return ERROR;
+    }
+    for(i = 0; i < route->regions_num; i++)
+    {
+        route->regions[i].reads = 0;
+        route->regions[i].writes = 0;
+        route->regions[i].fetches = 0;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Release a map.
+  * @param      route: pointer to the map, NULL is ignored.
+  * @retval     None.
+  */
+void route_destroy(route_t* route)
+{
+    free(route);
+}
+
+/**
+  * @brief      Log the regions of a map given by route_parse(), and the
+  *             accesses going around the caches.
+  * @param      route: pointer to the map, NULL logs nothing.
+  * @param      fp: log file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int route_log(route_t* route, FILE* fp)
+{
+    int i;
+    static const char* kinds[] = {"cached", "scratchpad", "uncached"};
+    if(route == NULL || !route->custom)
+    {
+        return SUCCESS;
+    }
+    if(fp == NULL)
+    {
+        return ERROR;
+    }
+    fprintf(fp, "------------------------------\n");
+    fprintf(fp, "> Address map   : %d regions\n", route->regions_num);
+    for(i = 0; i < route->regions_num; i++)
+    {
+        route_region_t *region = &route->regions[i];
+        fprintf(fp, ">   %08x-%08x %s", region->base, region->end, kinds[region->kind]);
+        if(region->kind == ROUTE_CACHED)
+        {
+            fprintf(fp, " (%s%s)", (region->caches & BIT(ROUTE_INSTRUCTION)) ? "I" : "",
+                                   (region->caches & BIT(ROUTE_DATA)) ? "D" : "");
+        }
+        if(region->reads + region->writes + region->fetches > 0)
+        {
+            fprintf(fp, ", around the caches: %llu reads, %llu writes, %llu fetches",
+                        (unsigned long long)region->reads, (unsigned long long)region->writes,
+                        (unsigned long long)region->fetches);
+        }
+        fprintf(fp, "\n");
+    }
+    return SUCCESS;
+}
+/**
+  * @}
+  */
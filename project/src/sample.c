@@ -0,0 +1,284 @@
+/**
+  ***********************************************************************
+  * @file       sample.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Sampled simulation driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    A sampled simulation (SMARTS) simulates only small windows of the
+    trace in detail and fast forwards through the rest. The accesses
+    between the windows still update the caches by cache_L1_warm_read()
+    and cache_L1_warm_write() (functional warming), so every window
+    starts with the same cache content as a full simulation. The hit
+    rate of each window is one sample, the mean of the samples is the
+    estimate and their variance gives the confidence interval.
+    [..]
+    Each period of the trace is split in 3 parts:
+        (+) period - warmup - window accesses: functional warming, no
+            statistic, no log, no latency, no prefetcher training.
+        (+) warmup accesses: detailed simulation, not measured. It warms
+            the small structures (prefetchers, MSHR, write buffer).
+        (+) window accesses: detailed simulation, measured.
+    [..]
+    (#) Create by sample_create(), one estimator per cache.
+    (#) Before each access call sample_next(), it tells which path to
+        use and whether a window opens or closes with the access.
+    (#) Give the counters of each cache to sample_open() before the first
+        access of a window, and to sample_close() after the last one.
+    (#) Log the estimates by sample_log() and sample_log_stat().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cache.h"
+#include "sample.h"
+
+
+/* Sample function prototypes -------------------------------------------------*/
+/** @addtogroup Sample_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Create a sampler.
+  * @param      period: accesses between the start of two windows.
+  * @param      window: measured accesses per period, > 0.
+  * @param      warmup: detailed accesses before each window,
+  *                     window + warmup <= period.
+  * @param      stats_num: number of caches to estimate.
+  * @retval     pointer to the sampler, NULL if failed.
+  */
+sample_t* sample_create(uint32_t period, uint32_t window, uint32_t warmup, int stats_num)
+{
+    if(window == 0 || window > period || warmup > period - window || stats_num <= 0)
+    {
+        printf("Error: Sampling needs 0 < window and window + warmup <= period.\n");
+        return NULL;
+    }
+    sample_t *sample = (sample_t*)malloc(sizeof(sample_t));
+    if(sample == NULL)
+    {
+        return NULL;
+    }
+    sample->period = period;
+    sample->window = window;
+    sample->warmup = warmup;
+    sample->stats_num = stats_num;
+    sample->stats = (sample_stat_t*)malloc(stats_num * sizeof(sample_stat_t));
+    if(sample->stats == NULL)
+    {
+        free(sample);
+        return NULL;
+    }
+    sample_clear(sample);
+    return sample;
+}
+
+/**
+  * @brief      Parse "PERIOD,WINDOW[,WARMUP]", WARMUP is WINDOW if omitted.
+  * @param      str: input string.
+  * @param      period: return the period.
+  * @param      window: return the window.
+  * @param      warmup: return the detailed warming.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int sample_parse(const char* str, uint32_t* period, uint32_t* window, uint32_t* warmup)
+{
+    int fields = sscanf(str, "%u,%u,%u", period, window, warmup);
+    if(fields < 2)
+    {
+        return ERROR;
+    }
+    if(fields == 2)
+    {
+        *warmup = *window;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Advance the sampler by one access.
+  * @param      sample: pointer to the sampler.
+  * @retval     status bits of the access: SAMPLE_DETAILED, SAMPLE_OPEN,
+  *             SAMPLE_CLOSE. 0 for functional warming.
+  */
+int sample_next(sample_t* sample)
+{
+    int status = 0;
+    uint32_t measure = sample->period - sample->window;
+    if(sample->position >= measure - sample->warmup)
+    {
+        status |= SAMPLE_DETAILED;
+        sample->detailed++;
+    }
+    else
+    {
+        sample->warmed++;
+    }
+    if(sample->position == measure)
+    {
+        status |= SAMPLE_OPEN;
+    }
+    sample->position++;
+    if(sample->position == sample->period)
+    {
+        status |= SAMPLE_CLOSE;
+        sample->position = 0;
+    }
+    return status;
+}
+
+/**
+  * @brief      A window opens: keep the counters of one cache.
+  * @param      sample: pointer to the sampler.
+  * @param      index: estimator of the cache.
+  * @param      hits: hits of the cache so far.
+  * @param      accesses: accesses of the cache so far.
+  * @retval     None.
+  */
+void sample_open(sample_t* sample, int index, uint32_t hits, uint32_t accesses)
+{
+    sample->stats[index].start_hits = hits;
+    sample->stats[index].start_accesses = accesses;
+}
+
+/**
+  * @brief      A window closes: add its hit rate to the estimator of one
+  *             cache. A window without access to the cache is no sample.
+  * @param      sample: pointer to the sampler.
+  * @param      index: estimator of the cache.
+  * @param      hits: hits of the cache so far.
+  * @param      accesses: accesses of the cache so far.
+  * @retval     None.
+  */
+void sample_close(sample_t* sample, int index, uint32_t hits, uint32_t accesses)
+{
+    sample_stat_t *stat = &sample->stats[index];
+    uint32_t window_hits = hits - stat->start_hits;
+    uint32_t window_accesses = accesses - stat->start_accesses;
+    if(window_accesses == 0)
+    {
+        return;
+    }
+    double rate = (double)window_hits / window_accesses;
+    double delta = rate - stat->mean;
+    stat->windows++;
+    stat->hits += window_hits;
+    stat->accesses += window_accesses;
+    stat->mean += delta / stat->windows;
+    stat->m2 += delta * (rate - stat->mean);
+}
+
+/**
+  * @brief      Drop all samples and restart at the beginning of a period.
+  * @param      sample: pointer to the sampler.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int sample_clear(sample_t* sample)
+{
+    if(sample == NULL)
+    {
+        return ERROR;
+    }
+    sample->position = 0;
+    sample->warmed = 0;
+    sample->detailed = 0;
+    memset(sample->stats, 0, sample->stats_num * sizeof(sample_stat_t));
+    return SUCCESS;
+}
+
+/**
+  * @brief      Release a sampler.
+  * @param      sample: pointer to the sampler, NULL is ignored.
+  * @retval     None.
+  */
+void sample_destroy(sample_t* sample)
+{
+    if(sample == NULL)
+    {
+        return;
+    }
+    free(sample->stats);
+    free(sample);
+}
+
+/**
+  * @brief      Log the sampling parameters, once before sample_log_stat().
+  * @param      sample: pointer to the sampler, NULL logs nothing.
+  * @param      fp: log file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int sample_log(sample_t* sample, FILE* fp)
+{
+    if(sample == NULL)
+    {
+        return SUCCESS;
+    }
+    if(fp == NULL)
+    {
+        return ERROR;
+    }
+    fprintf(fp, "------------------------------\n");
+    fprintf(fp, "> Sampling      : period %u, window %u, warmup %u\n",
+                sample->period, sample->window, sample->warmup);
+    fprintf(fp, "> Warmed only   : %llu accesses\n", (unsigned long long)sample->warmed);
+    fprintf(fp, "> Detailed      : %llu accesses\n", (unsigned long long)sample->detailed);
+    return SUCCESS;
+}
+
+/**
+  * @brief      Log the hit rate estimate of one cache with its 95% and
+  *             99.7% confidence intervals, and the number of windows
+  *             giving +-SAMPLE_TARGET_ERROR relative error at 99.7%.
+  * @param      sample: pointer to the sampler, NULL logs nothing.
+  * @param      index: estimator of the cache.
+  * @param      name: name of the cache.
+  * @param      fp: log file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int sample_log_stat(sample_t* sample, int index, const char* name, FILE* fp)
+{
+    if(sample == NULL)
+    {
+        return SUCCESS;
+    }
+    if(fp == NULL || index < 0 || index >= sample->stats_num)
+    {
+        return ERROR;
+    }
+    sample_stat_t *stat = &sample->stats[index];
+    fprintf(fp, "> %s: %llu windows, %llu accesses measured\n", name,
+                (unsigned long long)stat->windows, (unsigned long long)stat->accesses);
+    if(stat->windows < 2)
+    {
+        fprintf(fp, ">   Not enough windows for an estimate.\n");
+        return SUCCESS;
+    }
+    double deviation = sqrt(stat->m2 / (stat->windows - 1));
+    double error = deviation / sqrt((double)stat->windows);
+    fprintf(fp, ">   Hit rate    : %.2f%% +- %.2f%% (95%%), +- %.2f%% (99.7%%)\n",
+                stat->mean * 100, SAMPLE_Z_95 * error * 100, SAMPLE_Z_997 * error * 100);
+    if(stat->mean > 0)
+    {
+        //SMARTS: n >= (z * V / e)^2, V the coefficient of variation.
+        double variation = deviation / stat->mean;
+        double needed = ceil(pow(SAMPLE_Z_997 * variation / SAMPLE_TARGET_ERROR, 2));
+        fprintf(fp, ">   Variation   : %.4f, %.0f windows for +-%.0f%% at 99.7%%\n",
+                    variation, needed, SAMPLE_TARGET_ERROR * 100);
+    }
+    return SUCCESS;
+}
+/**
+  * @}
+  */
@@ -0,0 +1,1498 @@
+/**
+  ***********************************************************************
+  * @file       sim.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Simulator context driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    A simulator context owns one complete simulation: the instruction
+    and data L1 caches of every core, their statistic and prefetchers,
+    the optional shared L2 directory and latency model, the trace and
+    the log file. There is no global state, each context can be driven
+    by its own thread.
+    [..]
+    (#) Fill a sim_config_t: sim_config_init() gives the defaults of prog.
+    (#) Create the context by sim_create().
+            (++) trace_path: trace to replay by sim_step_batch(), or NULL
+                 to send the requests by sim_request() only.
+            (++) log_path  : log file of cache_log() and mode 2 messages,
+                 or NULL to keep the statistic in memory only.
+    (#) Replay the trace by sim_step_batch() until it returns 0.
+    (#) With sample_period set, only the windows of each period are
+        simulated in detail, the rest only warms the caches. The hit rate
+        estimates are logged after the statistic.
+    (#) Reads, writes and fetches go to the caches through the address
+        map (route.c): the default map has instruction memory below
+        DATA_BASE_ADDR and data memory above, route_map changes it.
+    (#) The trace is native, or Lackey, DineroIV or ChampSim as told by
+        trace_format (trace.c), a sized access is split at line boundaries.
+    (#) With miss_trace_path set, the transactions of the L1 caches to L2
+        (line reads, writebacks, write-throughs) are written as a new
+        trace (misstrace.c), it can be replayed instead of the original.
+    (#) With trace_start or trace_end set, only these records of the trace
+        are replayed. A native trace jumps to trace_start by its index
+        (traceidx.c), built on the first use.
+    (#) With pipeline set, the trace is decoded by a thread ahead of the
+        simulation (native traces by decoders threads, chunk by chunk),
+        and the log and the miss trace are written by another one
+        (pipeline.c). The results are the same.
+    (#) With stats_path set, every PRINT_CONTENT also writes a snapshot of
+        all counters to the export file (stats.c), sim_export() writes one
+        more, e.g. at the end of the run.
+    (#) Or send one request by sim_request() (same commands as the trace),
+        or the same request several times by sim_request_repeat().
+    (#) Release everything by sim_destroy().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+//the address map names the caches like the simulator:
+_Static_assert(ROUTE_INSTRUCTION == INSTRUCTION_CACHE && ROUTE_DATA == DATA_CACHE, "cache indexes");
+
+
+/* Simulator function prototypes -------------------------------------------------*/
+/** @addtogroup Sim_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Fill a configuration with the defaults of prog:
+  *             mode 1, one core, no prefetcher/victim buffer/MSHR/write
+  *             buffer/latency model, write-once policy with write allocate.
+  * @param      config: pointer to the configuration.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int sim_config_init(sim_config_t* config)
+{
+    if(config == NULL)
+    {
+        return ERROR;
+    }
+    memset(config, 0, sizeof(sim_config_t));
+    config->mode = 1;
+    config->cores_num = 1;
+    config->coherence = 0;
+    config->l2_sets = DIR_DEFAULT_L2_SETS;
+    config->l2_ways = DIR_DEFAULT_L2_WAYS;
+    config->prefetch_type = PF_NONE;
+    config->prefetch_degree = PF_DEFAULT_DEGREE;
+    config->mshr_window = MSHR_DEFAULT_WINDOW;
+    //data cache: write allocate, write back except the first write to a line.
+    config->write_policy = WRITE_ONCE;
+    config->write_allocate = 1;
+    config->latencies[0] = TIMING_DEFAULT_L1_HIT;
+    config->latencies[1] = TIMING_DEFAULT_L2_HIT;
+    config->latencies[2] = TIMING_DEFAULT_MEMORY;
+    config->latencies[3] = TIMING_DEFAULT_WRITEBACK;
+    config->l1_sets[INSTRUCTION_CACHE] = INSTRUCTION_CACHE_NUM_SETS;
+    config->l1_ways[INSTRUCTION_CACHE] = INSTRUCTION_CACHE_ASSOC_WAYS;
+    config->l1_sets[DATA_CACHE] = DATA_CACHE_NUM_SETS;
+    config->l1_ways[DATA_CACHE] = DATA_CACHE_ASSOC_WAYS;
+    config->line_size = DATA_CACHE_LINE_SIZE;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Validate a configuration before sim_create(): every error
+  *             is reported, not only the first one.
+  * @param      config: pointer to the configuration.
+  * @retval     SUCCESS if the configuration is valid. Otherwise ERROR.
+  */
+int sim_config_check(const sim_config_t* config)
+{
+    int status = SUCCESS;
+    route_t route;
+    if(config == NULL)
+    {
+        return ERROR;
+    }
+    if(config->cores_num <= 0 || config->cores_num > DIR_MAX_CORES ||
+       (!config->coherence && config->cores_num != 1))
+    {
+        printf("Error: Number of cores must be 1..%d.\n", DIR_MAX_CORES);
+        status = ERROR;
+    }
+    if(config->line_size < 4)
+    {
+        printf("Error: Line size must be at least 4 bytes.\n");
+        status = ERROR;
+    }
+    else if(cache_check_geometry(config->l1_sets[INSTRUCTION_CACHE], config->l1_ways[INSTRUCTION_CACHE],
+                                 config->line_size) < 0 ||
+            cache_check_geometry(config->l1_sets[DATA_CACHE], config->l1_ways[DATA_CACHE],
+                                 config->line_size) < 0)
+    {
+        status = ERROR;
+    }
+    if(config->sector_size != 0 &&
+       (!IS_POWER_OF_2(config->sector_size) || config->sector_size > config->line_size ||
+        config->line_size / config->sector_size > CACHE_MAX_SECTORS))
+    {
+        printf("Error: Sector size must be a power of 2, from line size / %d to line size.\n",
+                CACHE_MAX_SECTORS);
+        status = ERROR;
+    }
+    else if(config->sector_size != 0 && config->sector_size != config->line_size &&
+            (config->victim_entries > 0 || config->coherence))
+    {
+        printf("Error: Sectored lines do not support a victim buffer or several cores.\n");
+        status = ERROR;
+    }
+    if(config->coherence && (!IS_POWER_OF_2(config->l2_sets) || config->l2_ways <= 0))
+    {
+        printf("Error: L2 needs a power of 2 number of sets.\n");
+        status = ERROR;
+    }
+    if(config->victim_entries < 0 || config->victim_entries > VICTIM_MAX_ENTRIES ||
+       config->mshr_entries < 0 || config->mshr_entries > MSHR_MAX_ENTRIES ||
+       config->write_buffer_entries < 0 || config->write_buffer_entries > WB_MAX_ENTRIES)
+    {
+        printf("Error: Victim buffer, MSHR or write buffer size out of range.\n");
+        status = ERROR;
+    }
+    if(config->write_policy < WRITE_BACK || config->write_policy > WRITE_ONCE)
+    {
+        printf("Error: Invalid write policy.\n");
+        status = ERROR;
+    }
+    if(config->sample_period > 0 &&
+       (config->sample_window == 0 || config->sample_window > config->sample_period ||
+        config->sample_warmup > config->sample_period - config->sample_window))
+    {
+        printf("Error: Sampling needs 0 < window and window + warmup <= period.\n");
+        status = ERROR;
+    }
+    if(config->interleave < 0 || config->interleave > SIM_MAX_INFLIGHT)
+    {
+        printf("Error: Records in flight must be 0..%d.\n", SIM_MAX_INFLIGHT);
+        status = ERROR;
+    }
+    if(config->pipeline != 0 && config->pipeline != 1)
+    {
+        printf("Error: Pipeline must be 0 or 1.\n");
+        status = ERROR;
+    }
+    if(config->decoders < 0 || config->decoders > PIPELINE_MAX_DECODERS)
+    {
+        printf("Error: Decoders must be 0..%d.\n", PIPELINE_MAX_DECODERS);
+        status = ERROR;
+    }
+    if(config->trace_end != 0 && config->trace_end <= config->trace_start)
+    {
+        printf("Error: The end record must be after the start record.\n");
+        status = ERROR;
+    }
+    if(config->trace_format < TRACE_AUTO || config->trace_format > TRACE_CHAMPSIM)
+    {
+        printf("Error: Invalid trace format.\n");
+        status = ERROR;
+    }
+    if(config->stats_format < STATS_AUTO || config->stats_format > STATS_BINARY)
+    {
+        printf("Error: Invalid export format.\n");
+        status = ERROR;
+    }
+    route.regions_num = 0;
+    if(config->route_map[0] != '\0' && route_parse(&route, config->route_map) < 0)
+    {
+        printf("Error: Wrong address map %s.\n", config->route_map);
+        status = ERROR;
+    }
+    return status;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Create the two L1 caches of one core and what is attached to them.
+  * @param      sim: pointer to the simulator context.
+  * @param      core: core index.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_create_core(sim_context_t* sim, int core)
+{
+    const sim_config_t *config = &sim->config;
+    cache_t *instruction_cache, *data_cache;
+    cache_alloc_t alloc = config->huge_pages ? CACHE_ALLOC_HUGE : CACHE_ALLOC_MALLOC;
+    instruction_cache = create_cache(config->l1_sets[INSTRUCTION_CACHE],
+                                     config->l1_ways[INSTRUCTION_CACHE],
+                                     config->line_size, alloc);
+    if(instruction_cache == NULL)
+    {
+        printf("Error: Cannot create instruction cache.\n");
+        return ERROR;
+    }
+    sim->instruction_caches[core] = instruction_cache;
+    data_cache = create_cache(config->l1_sets[DATA_CACHE],
+                                config->l1_ways[DATA_CACHE],
+                                config->line_size, alloc);
+    if(data_cache == NULL)
+    {
+        printf("Error: Cannot create data cache.\n");
+        return ERROR;
+    }
+    sim->data_caches[core] = data_cache;
+    //place the arenas on the NUMA node of the thread creating the simulator:
+    if(config->huge_pages &&
+       (cache_first_touch(instruction_cache) < 0 || cache_first_touch(data_cache) < 0))
+    {
+        return ERROR;
+    }
+
+    instruction_cache->timing = sim->timing;
+    data_cache->timing = sim->timing;
+    if(cache_set_misstrace(instruction_cache, sim->misstrace, INSTRUCTION_FETCH) < 0 ||
+       cache_set_misstrace(data_cache, sim->misstrace, READ_DATA) < 0)
+    {
+        return ERROR;
+    }
+    if(cache_set_write_policy(data_cache, config->write_policy, config->write_allocate) < 0)
+    {
+        return ERROR;
+    }
+    if(cache_set_sectors(instruction_cache, config->sector_size) < 0 ||
+       cache_set_sectors(data_cache, config->sector_size) < 0)
+    {
+        return ERROR;
+    }
+    if(cache_set_usage(instruction_cache, config->line_usage) < 0 ||
+       cache_set_usage(data_cache, config->line_usage) < 0)
+    {
+        return ERROR;
+    }
+    if(config->write_buffer_entries > 0)
+    {
+        data_cache->wbuf = writebuf_create(config->write_buffer_entries, config->line_size);
+        if(data_cache->wbuf == NULL)
+        {
+            printf("Error: Cannot create write buffer.\n");
+            return ERROR;
+        }
+    }
+    if(config->victim_entries > 0)
+    {
+        instruction_cache->victim = victim_create(config->victim_entries, config->line_size);
+        data_cache->victim = victim_create(config->victim_entries, config->line_size);
+        if(instruction_cache->victim == NULL || data_cache->victim == NULL)
+        {
+            printf("Error: Cannot create victim buffers.\n");
+            return ERROR;
+        }
+    }
+    if(config->mshr_entries > 0)
+    {
+        instruction_cache->mshr = mshr_create(config->mshr_entries, config->mshr_window);
+        data_cache->mshr = mshr_create(config->mshr_entries, config->mshr_window);
+        if(instruction_cache->mshr == NULL || data_cache->mshr == NULL)
+        {
+            printf("Error: Cannot create MSHR tables.\n");
+            return ERROR;
+        }
+    }
+    if(sim->directory != NULL &&
+       directory_attach(sim->directory, core, instruction_cache, data_cache) < 0)
+    {
+        return ERROR;
+    }
+
+    if(prefetch_init(&sim->instruction_prefetches[core], config->prefetch_type, config->prefetch_degree) < 0 ||
+       prefetch_init(&sim->data_prefetches[core], config->prefetch_type, config->prefetch_degree) < 0)
+    {
+        printf("Error: Cannot create prefetchers.\n");
+        return ERROR;
+    }
+
+    char *instruction_name = "Instruction", *data_name = "Data";
+    if(config->coherence)
+    {
+        instruction_name = sim->cache_names[core][INSTRUCTION_CACHE];
+        data_name = sim->cache_names[core][DATA_CACHE];
+        snprintf(instruction_name, SIM_NAME_SIZE, "Core%d Instruction", core);
+        snprintf(data_name, SIM_NAME_SIZE, "Core%d Data", core);
+    }
+    if(cache_stat_init(&sim->instruction_cache_stats[core], instruction_name, sim->log_file, config->mode) < 0)
+    {
+        printf("Error: Instruction stat init failed\n");
+        return ERROR;
+    }
+    if(cache_stat_init(&sim->data_cache_stats[core], data_name, sim->log_file, config->mode) < 0)
+    {
+        printf("Error: Data stat init failed\n");
+        return ERROR;
+    }
+    cache_stat_bind(&sim->instruction_cache_stats[core], instruction_cache);
+    cache_stat_bind(&sim->data_cache_stats[core], data_cache);
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Move the trace to config.trace_start: by the index of a
+  *             native trace, else by reading the records before it.
+  * @param      sim: pointer to the simulator context.
+  * @param      trace_path: trace file, indexed next to it.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_seek(sim_context_t* sim, const char* trace_path)
+{
+    trace_record_t skipped;
+    uint64_t i;
+    sim->trace_left = (sim->config.trace_end != 0) ? sim->config.trace_end - sim->config.trace_start
+                                                   : UINT64_MAX;
+    if(sim->config.trace_start == 0)
+    {
+        return SUCCESS;
+    }
+    if(sim->trace->format == TRACE_NATIVE)
+    {
+        trace_index_t *index = traceidx_open(trace_path);
+        int status = traceidx_seek(index, sim->trace, sim->config.trace_start);
+        traceidx_destroy(index);
+        return status;
+    }
+    for(i = 0; i < sim->config.trace_start; i++)
+    {
+        if(trace_read(sim->trace, &skipped) == FALSE)
+        {
+            break;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Create a simulator context.
+  * @param      config: configuration, copied into the context.
+  * @param      trace_path: trace file to replay, NULL if the requests
+  *                         are sent by sim_request() only.
+  * @param      log_path: log file, created (truncated) by this function.
+  *                       NULL for no log: PRINT_CONTENT does nothing and
+  *                       mode 2 messages are dropped.
+  * @retval     pointer to the context, NULL if failed.
+  */
+sim_context_t* sim_create(const sim_config_t* config, const char* trace_path, const char* log_path)
+{
+    int core;
+    if(config == NULL || sim_config_check(config) < 0)
+    {
+        printf("Error: Invalid simulator configuration.\n");
+        return NULL;
+    }
+    sim_context_t *sim = (sim_context_t*)calloc(1, sizeof(sim_context_t));
+    if(sim == NULL)
+    {
+        printf("Error: Cannot create simulator context.\n");
+        return NULL;
+    }
+    sim->config = *config;
+    if(log_path == NULL)
+    {
+        sim->config.mode = 1;
+    }
+    if(config->timing_enabled)
+    {
+        //one latency model (and L2) shared by all caches:
+        sim->timing = timing_create(config->latencies[0], config->latencies[1],
+                                    config->latencies[2], config->latencies[3],
+                                    config->line_size);
+        if(sim->timing == NULL)
+        {
+            printf("Error: Cannot create latency model.\n");
+            sim_destroy(sim);
+            return NULL;
+        }
+    }
+    sim->route = route_create();
+    if(sim->route == NULL)
+    {
+        printf("Error: Cannot create address map.\n");
+        sim_destroy(sim);
+        return NULL;
+    }
+    if(config->route_map[0] != '\0')
+    {
+        if(route_parse(sim->route, config->route_map) < 0)
+        {
+            printf("Error: Wrong address map %s.\n", config->route_map);
+            sim_destroy(sim);
+            return NULL;
+        }
+    }
+    else if(route_add(sim->route, INSTR_BASE_ADDR, INSTR_END_ADDR, ROUTE_CACHED,
+                      BIT(ROUTE_INSTRUCTION) | BIT(ROUTE_DATA), ROUTE_INSTRUCTION) < 0 ||
+            route_add(sim->route, DATA_BASE_ADDR, DATA_END_ADDR, ROUTE_CACHED,
+                      BIT(ROUTE_INSTRUCTION) | BIT(ROUTE_DATA), ROUTE_DATA) < 0)
+    {
+        sim_destroy(sim);
+        return NULL;
+    }
+    if(config->sample_period > 0)
+    {
+        //one estimator per cache: core * 2 + INSTRUCTION_CACHE/DATA_CACHE.
+        sim->sample = sample_create(config->sample_period, config->sample_window,
+                                    config->sample_warmup, config->cores_num * 2);
+        if(sim->sample == NULL)
+        {
+            printf("Error: Cannot create sampler.\n");
+            sim_destroy(sim);
+            return NULL;
+        }
+    }
+    if(config->coherence)
+    {
+        sim->directory = directory_create(config->cores_num, config->l2_sets,
+                                          config->l2_ways, config->line_size);
+        if(sim->directory == NULL)
+        {
+            printf("Error: Cannot create L2 directory.\n");
+            sim_destroy(sim);
+            return NULL;
+        }
+    }
+    if(trace_path != NULL)
+    {
+        sim->trace = trace_create(trace_path, config->trace_format, config->line_size);
+        if(sim->trace == NULL || sim_seek(sim, trace_path) < 0)
+        {
+            sim_destroy(sim);
+            return NULL;
+        }
+    }
+    if(log_path != NULL)
+    {
+        sim->log_file = fopen(log_path, "w");
+    }
+    if(log_path != NULL && sim->log_file == NULL)
+    {
+        printf("Error: Failed to open file %s.\n", log_path);
+        sim_destroy(sim);
+        return NULL;
+    }
+    if(config->pipeline && sim->trace != NULL)
+    {
+        sim->pipeline = pipeline_create(sim->trace, config->decoders);
+        if(sim->pipeline == NULL)
+        {
+            sim_destroy(sim);
+            return NULL;
+        }
+        //the log is written by the logger thread from now on:
+        if(sim->log_file != NULL)
+        {
+            FILE *stream = pipeline_open(sim->pipeline, sim->log_file, 1);
+            if(stream == NULL)
+            {
+                sim_destroy(sim);
+                return NULL;
+            }
+            sim->log_file = stream;
+        }
+    }
+    if(config->stats_path[0] != '\0')
+    {
+        sim->stats = stats_create(config->stats_path, config->stats_format,
+                                  (trace_path != NULL) ? trace_path : "");
+        if(sim->stats == NULL)
+        {
+            printf("Error: Cannot create statistic export %s.\n", config->stats_path);
+            sim_destroy(sim);
+            return NULL;
+        }
+    }
+    if(config->miss_trace_path[0] != '\0')
+    {
+        sim->misstrace = misstrace_create(config->miss_trace_path);
+        if(sim->misstrace == NULL)
+        {
+            sim_destroy(sim);
+            return NULL;
+        }
+        if(sim->pipeline != NULL)
+        {
+            //the writer already gathers large blocks:
+            FILE *stream = pipeline_open(sim->pipeline, sim->misstrace->fp, 0);
+            if(stream == NULL)
+            {
+                sim_destroy(sim);
+                return NULL;
+            }
+            sim->misstrace->fp = stream;
+        }
+    }
+    for(core = 0; core < config->cores_num; core++)
+    {
+        if(sim_create_core(sim, core) < 0)
+        {
+            sim_destroy(sim);
+            return NULL;
+        }
+    }
+    return sim;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Send an L2 evict command to one cache of a core.
+  * @param      sim: pointer to the simulator context.
+  * @param      cache_num: INSTRUCTION_CACHE or DATA_CACHE.
+  * @param      address: byte address.
+  * @param      core: core index.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_evict_cache(sim_context_t* sim, int cache_num, uint32_t address, int core)
+{
+    cache_t *cache = sim->data_caches[core];
+    cache_stat_t *stat = &sim->data_cache_stats[core];
+    prefetch_t *pf = &sim->data_prefetches[core];
+    if(cache_num == INSTRUCTION_CACHE)
+    {
+        cache = sim->instruction_caches[core];
+        stat = &sim->instruction_cache_stats[core];
+        pf = &sim->instruction_prefetches[core];
+    }
+    int update = cache_L2_evict(cache, address);
+    if(cache_stat_update(stat, update, address) < 0)
+    {
+        printf("Error: Stat update failed code=%d!\n", update);
+        return ERROR;
+    }
+    if(prefetch_update(pf, cache, stat, address, update) < 0)
+    {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      L2 evict command (single core): invalidate the line in every
+  *             cache of its region holding it (L1 or victim buffer). If no
+  *             cache holds it, the home cache of the region reports it.
+  * @param      sim: pointer to the simulator context.
+  * @param      address: byte address.
+  * @param      core: core index.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_evict(sim_context_t* sim, uint32_t address, int core)
+{
+    int cache_num, held = 0;
+    route_region_t *region = route_lookup(sim->route, address);
+    if(region == NULL)
+    {
+        printf("Error: Address %x is not in the address map.\n", address);
+        return ERROR;
+    }
+    if(region->kind != ROUTE_CACHED)
+    {
+        //scratchpad and MMIO lines are never cached.
+        return SUCCESS;
+    }
+    for(cache_num = INSTRUCTION_CACHE; cache_num <= DATA_CACHE; cache_num++)
+    {
+        cache_t *cache = (cache_num == DATA_CACHE) ? sim->data_caches[core] : sim->instruction_caches[core];
+        if(!(region->caches & BIT(cache_num)))
+        {
+            continue;
+        }
+        if(cache_L1_probe(cache, address) == FALSE &&
+           (cache->victim == NULL || victim_lookup(cache->victim, address & ~cache->bytes_mask) == FALSE))
+        {
+            continue;
+        }
+        held++;
+        if(sim_evict_cache(sim, cache_num, address, core) < 0)
+        {
+            return ERROR;
+        }
+    }
+    if(held == 0)
+    {
+        return sim_evict_cache(sim, region->home, address, core);
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Clear the caches of every core and their statistic.
+  * @param      sim: pointer to the simulator context.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_clear(sim_context_t* sim)
+{
+    int core;
+    for(core = 0; core < sim->config.cores_num; core++)
+    {
+        cache_t *data_cache = sim->data_caches[core];
+        cache_t *instruction_cache = sim->instruction_caches[core];
+        cache_stat_t *data_cache_stat = &sim->data_cache_stats[core];
+        cache_stat_t *instruction_cache_stat = &sim->instruction_cache_stats[core];
+        if(cache_L1_clear(data_cache) < 0)
+        {
+            printf("Error: Cannot clear cache: %s\n", data_cache_stat->name);
+            return ERROR;
+        }
+
+        if(clear_stat(data_cache_stat) < 0)
+        {
+            printf("Error: Cannot clear cache statistics: %s\n", data_cache_stat->name);
+            return ERROR;
+        }
+
+        if(cache_L1_clear(instruction_cache) < 0)
+        {
+            printf("Error: Cannot clear cache state: %s\n", instruction_cache_stat->name);
+            return ERROR;
+        }
+
+        if(clear_stat(instruction_cache_stat) < 0)
+        {
+            printf("Error: Cannot clear cache statistics: %s\n", instruction_cache_stat->name);
+            return ERROR;
+        }
+
+        if(prefetch_clear(&sim->data_prefetches[core]) < 0 ||
+           prefetch_clear(&sim->instruction_prefetches[core]) < 0)
+        {
+            printf("Error: Cannot clear prefetchers.\n");
+            return ERROR;
+        }
+    }
+
+    if(sim->timing != NULL && timing_clear(sim->timing) < 0)
+    {
+        printf("Error: Cannot clear latency model.\n");
+        return ERROR;
+    }
+    if(sim->directory != NULL && directory_clear(sim->directory) < 0)
+    {
+        printf("Error: Cannot clear L2 directory.\n");
+        return ERROR;
+    }
+    if(sim->sample != NULL && sample_clear(sim->sample) < 0)
+    {
+        printf("Error: Cannot clear sampler.\n");
+        return ERROR;
+    }
+    if(route_clear(sim->route) < 0)
+    {
+        printf("Error: Cannot clear address map.\n");
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Give the counters of every cache to the sampler when a
+  *             measurement window opens or closes.
+  * @param      sim: pointer to the simulator context.
+  * @param      close: 0 when the window opens, 1 when it closes.
+  * @retval     None.
+  */
+static void sim_sample_window(sim_context_t* sim, int close)
+{
+    int core, i;
+    for(core = 0; core < sim->config.cores_num; core++)
+    {
+        for(i = INSTRUCTION_CACHE; i <= DATA_CACHE; i++)
+        {
+            cache_stat_t *stat = (i == DATA_CACHE) ? &sim->data_cache_stats[core] :
+                                                     &sim->instruction_cache_stats[core];
+            uint32_t hits = stat->read_hits + stat->write_hits;
+            uint32_t accesses = hits + stat->read_misses + stat->write_misses;
+            if(close)
+                sample_close(sim->sample, core * 2 + i, hits, accesses);
+            else
+                sample_open(sim->sample, core * 2 + i, hits, accesses);
+        }
+    }
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Functional warming of one access, see cache_L1_warm_read().
+  * @param      sim: pointer to the simulator context.
+  * @param      command: READ_DATA, WRITE_DATA or INSTRUCTION_FETCH.
+  * @param      address: byte address.
+  * @param      core: core issuing the access.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_warm(sim_context_t* sim, int command, uint32_t address, int core)
+{
+    int update;
+    if(command == READ_DATA)
+        update = cache_L1_warm_read(sim->data_caches[core], address);
+    else if(command == WRITE_DATA)
+        update = cache_L1_warm_write(sim->data_caches[core], address);
+    else
+        update = cache_L1_warm_read(sim->instruction_caches[core], address);
+    if(update < 0)
+    {
+        printf("Error: Cannot warm cache with addr=%x.\n", address);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Log the statistic of every core, then the shared L2.
+  * @param      sim: pointer to the simulator context.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_log(sim_context_t* sim)
+{
+    int core;
+    if(sim->log_file == NULL)
+    {
+        return SUCCESS;
+    }
+    for(core = 0; core < sim->config.cores_num; core++)
+    {
+        cache_t *data_cache = sim->data_caches[core];
+        cache_t *instruction_cache = sim->instruction_caches[core];
+        cache_stat_t *data_cache_stat = &sim->data_cache_stats[core];
+        cache_stat_t *instruction_cache_stat = &sim->instruction_cache_stats[core];
+        printf("Logged data cache at %d\n",data_cache_stat->count);
+        if(cache_log(data_cache_stat) < 0)
+        {
+            printf("Error: Cannot log cache state: %s\n", data_cache_stat->name);
+            return ERROR;
+        }
+        if(prefetch_log(&sim->data_prefetches[core], data_cache_stat->log_file) < 0)
+        {
+            printf("Error: Cannot log prefetcher: %s\n", data_cache_stat->name);
+            return ERROR;
+        }
+        if(victim_log(data_cache->victim, data_cache_stat->log_file) < 0 ||
+           mshr_log(data_cache->mshr, data_cache_stat->log_file) < 0 ||
+           writebuf_log(data_cache->wbuf, data_cache_stat->log_file) < 0)
+        {
+            printf("Error: Cannot log victim buffer/MSHR/write buffer: %s\n", data_cache_stat->name);
+            return ERROR;
+        }
+        printf("Logged instruction cache at %d\n",instruction_cache_stat->count);
+        if(cache_log(instruction_cache_stat) < 0)
+        {
+            printf("Error: Cannot log cache state: %s\n", instruction_cache_stat->name);
+            return ERROR;
+        }
+        if(prefetch_log(&sim->instruction_prefetches[core], instruction_cache_stat->log_file) < 0)
+        {
+            printf("Error: Cannot log prefetcher: %s\n", instruction_cache_stat->name);
+            return ERROR;
+        }
+        if(victim_log(instruction_cache->victim, instruction_cache_stat->log_file) < 0 ||
+           mshr_log(instruction_cache->mshr, instruction_cache_stat->log_file) < 0 ||
+           writebuf_log(instruction_cache->wbuf, instruction_cache_stat->log_file) < 0)
+        {
+            printf("Error: Cannot log victim buffer/MSHR/write buffer: %s\n", instruction_cache_stat->name);
+            return ERROR;
+        }
+    }
+    if(directory_log(sim->directory, sim->log_file) < 0)
+    {
+        printf("Error: Cannot log L2 directory.\n");
+        return ERROR;
+    }
+    if(route_log(sim->route, sim->log_file) < 0)
+    {
+        printf("Error: Cannot log address map.\n");
+        return ERROR;
+    }
+    if(sim->sample != NULL)
+    {
+        if(sample_log(sim->sample, sim->log_file) < 0)
+        {
+            printf("Error: Cannot log sampler.\n");
+            return ERROR;
+        }
+        for(core = 0; core < sim->config.cores_num; core++)
+        {
+            if(sample_log_stat(sim->sample, core * 2 + DATA_CACHE,
+                               sim->data_cache_stats[core].name, sim->log_file) < 0 ||
+               sample_log_stat(sim->sample, core * 2 + INSTRUCTION_CACHE,
+                               sim->instruction_cache_stats[core].name, sim->log_file) < 0)
+            {
+                printf("Error: Cannot log sampler.\n");
+                return ERROR;
+            }
+        }
+        fprintf(sim->log_file, "------------------------------\n");
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Export one group of counters.
+  * @param      stats: pointer to the writer.
+  * @param      group: name of the group.
+  * @param      names, values: the counters.
+  * @param      count: number of counters.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_export_group(stats_t* stats, const char* group, const char* const* names,
+                            const uint64_t* values, int count)
+{
+    int i;
+    if(stats_group(stats, group) < 0)
+    {
+        return ERROR;
+    }
+    for(i = 0; i < count; i++)
+    {
+        if(stats_counter(stats, names[i], values[i]) < 0)
+        {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Export the counters of one L1 cache and what is attached to
+  *             it, in one group named like the cache. Only the parts that
+  *             exist are exported, like in the log.
+  * @param      stats: pointer to the writer.
+  * @param      stat: statistic of the cache.
+  * @param      cache: the cache.
+  * @param      pf: its prefetcher.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_export_cache(stats_t* stats, cache_stat_t* stat, cache_t* cache, prefetch_t* pf)
+{
+    const char* names[32 + TIMING_HIST_BINS + CACHE_USAGE_BINS];
+    uint64_t values[32 + TIMING_HIST_BINS + CACHE_USAGE_BINS];
+    char hist_names[TIMING_HIST_BINS][24];
+    char usage_names[CACHE_USAGE_BINS][24];
+    int count = 0, i;
+    names[count] = "read_hits";             values[count++] = stat->read_hits;
+    names[count] = "read_misses";           values[count++] = stat->read_misses;
+    names[count] = "write_hits";            values[count++] = stat->write_hits;
+    names[count] = "write_misses";          values[count++] = stat->write_misses;
+    names[count] = "l2_writebacks";         values[count++] = stat->l2_writebacks;
+    names[count] = "l2_write_throughs";     values[count++] = stat->l2_write_throughs;
+    if(cache->sectors_num > 1)
+    {
+        names[count] = "sector_misses";     values[count++] = stat->sector_misses;
+        names[count] = "l2_read_bytes";     values[count++] = cache->l2_read_bytes - stat->l2_read_bytes_base;
+        names[count] = "l2_write_bytes";    values[count++] = cache->l2_write_bytes - stat->l2_write_bytes_base;
+    }
+    if(pf->type != PF_NONE)
+    {
+        names[count] = "prefetch_issued";   values[count++] = pf->issued;
+        names[count] = "prefetch_useful";   values[count++] = pf->useful;
+        names[count] = "prefetch_late";     values[count++] = pf->late;
+        names[count] = "prefetch_polluting"; values[count++] = pf->polluting;
+        names[count] = "prefetch_dropped";  values[count++] = pf->dropped;
+    }
+    if(cache->victim != NULL)
+    {
+        names[count] = "victim_probes";     values[count++] = cache->victim->probes;
+        names[count] = "victim_hits";       values[count++] = cache->victim->hits;
+        names[count] = "victim_fills";      values[count++] = cache->victim->fills;
+        names[count] = "victim_writebacks"; values[count++] = cache->victim->writebacks;
+    }
+    if(cache->mshr != NULL)
+    {
+        names[count] = "mshr_allocations";  values[count++] = cache->mshr->allocations;
+        names[count] = "mshr_merges";       values[count++] = cache->mshr->merges;
+        names[count] = "mshr_full";         values[count++] = cache->mshr->full;
+    }
+    if(cache->wbuf != NULL)
+    {
+        names[count] = "wbuf_writes";       values[count++] = cache->wbuf->writes;
+        names[count] = "wbuf_coalesced";    values[count++] = cache->wbuf->coalesced;
+        names[count] = "wbuf_full";         values[count++] = cache->wbuf->full;
+        names[count] = "wbuf_flushes";      values[count++] = cache->wbuf->flushes;
+        names[count] = "wbuf_l2_writes";    values[count++] = cache->wbuf->l2_writes;
+        names[count] = "wbuf_l2_bytes";     values[count++] = cache->wbuf->l2_bytes;
+    }
+    if(cache->timing != NULL)
+    {
+        names[count] = "cycles";            values[count++] = stat->cycles;
+        names[count] = "stall_cycles";      values[count++] = stat->stall_cycles;
+        //bin i counts the latencies from 2^i, see timing.h:
+        for(i = 0; i < TIMING_HIST_BINS; i++)
+        {
+            snprintf(hist_names[i], sizeof(hist_names[i]), "latency_hist_%d", i);
+            names[count] = hist_names[i];
+            values[count++] = stat->latency_hist[i];
+        }
+    }
+    if(cache->usage_hist != NULL)
+    {
+        //lines evicted by bytes used, every part of a line:
+        int part_size = 1 << cache->usage_shift;
+        for(i = 0; i <= (int)(cache->bytes_mask >> cache->usage_shift) + 1; i++)
+        {
+            snprintf(usage_names[i], sizeof(usage_names[i]), "usage_hist_%d", i * part_size);
+            names[count] = usage_names[i];
+            values[count++] = cache->usage_hist[i] - stat->usage_hist_base[i];
+        }
+    }
+    return sim_export_group(stats, stat->name, names, values, count);
+}
+
+/**
+  * @brief      Write a snapshot of every counter to the statistic export:
+  *             the L1 caches of every core, the shared L2, the address map
+  *             and the sampler. Does nothing without export.
+  * @param      sim: pointer to the simulator context.
+  * @param      event: why the snapshot is taken, "print" for PRINT_CONTENT,
+  *                    "exit" at the end of the run.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int sim_export(sim_context_t* sim, const char* event)
+{
+    int core, i;
+    stats_t *stats;
+    if(sim == NULL || sim->stats == NULL)
+    {
+        return SUCCESS;
+    }
+    stats = sim->stats;
+    if(stats_begin(stats, event, sim->records) < 0)
+    {
+        printf("Error: Cannot export statistic.\n");
+        return ERROR;
+    }
+    for(core = 0; core < sim->config.cores_num; core++)
+    {
+        if(sim_export_cache(stats, &sim->data_cache_stats[core], sim->data_caches[core],
+                            &sim->data_prefetches[core]) < 0 ||
+           sim_export_cache(stats, &sim->instruction_cache_stats[core], sim->instruction_caches[core],
+                            &sim->instruction_prefetches[core]) < 0)
+        {
+            printf("Error: Cannot export statistic.\n");
+            return ERROR;
+        }
+    }
+    if(sim->directory != NULL)
+    {
+        static const char* names[] = {
+            "hits", "misses", "evictions", "snoops", "invalidations",
+            "back_invalidations", "downgrades", "flushes", "upgrades"
+        };
+        directory_t *dir = sim->directory;
+        uint64_t values[] = {
+            dir->l2_hits, dir->l2_misses, dir->l2_evictions, dir->snoops, dir->invalidations,
+            dir->back_invalidations, dir->downgrades, dir->flushes, dir->upgrades
+        };
+        if(sim_export_group(stats, "L2", names, values, 9) < 0)
+        {
+            printf("Error: Cannot export statistic.\n");
+            return ERROR;
+        }
+    }
+    //regions of a given map, with the accesses around the caches:
+    for(i = 0; sim->route->custom && i < sim->route->regions_num; i++)
+    {
+        static const char* names[] = {"reads", "writes", "fetches"};
+        route_region_t *region = &sim->route->regions[i];
+        uint64_t values[] = {region->reads, region->writes, region->fetches};
+        char name[SIM_NAME_SIZE];
+        snprintf(name, sizeof(name), "Region %08x-%08x", region->base, region->end);
+        if(sim_export_group(stats, name, names, values, 3) < 0)
+        {
+            printf("Error: Cannot export statistic.\n");
+            return ERROR;
+        }
+    }
+    if(sim->sample != NULL)
+    {
+        static const char* names[] = {"warmed", "detailed"};
+        static const char* estimate_names[] = {"windows", "hits", "accesses"};
+        uint64_t values[] = {sim->sample->warmed, sim->sample->detailed};
+        if(sim_export_group(stats, "Sampler", names, values, 2) < 0)
+        {
+            printf("Error: Cannot export statistic.\n");
+            return ERROR;
+        }
+        for(i = 0; i < sim->sample->stats_num; i++)
+        {
+            //index core * 2 + INSTRUCTION_CACHE/DATA_CACHE:
+            cache_stat_t *stat = (i % 2 == DATA_CACHE) ? &sim->data_cache_stats[i / 2] :
+                                                         &sim->instruction_cache_stats[i / 2];
+            sample_stat_t *estimate = &sim->sample->stats[i];
+            uint64_t estimate_values[] = {estimate->windows, estimate->hits, estimate->accesses};
+            char name[SIM_NAME_SIZE + 8];
+            snprintf(name, sizeof(name), "%s sample", stat->name);
+            if(sim_export_group(stats, name, estimate_names, estimate_values, 3) < 0)
+            {
+                printf("Error: Cannot export statistic.\n");
+                return ERROR;
+            }
+        }
+    }
+    if(stats_end(stats) < 0)
+    {
+        printf("Error: Cannot export statistic.\n");
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Simulate one request in detail: the cache request, its
+  *             statistic, log and prefetcher.
+  * @param      sim: pointer to the simulator context.
+  * @param      command: command of the request, see command_t.
+  * @param      address: byte address.
+  * @param      core: core issuing the request, already checked.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_access(sim_context_t* sim, int command, uint32_t address, int core)
+{
+    int update;
+    cache_t *instruction_cache = sim->instruction_caches[core];
+    cache_t *data_cache = sim->data_caches[core];
+    cache_stat_t *instruction_cache_stat = &sim->instruction_cache_stats[core];
+    cache_stat_t *data_cache_stat = &sim->data_cache_stats[core];
+    prefetch_t *instruction_prefetch = &sim->instruction_prefetches[core];
+    prefetch_t *data_prefetch = &sim->data_prefetches[core];
+    // printf("%d %x\n",command, address);
+    if(command == READ_DATA)
+    {
+        uint8_t data;
+        update = cache_L1_read(data_cache, address,&data);
+        if(cache_stat_update(data_cache_stat, update, address) < 0)
+        {
+            printf("Error: Stat update failed code=%d!\n", update);
+            return ERROR;
+        }
+        if(prefetch_update(data_prefetch, data_cache, data_cache_stat, address, update) < 0)
+        {
+            return ERROR;
+        }
+        return SUCCESS;
+    }
+    else if(command == WRITE_DATA)
+    {
+        uint8_t data = DUMMY_BYTE;
+        update = cache_L1_write(data_cache, address, data);
+        if(cache_stat_update(data_cache_stat, update, address) < 0)
+        {
+            printf("Error: Stat update failed code=%d!\n", update);
+            return ERROR;
+        }
+        if(prefetch_update(data_prefetch, data_cache, data_cache_stat, address, update) < 0)
+        {
+            return ERROR;
+        }
+
+    }
+    else if(command == INSTRUCTION_FETCH)
+    {
+        uint8_t data;
+        update = cache_L1_read(instruction_cache, address, &data);
+        if(cache_stat_update(instruction_cache_stat, update, address) < 0)
+        {
+            printf("Error: Stat update failed code=%d!\n", update);
+            return ERROR;
+        }
+        if(prefetch_update(instruction_prefetch, instruction_cache, instruction_cache_stat, address, update) < 0)
+        {
+            return ERROR;
+        }
+    }
+    else if(command == EVICT && sim->directory != NULL)
+    {
+        //the shared L2 knows every core holding the line:
+        if(directory_l2_evict(sim->directory, address) < 0)
+        {
+            printf("Error: Cannot evict %x from L2.\n", address);
+            return ERROR;
+        }
+        return SUCCESS;
+    }
+    else if(command == EVICT)
+    {
+        return sim_evict(sim, address, core);
+    }
+    else if(command == CLEAR_CACHE)
+    {
+        return sim_clear(sim);
+    }
+    else if(command == PRINT_CONTENT)
+    {
+        if(sim_export(sim, "print") < 0)
+        {
+            return ERROR;
+        }
+        return sim_log(sim);
+    }
+    else
+    {
+        //do nothing;
+        printf("Error: Unknown command.\n");
+        return ERROR;
+    }
+
+    return SUCCESS;
+}
+
+/**
+  * @brief      Send one request to the simulated system, like a trace record.
+  * @param      sim: pointer to the simulator context.
+  * @param      command: command of the request, see command_t.
+  * @param      address: byte address.
+  * @param      core: core issuing the request, 0 for single core.
+  *                   Note: CLEAR_CACHE and PRINT_CONTENT apply to all cores.
+  *                   With sampling, reads, writes and fetches count in
+  *                   the period, the other commands are always simulated.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int sim_request(sim_context_t* sim, int command, uint32_t address, int core)
+{
+    int status = 0;
+    if(core < 0 || core >= sim->config.cores_num)
+    {
+        printf("Error: Core %d out of range, see --cores.\n", core);
+        return ERROR;
+    }
+    if(command == READ_DATA || command == WRITE_DATA || command == INSTRUCTION_FETCH)
+    {
+        route_region_t *region = route_lookup(sim->route, address);
+        if(region == NULL)
+        {
+            printf("Error: Address %x is not in the address map.\n", address);
+            return ERROR;
+        }
+        if(route_cached(region, command == INSTRUCTION_FETCH ? INSTRUCTION_CACHE : DATA_CACHE) == FALSE)
+        {
+            //scratchpad, MMIO, or a cache not allowed in the region:
+            route_bypass(region, command);
+            return SUCCESS;
+        }
+    }
+    if(sim->sample != NULL &&
+       (command == READ_DATA || command == WRITE_DATA || command == INSTRUCTION_FETCH))
+    {
+        status = sample_next(sim->sample);
+        if(!(status & SAMPLE_DETAILED))
+        {
+            return sim_warm(sim, command, address, core);
+        }
+        if(status & SAMPLE_OPEN)
+        {
+            sim_sample_window(sim, 0);
+        }
+    }
+    if(sim_access(sim, command, address, core) < 0)
+    {
+        return ERROR;
+    }
+    if(status & SAMPLE_CLOSE)
+    {
+        sim_sample_window(sim, 1);
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Check that the next requests like this one can be applied
+  *             at once by sim_repeat_hits(): a read/write/fetch hitting a
+  *             line, see cache_L1_repeatable(), in a cache without
+  *             prefetcher (it trains on every access) and not sampled,
+  *             in a region of the address map using that cache.
+  * @param      sim: pointer to the simulator context.
+  * @param      command: command of the request, see command_t.
+  * @param      address: byte address.
+  * @param      core: core issuing the request, already checked.
+  * @retval     TRUE if they can, otherwise FALSE.
+  */
+static int sim_repeatable(sim_context_t* sim, int command, uint32_t address, int core)
+{
+    cache_t *cache = sim->data_caches[core];
+    prefetch_t *pf = &sim->data_prefetches[core];
+    if(sim->sample != NULL ||
+       (command != READ_DATA && command != WRITE_DATA && command != INSTRUCTION_FETCH))
+    {
+        return FALSE;
+    }
+    if(command == INSTRUCTION_FETCH)
+    {
+        cache = sim->instruction_caches[core];
+        pf = &sim->instruction_prefetches[core];
+    }
+    route_region_t *region = route_lookup(sim->route, address);
+    if(region == NULL ||
+       route_cached(region, command == INSTRUCTION_FETCH ? INSTRUCTION_CACHE : DATA_CACHE) == FALSE)
+    {
+        return FALSE;
+    }
+    if(pf->type != PF_NONE || cache_L1_repeatable(cache, address, command == WRITE_DATA) == FALSE)
+    {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Apply count hits at once, sim_repeatable() must be true.
+  * @param      sim: pointer to the simulator context.
+  * @param      command: READ_DATA, WRITE_DATA or INSTRUCTION_FETCH.
+  * @param      address: byte address.
+  * @param      core: core issuing the requests.
+  * @param      count: number of requests.
+  * @param      used: usage bits of the other bytes of the line requested,
+  *             see cache_L1_usage_bit(), 0 if none.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int sim_repeat_hits(sim_context_t* sim, int command, uint32_t address, int core, uint32_t count,
+                           uint64_t used)
+{
+    cache_t *cache = sim->data_caches[core];
+    cache_stat_t *stat = &sim->data_cache_stats[core];
+    if(command == INSTRUCTION_FETCH)
+    {
+        cache = sim->instruction_caches[core];
+        stat = &sim->instruction_cache_stats[core];
+    }
+    int update = cache_L1_repeat(cache, address, command == WRITE_DATA, count, used);
+    if(update < 0 || cache_stat_repeat(stat, update, count) < 0)
+    {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Send the same request count times, like count trace records.
+  *             After the first one, the requests are applied at once when
+  *             they are plain hits (see sim_repeatable()), otherwise one
+  *             by one. The statistic is the same either way.
+  * @param      sim: pointer to the simulator context.
+  * @param      command: command of the request, see command_t.
+  * @param      address: byte address.
+  * @param      core: core issuing the request, 0 for single core.
+  * @param      count: number of requests, 0 does nothing.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int sim_request_repeat(sim_context_t* sim, int command, uint32_t address, int core, uint32_t count)
+{
+    if(count == 0)
+    {
+        return SUCCESS;
+    }
+    if(sim_request(sim, command, address, core) < 0)
+    {
+        return ERROR;
+    }
+    count--;
+    if(count > 0 && sim_repeatable(sim, command, address, core) == TRUE)
+    {
+        return sim_repeat_hits(sim, command, address, core, count, 0);
+    }
+    for(; count > 0; count--)
+    {
+        if(sim_request(sim, command, address, core) < 0)
+        {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Bring the host memory of a record in flight closer, see
+  *             cache_L1_host_prefetch(). Only reads, writes and fetches of
+  *             a valid core are prefetched, a hint cannot fail.
+  * @param      sim: pointer to the simulator context.
+  * @param      record: record in flight.
+  * @param      stage: see host_prefetch_t.
+  * @retval     None.
+  */
+static void sim_host_prefetch(sim_context_t* sim, const trace_record_t* record, host_prefetch_t stage)
+{
+    if(record->core < 0 || record->core >= sim->config.cores_num)
+    {
+        return;
+    }
+    if(record->command == READ_DATA || record->command == WRITE_DATA)
+    {
+        cache_L1_host_prefetch(sim->data_caches[record->core], record->address,
+                               record->command == WRITE_DATA, stage);
+    }
+    else if(record->command == INSTRUCTION_FETCH)
+    {
+        cache_L1_host_prefetch(sim->instruction_caches[record->core], record->address, 0, stage);
+    }
+}
+
+/**
+  * @brief      Replay the next records of the trace file.
+  *             A record is "<command> <address in hex> [core] [count]",
+  *             count repeats the record (default 1). Blank or malformed
+  *             lines are skipped. Traces of other tools are read by
+  *             trace.c, see config.trace_format.
+  *             With config.rle, when a record leaves a line that only
+  *             plain hits can follow (sim_repeatable()), the next records
+  *             of the same core to the same line (the same sector of
+  *             sectored lines) with the same command are counted only, and applied at once by sim_repeat_hits()
+  *             when another record comes. Runs end with the call. The
+  *             bytes of the counted records are gathered for the line
+  *             usage, see cache_L1_usage_bit().
+  *             With config.interleave, up to that many records are read
+  *             ahead, and the host memory of their sets is prefetched in
+  *             stages while the older ones are simulated: the set pointer
+  *             when a record is read, its lines half way, the data of the
+  *             line it hits just before it runs. The records are still
+  *             simulated one by one in trace order, so two records in
+  *             flight to the same set, or any shared state (victim buffer,
+  *             MSHR, L2...), see each other exactly like without it.
+  *             With config.pipeline, the records come from the decoder
+  *             thread (pipeline_read()) instead of the trace.
+  *             With config.trace_end, the trace ends before that record.
+  * @param      sim: pointer to the simulator context.
+  * @param      records_num: maximum number of records to replay.
+  * @retval     number of records replayed, 0 at the end of the trace.
+  *             ERROR if failed.
+  */
+int sim_step_batch(sim_context_t* sim, int records_num)
+{
+    int done = 0, read = 0, end = 0;
+    //records in flight, oldest at head:
+    trace_record_t flight[SIM_MAX_INFLIGHT];
+    int head = 0, in_flight = 0;
+    int depth = (sim != NULL && sim->config.interleave > 1) ? sim->config.interleave : 1;
+    //current run of hits, run_active 0 if none:
+    int run_active = 0, run_command = 0, run_core = 0;
+    uint32_t run_address = 0, run_count = 0, run_mask;
+    uint64_t run_used = 0;
+    cache_t *run_cache = NULL;
+    if(sim == NULL || sim->trace == NULL)
+    {
+        printf("Error: No trace to replay.\n");
+        return ERROR;
+    }
+    //both L1 caches have the same line and sector size, a run stays in
+    //the sector of its first record, the only one known to be valid:
+    run_mask = ~(uint32_t)(((sim->config.sector_size != 0) ? sim->config.sector_size :
+                                                             sim->config.line_size) - 1);
+    while(1)
+    {
+        while(!end && in_flight < depth && read < records_num)
+        {
+            trace_record_t *next = &flight[(head + in_flight) % depth];
+            if(sim->trace_left == 0 ||
+               ((sim->pipeline != NULL) ? pipeline_read(sim->pipeline, next)
+                                        : trace_read(sim->trace, next)) == FALSE)
+            {
+                end = 1;
+                break;
+            }
+            sim->trace_left--;
+            read++;
+            in_flight++;
+            if(depth > 1)
+            {
+                sim_host_prefetch(sim, next, HOST_PREFETCH_SET);
+            }
+        }
+        if(in_flight == 0)
+        {
+            break;
+        }
+        if(depth > 1)
+        {
+            //each record passes these distances from the head once:
+            if(in_flight > depth / 2)
+                sim_host_prefetch(sim, &flight[(head + depth / 2) % depth], HOST_PREFETCH_LINES);
+            if(in_flight > 1)
+                sim_host_prefetch(sim, &flight[(head + 1) % depth], HOST_PREFETCH_DATA);
+        }
+        trace_record_t record = flight[head];
+        head = (head + 1) % depth;
+        in_flight--;
+        sim->records++;
+        done++;
+        if(run_active && record.command == run_command && record.core == run_core &&
+           ((record.address ^ run_address) & run_mask) == 0)
+        {
+            run_count += record.count;
+            run_used |= cache_L1_usage_bit(run_cache, record.address);
+            continue;
+        }
+        if(run_count > 0 && sim_repeat_hits(sim, run_command, run_address, run_core, run_count, run_used) < 0)
+        {
+            return ERROR;
+        }
+        run_active = 0;
+        run_count = 0;
+        run_used = 0;
+        if(sim_request_repeat(sim, record.command, record.address, record.core, record.count) < 0)
+        {
+            return ERROR;
+        }
+        if(sim->config.rle && sim_repeatable(sim, record.command, record.address, record.core) == TRUE)
+        {
+            run_active = 1;
+            run_command = record.command;
+            run_address = record.address;
+            run_core = record.core;
+            run_cache = (run_command == INSTRUCTION_FETCH) ? sim->instruction_caches[run_core]
+                                                           : sim->data_caches[run_core];
+        }
+    }
+    if(run_count > 0 && sim_repeat_hits(sim, run_command, run_address, run_core, run_count, run_used) < 0)
+    {
+        return ERROR;
+    }
+    return done;
+}
+
+/**
+  * @brief      Release a simulator context, its caches and files.
+  * @param      sim: pointer to the simulator context, may be partly created.
+  * @retval     None.
+  */
+void sim_destroy(sim_context_t* sim)
+{
+    int core;
+    if(sim == NULL)
+    {
+        return;
+    }
+    for(core = 0; core < DIR_MAX_CORES; core++)
+    {
+        destroy_cache(sim->instruction_caches[core]);
+        destroy_cache(sim->data_caches[core]);
+    }
+    directory_destroy(sim->directory);
+    timing_destroy(sim->timing);
+    sample_destroy(sim->sample);
+    route_destroy(sim->route);
+    stats_destroy(sim->stats);
+    misstrace_destroy(sim->misstrace);
+    if(sim->log_file != NULL)
+    {
+        fclose(sim->log_file);
+    }
+    //after its streams are closed, before the trace of its decoder:
+    pipeline_destroy(sim->pipeline);
+    trace_destroy(sim->trace);
+    free(sim);
+}
+/**
+  * @}
+  */
@@ -0,0 +1,512 @@
+/**
+  ***********************************************************************
+  * @file       stats.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Statistic export driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    The text log of cache_log() is written for people. This driver writes
+    the same counters for programs, so that the results of many runs can
+    be gathered without parsing the log:
+        (+) a snapshot holds every counter of the simulation at one time:
+            at each PRINT_CONTENT (9) command and at the end of the run.
+        (+) a snapshot is made of groups (one per cache, L2, sampler...),
+            a group of named counters, all unsigned 64-bit.
+    [..]
+    Formats:
+        (+) JSON  : one object per snapshot, one snapshot per line:
+            {"run":"trace.txt","snapshot":0,"event":"print","records":10,
+             "groups":{"Data":{"read_hits":3,...},...}}
+        (+) CSV   : a header, then one row per counter:
+            run,snapshot,event,records,group,counter,value
+        (+) binary: append-only, every run adds its records to the file.
+            Integers are little endian, a name is a u16 length and the
+            bytes without '\0'.
+                File   : "CSIMSTAT", u32 version, then the records.
+                RUN    : u8 1, name            (once per stats_create())
+                BEGIN  : u8 2, u32 snapshot, u64 records, name of the event
+                GROUP  : u8 3, name
+                COUNTER: u8 4, name, u64 value
+                END    : u8 5, u32 counters in the snapshot
+    [..]
+    (#) Open the file by stats_create(), JSON and CSV files are truncated.
+    (#) Write a snapshot: stats_begin(), then for each group stats_group()
+        and its stats_counter(), then stats_end().
+    (#) Everything goes through one buffer of STATS_BUFFER_SIZE bytes,
+        stats_flush() writes it, stats_destroy() flushes and closes.
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "cache.h"
+#include "stats.h"
+
+
+/* Stats function prototypes -------------------------------------------------*/
+/** @addtogroup Stats_data_structures
+  * @{
+  */
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Append bytes to the buffer, write it to the file when full.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int stats_put(stats_t* stats, const void* data, size_t length)
+{
+    if(stats->used + length > sizeof(stats->buffer))
+    {
+        if(stats_flush(stats) < 0)
+        {
+            return ERROR;
+        }
+        if(length > sizeof(stats->buffer))
+        {
+            return (fwrite(data, 1, length, stats->fp) == length) ? SUCCESS : ERROR;
+        }
+    }
+    memcpy(stats->buffer + stats->used, data, length);
+    stats->used += length;
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Append formatted text to the buffer.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int stats_printf(stats_t* stats, const char* format, ...)
+{
+    char text[4 * STATS_NAME_SIZE];
+    va_list args;
+    int length;
+    va_start(args, format);
+    length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if(length < 0 || length >= (int)sizeof(text))
+    {
+        return ERROR;
+    }
+    return stats_put(stats, text, length);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Append little endian integers, and a name, to the buffer.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int stats_put_uint(stats_t* stats, uint64_t value, int bytes)
+{
+    uint8_t data[8];
+    int i;
+    for(i = 0; i < bytes; i++)
+    {
+        data[i] = (uint8_t)(value >> (8 * i));
+    }
+    return stats_put(stats, data, bytes);
+}
+
+static int stats_put_name(stats_t* stats, const char* name)
+{
+    size_t length = strlen(name);
+    if(length > 0xffff)
+    {
+        length = 0xffff;
+    }
+    if(stats_put_uint(stats, length, 2) < 0)
+    {
+        return ERROR;
+    }
+    return stats_put(stats, name, length);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Append a JSON string, quoted and escaped.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int stats_put_json(stats_t* stats, const char* str)
+{
+    int status = stats_put(stats, "\"", 1);
+    for(; *str != '\0' && status == SUCCESS; str++)
+    {
+        unsigned char c = (unsigned char)*str;
+        if(c == '"' || c == '\\')
+        {
+            status = stats_printf(stats, "\\%c", c);
+        }
+        else if(c < 0x20)
+        {
+            status = stats_printf(stats, "\\u%04x", c);
+        }
+        else
+        {
+            status = stats_put(stats, str, 1);
+        }
+    }
+    if(status == SUCCESS)
+    {
+        status = stats_put(stats, "\"", 1);
+    }
+    return status;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Append a CSV field and a comma to a row prefix, the field
+  *             is quoted if it holds a separator.
+  * @retval     SUCCESS if success. Otherwise ERROR (prefix too long).
+  */
+static int stats_csv(stats_t* stats, const char* str)
+{
+    size_t i = stats->prefix_length;
+    int quote = (strpbrk(str, ",\"\r\n") != NULL);
+    //worst case: every character doubled, two quotes, comma and '\0'
+    if(i + 2 * strlen(str) + 4 > sizeof(stats->prefix))
+    {
+        return ERROR;
+    }
+    if(quote)
+        stats->prefix[i++] = '"';
+    for(; *str != '\0'; str++)
+    {
+        if(*str == '"')
+            stats->prefix[i++] = '"';
+        stats->prefix[i++] = *str;
+    }
+    if(quote)
+        stats->prefix[i++] = '"';
+    stats->prefix[i++] = ',';
+    stats->prefix[i] = '\0';
+    stats->prefix_length = i;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Parse the name of a format.
+  * @param      str: "json", "csv", "binary" (or "bin") or "auto".
+  * @retval     stats_format_t value, ERROR if unknown.
+  */
+int stats_parse_format(const char* str)
+{
+    if(strcmp(str, "auto") == 0)
+        return STATS_AUTO;
+    if(strcmp(str, "json") == 0)
+        return STATS_JSON;
+    if(strcmp(str, "csv") == 0)
+        return STATS_CSV;
+    if(strcmp(str, "binary") == 0 || strcmp(str, "bin") == 0)
+        return STATS_BINARY;
+    return ERROR;
+}
+
+/**
+  * @brief      Name of a format, as parsed by stats_parse_format().
+  * @param      format: see stats_format_t.
+  * @retval     name of the format.
+  */
+const char* stats_format_name(stats_format_t format)
+{
+    static const char* names[] = {"auto", "json", "csv", "binary"};
+    if(format < STATS_AUTO || format > STATS_BINARY)
+    {
+        return "auto";
+    }
+    return names[format];
+}
+
+/**
+  * @brief      Open an export file.
+  * @param      path: output file. JSON and CSV files are truncated,
+  *                   a binary file is appended to.
+  * @param      format: see stats_format_t.
+  * @param      run: name of the run (the trace), written with every
+  *                  snapshot. NULL for none.
+  * @retval     pointer to the writer, NULL if failed.
+  */
+stats_t* stats_create(const char* path, stats_format_t format, const char* run)
+{
+    const char *extension;
+    stats_t *stats;
+    if(path == NULL)
+    {
+        return NULL;
+    }
+    if(format == STATS_AUTO)
+    {
+        extension = strrchr(path, '.');
+        if(extension != NULL && strcmp(extension, ".json") == 0)
+            format = STATS_JSON;
+        else if(extension != NULL && strcmp(extension, ".csv") == 0)
+            format = STATS_CSV;
+        else
+            format = STATS_BINARY;
+    }
+    stats = (stats_t*)malloc(sizeof(stats_t));
+    if(stats == NULL)
+    {
+        printf("Error: Cannot create statistic export.\n");
+        return NULL;
+    }
+    stats->format = format;
+    stats->snapshot = 0;
+    stats->groups = -1;
+    stats->counters = 0;
+    stats->used = 0;
+    snprintf(stats->run, sizeof(stats->run), "%s", (run != NULL) ? run : "");
+    stats->fp = fopen(path, (format == STATS_BINARY) ? "ab" : "w");
+    if(stats->fp == NULL)
+    {
+        printf("Error: Failed to open file %s.\n", path);
+        free(stats);
+        return NULL;
+    }
+    //the buffer above is the only one:
+    setvbuf(stats->fp, NULL, _IONBF, 0);
+    if(format == STATS_CSV)
+    {
+        stats_printf(stats, "run,snapshot,event,records,group,counter,value\n");
+    }
+    else if(format == STATS_BINARY)
+    {
+        fseek(stats->fp, 0, SEEK_END);
+        if(ftell(stats->fp) == 0)
+        {
+            stats_put(stats, STATS_MAGIC, strlen(STATS_MAGIC));
+            stats_put_uint(stats, STATS_VERSION, 4);
+        }
+        stats_put_uint(stats, STATS_REC_RUN, 1);
+        stats_put_name(stats, stats->run);
+    }
+    return stats;
+}
+
+/**
+  * @brief      Start a snapshot.
+  * @param      stats: pointer to the writer.
+  * @param      event: why the snapshot is taken, "print" or "exit".
+  * @param      records: trace records replayed so far.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int stats_begin(stats_t* stats, const char* event, uint64_t records)
+{
+    if(stats == NULL || stats->groups >= 0)
+    {
+        return ERROR;
+    }
+    stats->groups = 0;
+    stats->counters = 0;
+    if(stats->format == STATS_JSON)
+    {
+        if(stats_put(stats, "{\"run\":", 7) < 0 || stats_put_json(stats, stats->run) < 0 ||
+           stats_printf(stats, ",\"snapshot\":%u,\"event\":", stats->snapshot) < 0 ||
+           stats_put_json(stats, event) < 0 ||
+           stats_printf(stats, ",\"records\":%llu,\"groups\":{", (unsigned long long)records) < 0)
+        {
+            return ERROR;
+        }
+    }
+    else if(stats->format == STATS_CSV)
+    {
+        //every row of the snapshot starts with run,snapshot,event,records,
+        char number[24];
+        stats->prefix_length = 0;
+        if(stats_csv(stats, stats->run) < 0)
+        {
+            return ERROR;
+        }
+        snprintf(number, sizeof(number), "%u", stats->snapshot);
+        if(stats_csv(stats, number) < 0 || stats_csv(stats, event) < 0)
+        {
+            return ERROR;
+        }
+        snprintf(number, sizeof(number), "%llu", (unsigned long long)records);
+        if(stats_csv(stats, number) < 0)
+        {
+            return ERROR;
+        }
+        stats->prefix_begin = stats->prefix_length;
+    }
+    else
+    {
+        if(stats_put_uint(stats, STATS_REC_BEGIN, 1) < 0 || stats_put_uint(stats, stats->snapshot, 4) < 0 ||
+           stats_put_uint(stats, records, 8) < 0 || stats_put_name(stats, event) < 0)
+        {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Start a group of counters in the current snapshot.
+  * @param      stats: pointer to the writer.
+  * @param      name: name of the group, unique in the snapshot.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int stats_group(stats_t* stats, const char* name)
+{
+    if(stats == NULL || stats->groups < 0)
+    {
+        return ERROR;
+    }
+    if(stats->format == STATS_JSON)
+    {
+        if((stats->groups > 0 && stats_put(stats, "},", 2) < 0) ||
+           stats_put_json(stats, name) < 0 || stats_put(stats, ":{", 2) < 0)
+        {
+            return ERROR;
+        }
+    }
+    else if(stats->format == STATS_CSV)
+    {
+        stats->prefix_length = stats->prefix_begin;
+        if(stats_csv(stats, name) < 0)
+        {
+            return ERROR;
+        }
+    }
+    else
+    {
+        if(stats_put_uint(stats, STATS_REC_GROUP, 1) < 0 || stats_put_name(stats, name) < 0)
+        {
+            return ERROR;
+        }
+    }
+    stats->groups++;
+    stats->group_counters = 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Write one counter of the current group.
+  * @param      stats: pointer to the writer.
+  * @param      name: name of the counter, unique in the group.
+  * @param      value: value of the counter.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int stats_counter(stats_t* stats, const char* name, uint64_t value)
+{
+    int status;
+    if(stats == NULL || stats->groups <= 0)
+    {
+        return ERROR;
+    }
+    if(stats->format == STATS_JSON)
+    {
+        status = (stats->group_counters > 0) ? stats_put(stats, ",", 1) : SUCCESS;
+        if(status == SUCCESS)
+            status = stats_put_json(stats, name);
+        if(status == SUCCESS)
+            status = stats_printf(stats, ":%llu", (unsigned long long)value);
+    }
+    else if(stats->format == STATS_CSV)
+    {
+        size_t length = stats->prefix_length;
+        //the counter name takes the place of the next field for a moment:
+        status = stats_csv(stats, name);
+        if(status == SUCCESS)
+            status = stats_put(stats, stats->prefix, stats->prefix_length);
+        if(status == SUCCESS)
+            status = stats_printf(stats, "%llu\n", (unsigned long long)value);
+        stats->prefix_length = length;
+    }
+    else
+    {
+        status = stats_put_uint(stats, STATS_REC_COUNTER, 1);
+        if(status == SUCCESS)
+            status = stats_put_name(stats, name);
+        if(status == SUCCESS)
+            status = stats_put_uint(stats, value, 8);
+    }
+    if(status == SUCCESS)
+    {
+        stats->group_counters++;
+        stats->counters++;
+    }
+    return status;
+}
+
+/**
+  * @brief      End the current snapshot.
+  * @param      stats: pointer to the writer.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int stats_end(stats_t* stats)
+{
+    int status;
+    if(stats == NULL || stats->groups < 0)
+    {
+        return ERROR;
+    }
+    if(stats->format == STATS_JSON)
+    {
+        status = (stats->groups > 0) ? stats_put(stats, "}", 1) : SUCCESS;
+        if(status == SUCCESS)
+            status = stats_put(stats, "}}\n", 3);
+    }
+    else if(stats->format == STATS_CSV)
+    {
+        status = SUCCESS;
+    }
+    else
+    {
+        status = stats_put_uint(stats, STATS_REC_END, 1);
+        if(status == SUCCESS)
+            status = stats_put_uint(stats, stats->counters, 4);
+    }
+    stats->groups = -1;
+    stats->snapshot++;
+    return status;
+}
+
+/**
+  * @brief      Write the buffer to the file.
+  * @param      stats: pointer to the writer.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int stats_flush(stats_t* stats)
+{
+    if(stats == NULL || stats->fp == NULL)
+    {
+        return ERROR;
+    }
+    if(stats->used > 0 && fwrite(stats->buffer, 1, stats->used, stats->fp) != stats->used)
+    {
+        printf("Error: Cannot write statistic export.\n");
+        stats->used = 0;
+        return ERROR;
+    }
+    stats->used = 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Flush and close an export file.
+  * @param      stats: pointer to the writer, NULL is ignored.
+  * @retval     None.
+  */
+void stats_destroy(stats_t* stats)
+{
+    if(stats == NULL)
+    {
+        return;
+    }
+    stats_flush(stats);
+    fclose(stats->fp);
+    free(stats);
+}
+/**
+  * @}
+  */
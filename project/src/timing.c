@@ -0,0 +1,179 @@
+/**
+  ***********************************************************************
+  * @file       timing.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Latency model driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    Create one timing_t by timing_create() and attach it to every L1
+    cache of the hierarchy (cache->timing). Then each read/write request
+    leaves its latency in cache->latency:
+        (+) L1 hit              : l1_hit.
+        (+) Victim buffer hit   : 2 * l1_hit.
+        (+) L1 miss, L2 hit     : l1_hit + l2_hit.
+        (+) L1 miss, L2 miss    : l1_hit + memory.
+        (+) Write to L2         : + writeback, unless absorbed by the
+                                  write buffer.
+    [..]
+    Bind the statistic to the cache by cache_stat_bind(), it will sum the
+    latencies and cache_log() will print AMAT, stall cycles and the
+    latency histogram. All accounting is integer, no allocation after
+    timing_create().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#include "timing.h"
+
+
+/* Timing function prototypes -------------------------------------------------*/
+/** @addtogroup Timing_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Create a latency model.
+  * @param      l1_hit: L1 hit latency.
+  * @param      l2_hit: L2 hit latency, added to l1_hit on a miss.
+  * @param      memory: memory latency, added to l1_hit on an L2 miss.
+  * @param      writeback: cost of a write to L2 not absorbed by a write buffer.
+  * @param      line_size: line size of the caches.
+  * @retval     pointer to the latency model, NULL if failed.
+  */
+timing_t* timing_create(uint32_t l1_hit, uint32_t l2_hit, uint32_t memory,
+                            uint32_t writeback, int line_size)
+{
+    timing_t *timing = (timing_t*)malloc(sizeof(timing_t));
+    if(timing == NULL)
+    {
+        return NULL;
+    }
+    timing->l1_hit = l1_hit;
+    timing->l2_hit = l2_hit;
+    timing->memory = memory;
+    timing->writeback = writeback;
+    timing->line_bits = log2(line_size);
+    //one bit per line of the 32-bit address space:
+    size_t words = ((size_t)1 << (MEMORY_ADDRESS - timing->line_bits)) / 64;
+    timing->l2_lines = (uint64_t*)calloc(words ? words : 1, sizeof(uint64_t));
+    if(timing->l2_lines == NULL)
+    {
+        free(timing);
+        return NULL;
+    }
+    return timing;
+}
+
+/**
+  * @brief      Parse latencies "L1,L2,MEM,WB", or "default".
+  * @param      str: input string.
+  * @param      latencies: array of 4 values to fill.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int timing_parse(const char* str, uint32_t* latencies)
+{
+    if(strcmp(str, "default") == 0)
+    {
+        latencies[0] = TIMING_DEFAULT_L1_HIT;
+        latencies[1] = TIMING_DEFAULT_L2_HIT;
+        latencies[2] = TIMING_DEFAULT_MEMORY;
+        latencies[3] = TIMING_DEFAULT_WRITEBACK;
+        return SUCCESS;
+    }
+    if(sscanf(str, "%u,%u,%u,%u", &latencies[0], &latencies[1],
+                &latencies[2], &latencies[3]) != 4)
+    {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Latency of an L2 read, the line is in L2 afterwards.
+  * @param      timing: pointer to latency model.
+  * @param      address: byte address.
+  * @retval     l2_hit if L2 holds the line, otherwise memory.
+  */
+uint32_t timing_l2_read(timing_t* timing, uint32_t address)
+{
+    uint32_t line = address >> timing->line_bits;
+    uint64_t line_bit = 1ULL << (line & 63);
+    if(timing->l2_lines[line >> 6] & line_bit)
+    {
+        return timing->l2_hit;
+    }
+    timing->l2_lines[line >> 6] |= line_bit;
+    return timing->memory;
+}
+
+/**
+  * @brief      L2 evicted a line, next read of it goes to memory.
+  * @param      timing: pointer to latency model.
+  * @param      address: byte address.
+  * @retval     None.
+  */
+void timing_l2_evict(timing_t* timing, uint32_t address)
+{
+    uint32_t line = address >> timing->line_bits;
+    timing->l2_lines[line >> 6] &= ~(1ULL << (line & 63));
+}
+
+/**
+  * @brief      Release a latency model.
+  * @param      timing: pointer to latency model, NULL is ignored.
+  * @retval     None.
+  */
+void timing_destroy(timing_t* timing)
+{
+    if(timing == NULL)
+    {
+        return;
+    }
+    free(timing->l2_lines);
+    free(timing);
+}
+
+/**
+  * @brief      Empty the L2 of the latency model.
+  * @param      timing: pointer to latency model.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int timing_clear(timing_t* timing)
+{
+    if(timing == NULL)
+    {
+        return ERROR;
+    }
+    size_t words = ((size_t)1 << (MEMORY_ADDRESS - timing->line_bits)) / 64;
+    memset(timing->l2_lines, 0, (words ? words : 1) * sizeof(uint64_t));
+    return SUCCESS;
+}
+
+/**
+  * @brief      Histogram bin of a latency: floor(log2(latency)).
+  * @param      latency: cycles.
+  * @retval     bin index, 0..TIMING_HIST_BINS-1.
+  */
+int timing_hist_bin(uint32_t latency)
+{
+    if(latency <= 1)
+    {
+        return 0;
+    }
+    int bin = 31 - __builtin_clz(latency);
+    return (bin < TIMING_HIST_BINS) ? bin : TIMING_HIST_BINS - 1;
+}
+/**
+  * @}
+  */
@@ -0,0 +1,483 @@
+/**
+  ***********************************************************************
+  * @file       trace.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Trace reader driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    The simulator replays requests: a command (READ_DATA, WRITE_DATA,
+    INSTRUCTION_FETCH, EVICT, CLEAR_CACHE, PRINT_CONTENT), an address,
+    a core and a repeat count. This driver reads them from the native
+    trace, and directly from the traces of other tools:
+        (+) native  : "<command> <address in hex> [core] [count]", blank
+                      or malformed lines are skipped.
+        (+) Lackey  : valgrind --tool=lackey --trace-mem=yes output.
+                      I is a fetch, L a read, S a write, M (modify) a
+                      read then a write of the same bytes. Lines of
+                      valgrind itself ("==pid== ...") are skipped.
+        (+) DineroIV: din format, "<label> <address> [size]" in hex.
+                      Labels 0, 1, 2 are a read, a write and a fetch,
+                      4 (flush) clears the caches, 3 (escape) is skipped.
+        (+) ChampSim: binary instructions of 64 bytes, little endian:
+                      u64 ip, u8 is_branch, u8 branch_taken, u8 dest regs[2],
+                      u8 src regs[4], u64 dest memory[2], u64 src memory[4].
+                      The ip is fetched, then the source memory operands
+                      are read and the destination ones written, 0 is no
+                      operand. Compressed traces must be decompressed
+                      first (xz -dk trace.champsimtrace.xz).
+    [..]
+    An access of Lackey or DineroIV with a size is split into one record
+    per line it touches, like the L1 caches would see it. The imported
+    traces are single core (core 0, count 1), and 64-bit addresses are
+    truncated to the MEMORY_ADDRESS bits of the simulator.
+    [..]
+    (#) Open the trace by trace_create(), TRACE_AUTO guesses the format
+        from the name and the first line.
+    (#) Read one record at a time by trace_read() until it returns FALSE.
+    (#) Or parse native records from memory by trace_parse_text(), e.g. a
+        chunk of the mapped file starting at a line: the records are the
+        ones trace_read() would return for these lines. Plain lines are
+        scanned by hand, the others by sscanf() like trace_read().
+    (#) Close it by trace_destroy().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#include "trace.h"
+
+
+/* Trace function prototypes -------------------------------------------------*/
+/** @addtogroup Trace_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Parse the name of a trace format.
+  * @param      str: auto, native, lackey, dinero (or din), champsim.
+  * @retval     trace_format_t value, ERROR if unknown.
+  */
+int trace_parse_format(const char* str)
+{
+    if(strcmp(str, "auto") == 0)
+        return TRACE_AUTO;
+    if(strcmp(str, "native") == 0)
+        return TRACE_NATIVE;
+    if(strcmp(str, "lackey") == 0)
+        return TRACE_LACKEY;
+    if(strcmp(str, "dinero") == 0 || strcmp(str, "din") == 0)
+        return TRACE_DINERO;
+    if(strcmp(str, "champsim") == 0)
+        return TRACE_CHAMPSIM;
+    return ERROR;
+}
+
+/**
+  * @brief      Name of a format, as parsed by trace_parse_format().
+  * @param      format: see trace_format_t.
+  * @retval     name of the format.
+  */
+const char* trace_format_name(trace_format_t format)
+{
+    static const char* names[] = {"auto", "native", "lackey", "dinero", "champsim"};
+    if(format < TRACE_AUTO || format > TRACE_CHAMPSIM)
+    {
+        return "auto";
+    }
+    return names[format];
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Guess the format of a trace: the extension, else the first
+  *             line that is not blank. The file is rewound.
+  * @retval     trace_format_t value, never TRACE_AUTO.
+  */
+static trace_format_t trace_detect(FILE* fp, const char* path)
+{
+    char line[TRACE_LINE_SIZE];
+    const char *extension = strrchr(path, '.');
+    trace_format_t format = TRACE_NATIVE;
+    if(extension != NULL && strcmp(extension, ".din") == 0)
+    {
+        return TRACE_DINERO;
+    }
+    if(extension != NULL && strcmp(extension, ".champsimtrace") == 0)
+    {
+        return TRACE_CHAMPSIM;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        const char *p = line + strspn(line, " \t");
+        if(*p == '\n' || *p == '\r' || *p == '\0')
+        {
+            continue;
+        }
+        //"==pid== " or "I  0400d7d4,8" or " L 7ff000398,8":
+        if(strncmp(p, "==", 2) == 0 ||
+           (strchr("ILSM", *p) != NULL && (p[1] == ' ' || p[1] == '\t') && strchr(p, ',') != NULL))
+        {
+            format = TRACE_LACKEY;
+        }
+        break;
+    }
+    rewind(fp);
+    return format;
+}
+
+/**
+  * @brief      Open a trace.
+  * @param      path: trace file.
+  * @param      format: see trace_format_t.
+  * @param      line_size: line size of the caches, a sized access is split
+  *                        at these boundaries.
+  * @retval     pointer to the reader, NULL if failed.
+  */
+trace_t* trace_create(const char* path, trace_format_t format, int line_size)
+{
+    if(path == NULL || line_size <= 0)
+    {
+        return NULL;
+    }
+    trace_t *trace = (trace_t*)calloc(1, sizeof(trace_t));
+    if(trace == NULL)
+    {
+        printf("Error: Cannot create trace reader.\n");
+        return NULL;
+    }
+    trace->fp = fopen(path, (format == TRACE_CHAMPSIM) ? "rb" : "r");
+    if(trace->fp == NULL)
+    {
+        printf("Error: Failed to open file %s.\n", path);
+        free(trace);
+        return NULL;
+    }
+    trace->format = (format == TRACE_AUTO) ? trace_detect(trace->fp, path) : format;
+    trace->line_mask = ~(uint64_t)(line_size - 1);
+    return trace;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Queue an access of the current input record.
+  */
+static void trace_add(trace_t* trace, int command, uint64_t address, uint64_t size)
+{
+    trace_access_t *access = &trace->accesses[trace->accesses_num++];
+    access->command = command;
+    access->address = address;
+    access->end = address + ((size > 0) ? size - 1 : 0);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Parse a hex number, with or without 0x.
+  * @retval     pointer after the number, NULL if there is none.
+  */
+static const char* trace_hex(const char* p, uint64_t* value)
+{
+    char *end;
+    p += strspn(p, " \t");
+    *value = strtoull(p, &end, 16);
+    return (end == p) ? NULL : end;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Read the next input record of each format into accesses.
+  * @retval     TRUE if a record was read, FALSE at the end of the trace.
+  */
+static int trace_next_lackey(trace_t* trace)
+{
+    char line[TRACE_LINE_SIZE];
+    while(fgets(line, sizeof(line), trace->fp) != NULL)
+    {
+        uint64_t address, size;
+        const char *p = line + strspn(line, " \t");
+        char kind = *p;
+        if(strchr("ILSM", kind) == NULL || kind == '\0' ||
+           (p = trace_hex(p + 1, &address)) == NULL || *p != ',')
+        {
+            continue;
+        }
+        size = strtoull(p + 1, NULL, 10);
+        if(kind == 'I')
+            trace_add(trace, INSTRUCTION_FETCH, address, size);
+        else if(kind == 'S')
+            trace_add(trace, WRITE_DATA, address, size);
+        else
+            trace_add(trace, READ_DATA, address, size);
+        if(kind == 'M')
+            trace_add(trace, WRITE_DATA, address, size);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static int trace_next_dinero(trace_t* trace)
+{
+    char line[TRACE_LINE_SIZE];
+    while(fgets(line, sizeof(line), trace->fp) != NULL)
+    {
+        uint64_t label, address, size = 0;
+        const char *p = trace_hex(line, &label);
+        if(p == NULL || (p = trace_hex(p, &address)) == NULL)
+        {
+            continue;
+        }
+        trace_hex(p, &size);
+        if(label == 0)
+            trace_add(trace, READ_DATA, address, size);
+        else if(label == 1)
+            trace_add(trace, WRITE_DATA, address, size);
+        else if(label == 2)
+            trace_add(trace, INSTRUCTION_FETCH, address, size);
+        else if(label == 4)
+            trace_add(trace, CLEAR_CACHE, 0, 0);
+        else
+            continue;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static int trace_next_champsim(trace_t* trace)
+{
+    uint8_t instr[TRACE_CHAMPSIM_SIZE];
+    int i, j;
+    uint64_t operand[7];
+    while(fread(instr, sizeof(instr), 1, trace->fp) == 1)
+    {
+        //ip, destination memory[2] at 16, source memory[4] at 32:
+        for(i = 0; i < 7; i++)
+        {
+            const uint8_t *field = instr + ((i == 0) ? 0 : 8 + 8 * i);
+            operand[i] = 0;
+            for(j = 0; j < 8; j++)
+            {
+                operand[i] |= (uint64_t)field[j] << (8 * j);
+            }
+        }
+        trace_add(trace, INSTRUCTION_FETCH, operand[0], 1);
+        for(i = 3; i < 7; i++)
+        {
+            if(operand[i] != 0)
+                trace_add(trace, READ_DATA, operand[i], 1);
+        }
+        for(i = 1; i < 3; i++)
+        {
+            if(operand[i] != 0)
+                trace_add(trace, WRITE_DATA, operand[i], 1);
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+  * @brief      Read the next record of a trace.
+  * @param      trace: pointer to the reader.
+  * @param      record: the record read.
+  * @retval     TRUE if a record was read, FALSE at the end of the trace.
+  */
+int trace_read(trace_t* trace, trace_record_t* record)
+{
+    int status = TRUE;
+    if(trace->format == TRACE_NATIVE)
+    {
+        char line[TRACE_LINE_SIZE];
+        while(fgets(line, sizeof(line), trace->fp) != NULL)
+        {
+            //the core ID and the repeat count are optional fields:
+            record->core = 0;
+            record->count = 1;
+            if(sscanf(line, "%d %x %d %u", &record->command, &record->address,
+                      &record->core, &record->count) >= 2 && record->count > 0)
+            {
+                return TRUE;
+            }
+        }
+        return FALSE;
+    }
+    if(trace->access_next == trace->accesses_num)
+    {
+        trace->accesses_num = 0;
+        trace->access_next = 0;
+        if(trace->format == TRACE_LACKEY)
+            status = trace_next_lackey(trace);
+        else if(trace->format == TRACE_DINERO)
+            status = trace_next_dinero(trace);
+        else
+            status = trace_next_champsim(trace);
+        if(status == FALSE)
+        {
+            return FALSE;
+        }
+    }
+    trace_access_t *access = &trace->accesses[trace->access_next];
+    record->command = access->command;
+    record->address = (uint32_t)access->address;
+    record->core = 0;
+    record->count = 1;
+    //the rest of an access crossing a line is the next record:
+    if((access->address & trace->line_mask) != (access->end & trace->line_mask))
+    {
+        access->address = (access->address & trace->line_mask) + ~trace->line_mask + 1;
+    }
+    else
+    {
+        trace->access_next++;
+    }
+    return TRUE;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Skip white space, scan an unsigned number of at most digits
+  *             digits (not counting 0x for hex).
+  * @retval     TRUE if a number was read, p after it. FALSE if there is
+  *             anything else, p after the white space if there is no
+  *             digit at all, else unchanged.
+  */
+static int trace_scan(const char** p, const char* end, int hex, int digits, uint32_t* value)
+{
+    const char *s = *p;
+    int n = 0;
+    while(s < end && (*s == ' ' || (*s >= '\t' && *s <= '\r')))
+        s++;
+    if(hex && end - s > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+        s += 2;
+    *value = 0;
+    for(; s < end; s++, n++)
+    {
+        uint32_t digit;
+        if(*s >= '0' && *s <= '9')
+            digit = *s - '0';
+        else if(hex && *s >= 'a' && *s <= 'f')
+            digit = *s - 'a' + 10;
+        else if(hex && *s >= 'A' && *s <= 'F')
+            digit = *s - 'A' + 10;
+        else
+            break;
+        *value = *value * (hex ? 16 : 10) + digit;
+    }
+    if(n > 0 && n <= digits)
+    {
+        *p = s;
+        return TRUE;
+    }
+    if(n == 0)
+    {
+        *p = s;
+    }
+    return FALSE;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Parse one line of a native trace like trace_read():
+  *             "<command> <address> [core] [count]" followed by white
+  *             space only is scanned here, any other line by sscanf().
+  * @retval     TRUE if the line is a record, FALSE if it is skipped.
+  */
+static int trace_parse_line(const char* line, const char* end, trace_record_t* record)
+{
+    char copy[TRACE_LINE_SIZE];
+    const char *p = line;
+    uint32_t command, core, count;
+    record->core = 0;
+    record->count = 1;
+    int status = trace_scan(&p, end, 0, 9, &command);
+    if(status == FALSE && p == end)
+    {
+        //blank line:
+        return FALSE;
+    }
+    if(status == TRUE && trace_scan(&p, end, 1, 8, &record->address) == TRUE)
+    {
+        record->command = (int)command;
+        if(trace_scan(&p, end, 0, 9, &core) == FALSE)
+        {
+            if(p == end)
+                return TRUE;
+        }
+        else
+        {
+            record->core = (int)core;
+            if(trace_scan(&p, end, 0, 9, &count) == FALSE)
+            {
+                if(p == end)
+                    return TRUE;
+            }
+            else if(count > 0)
+            {
+                //trailing text is ignored, like by sscanf():
+                record->count = count;
+                return TRUE;
+            }
+        }
+    }
+    memcpy(copy, line, end - line);
+    copy[end - line] = '\0';
+    record->core = 0;
+    record->count = 1;
+    return (sscanf(copy, "%d %x %d %u", &record->command, &record->address,
+                   &record->core, &record->count) >= 2 && record->count > 0) ? TRUE : FALSE;
+}
+
+/**
+  * @brief      Parse the next record of native trace text in memory.
+  * @param      p: position in the text, at the start of a line, moved
+  *                after the line of the record.
+  * @param      end: end of the text.
+  * @param      record: the record read.
+  * @retval     TRUE if a record was read, FALSE at the end of the text.
+  */
+int trace_parse_text(const char** p, const char* end, trace_record_t* record)
+{
+    while(*p < end)
+    {
+        const char *line = *p;
+        //fgets() of trace_read() cuts longer lines the same way:
+        const char *line_end = (end - line > TRACE_LINE_SIZE - 1) ? line + TRACE_LINE_SIZE - 1 : end;
+        const char *newline = memchr(line, '\n', line_end - line);
+        if(newline != NULL)
+        {
+            line_end = newline + 1;
+        }
+        *p = line_end;
+        if(trace_parse_line(line, line_end, record) == TRUE)
+        {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+  * @brief      Close a trace.
+  * @param      trace: pointer to the reader, NULL is ignored.
+  * @retval     None.
+  */
+void trace_destroy(trace_t* trace)
+{
+    if(trace == NULL)
+    {
+        return;
+    }
+    fclose(trace->fp);
+    free(trace);
+}
+/**
+  * @}
+  */
@@ -0,0 +1,358 @@
+/**
+  ***********************************************************************
+  * @file       traceidx.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Trace index driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    To simulate one phase of a long native trace, the reader would have
+    to parse every record before it. The index of a trace is built once,
+    by one pass over the mapped file (trace_parse_text()), and kept next
+    to it in "<trace>.idx":
+        (+) seek points: the offset of every TRACEIDX_INTERVAL-th record.
+        (+) controls   : the number of every CLEAR_CACHE and PRINT_CONTENT
+                         record, the natural bounds of the phases.
+    A seek goes to the point before the record, then reads at most
+    TRACEIDX_INTERVAL - 1 records. The records are counted like
+    trace_read() returns them, blank and malformed lines are not records.
+    The size and modification time of the trace are kept in the index,
+    a trace changed since is indexed again.
+    [..]
+    (#) Get the index of a trace by traceidx_open(): the index file if it
+        is up to date, else a new one (saved if possible).
+    (#) Move a reader of the trace to a record by traceidx_seek().
+    (#) traceidx_log() prints the records and the control records.
+    (#) Release it by traceidx_destroy().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cache.h"
+#include "traceidx.h"
+
+
+/* Trace index function prototypes -------------------------------------------------*/
+/** @addtogroup Trace_index_data_structures
+  * @{
+  */
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Make room for one more element of an array.
+  * @retval     SUCCESS, ERROR if out of memory.
+  */
+static int traceidx_grow(void** array, uint64_t* capacity, uint64_t used, size_t size)
+{
+    void *grown;
+    if(used < *capacity)
+    {
+        return SUCCESS;
+    }
+    grown = realloc(*array, (*capacity ? 2 * *capacity : 1024) * size);
+    if(grown == NULL)
+    {
+        printf("Error: Cannot grow trace index.\n");
+        return ERROR;
+    }
+    *array = grown;
+    *capacity = *capacity ? 2 * *capacity : 1024;
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Index the records of a text, the mapped trace.
+  * @retval     SUCCESS, ERROR if out of memory.
+  */
+static int traceidx_scan(trace_index_t* index, const char* text, size_t size)
+{
+    const char *p = text;
+    uint64_t points_capacity = 0, controls_capacity = 0;
+    trace_record_t record;
+    trace_index_header_t *header = &index->header;
+    while(1)
+    {
+        if(header->records % header->interval == 0)
+        {
+            if(traceidx_grow((void**)&index->points, &points_capacity, header->points_num, sizeof(uint64_t)) < 0)
+            {
+                return ERROR;
+            }
+            index->points[header->points_num++] = p - text;
+        }
+        if(trace_parse_text(&p, text + size, &record) == FALSE)
+        {
+            break;
+        }
+        if(record.command == CLEAR_CACHE || record.command == PRINT_CONTENT)
+        {
+            if(traceidx_grow((void**)&index->controls, &controls_capacity, header->controls_num,
+                             sizeof(trace_control_t)) < 0)
+            {
+                return ERROR;
+            }
+            index->controls[header->controls_num].record = header->records;
+            index->controls[header->controls_num].command = record.command;
+            index->controls[header->controls_num].reserved = 0;
+            header->controls_num++;
+        }
+        header->records++;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Build the index of a trace.
+  * @retval     pointer to the index, NULL if failed.
+  */
+static trace_index_t* traceidx_build(const char* trace_path, const struct stat* st)
+{
+    void *text = NULL;
+    int status;
+    int fd = open(trace_path, O_RDONLY);
+    if(fd < 0)
+    {
+        printf("Error: Failed to open file %s.\n", trace_path);
+        return NULL;
+    }
+    if(st->st_size > 0)
+    {
+        text = mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if(text == MAP_FAILED)
+    {
+        printf("Error: Cannot map file %s.\n", trace_path);
+        return NULL;
+    }
+    trace_index_t *index = (trace_index_t*)calloc(1, sizeof(trace_index_t));
+    if(index == NULL)
+    {
+        printf("Error: Cannot create trace index.\n");
+        status = ERROR;
+    }
+    else
+    {
+        memcpy(index->header.magic, TRACEIDX_MAGIC, sizeof(index->header.magic));
+        index->header.version = TRACEIDX_VERSION;
+        index->header.interval = TRACEIDX_INTERVAL;
+        index->header.trace_size = st->st_size;
+        index->header.trace_mtime = st->st_mtime;
+        if(text != NULL)
+            madvise(text, st->st_size, MADV_SEQUENTIAL);
+        status = traceidx_scan(index, (const char*)text, st->st_size);
+    }
+    if(text != NULL)
+    {
+        munmap(text, st->st_size);
+    }
+    if(status < 0)
+    {
+        traceidx_destroy(index);
+        return NULL;
+    }
+    return index;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Load an index file.
+  * @retval     pointer to the index, NULL if there is none, or it is not
+  *             the index of the trace as it is now.
+  */
+static trace_index_t* traceidx_load(const char* path, const struct stat* st)
+{
+    trace_index_header_t header;
+    trace_index_t *index = NULL;
+    FILE *fp = fopen(path, "rb");
+    if(fp == NULL)
+    {
+        return NULL;
+    }
+    if(fread(&header, sizeof(header), 1, fp) == 1 &&
+       memcmp(header.magic, TRACEIDX_MAGIC, sizeof(header.magic)) == 0 &&
+       header.version == TRACEIDX_VERSION && header.interval == TRACEIDX_INTERVAL &&
+       header.trace_size == (uint64_t)st->st_size && header.trace_mtime == (int64_t)st->st_mtime &&
+       header.points_num == header.records / header.interval + 1 &&
+       header.controls_num <= header.records)
+    {
+        index = (trace_index_t*)calloc(1, sizeof(trace_index_t));
+    }
+    if(index != NULL)
+    {
+        index->header = header;
+        index->points = (uint64_t*)malloc(header.points_num * sizeof(uint64_t));
+        index->controls = (trace_control_t*)malloc((header.controls_num + 1) * sizeof(trace_control_t));
+        if(index->points == NULL || index->controls == NULL ||
+           fread(index->points, sizeof(uint64_t), header.points_num, fp) != header.points_num ||
+           fread(index->controls, sizeof(trace_control_t), header.controls_num, fp) != header.controls_num)
+        {
+            traceidx_destroy(index);
+            index = NULL;
+        }
+    }
+    fclose(fp);
+    return index;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Save an index file, a partial file is removed.
+  * @retval     SUCCESS, ERROR if it cannot be written.
+  */
+static int traceidx_save(const trace_index_t* index, const char* path)
+{
+    int status = SUCCESS;
+    FILE *fp = fopen(path, "wb");
+    if(fp == NULL)
+    {
+        return ERROR;
+    }
+    if(fwrite(&index->header, sizeof(index->header), 1, fp) != 1 ||
+       fwrite(index->points, sizeof(uint64_t), index->header.points_num, fp) != index->header.points_num ||
+       fwrite(index->controls, sizeof(trace_control_t), index->header.controls_num, fp) != index->header.controls_num)
+    {
+        status = ERROR;
+    }
+    if(fclose(fp) != 0 || status < 0)
+    {
+        remove(path);
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Get the index of a native trace, build it if the index file
+  *             is missing or out of date.
+  * @param      trace_path: trace file.
+  * @retval     pointer to the index, NULL if failed. An index that cannot
+  *             be saved (read-only directory) is only kept in memory.
+  */
+trace_index_t* traceidx_open(const char* trace_path)
+{
+    struct stat st;
+    trace_index_t *index;
+    if(trace_path == NULL || stat(trace_path, &st) < 0 || !S_ISREG(st.st_mode))
+    {
+        printf("Error: Cannot index %s.\n", (trace_path != NULL) ? trace_path : "(null)");
+        return NULL;
+    }
+    char *path = (char*)malloc(strlen(trace_path) + sizeof(TRACEIDX_EXTENSION));
+    if(path == NULL)
+    {
+        printf("Error: Cannot create trace index.\n");
+        return NULL;
+    }
+    strcpy(path, trace_path);
+    strcat(path, TRACEIDX_EXTENSION);
+    index = traceidx_load(path, &st);
+    if(index == NULL)
+    {
+        index = traceidx_build(trace_path, &st);
+        if(index != NULL)
+        {
+            traceidx_save(index, path);
+        }
+    }
+    free(path);
+    return index;
+}
+
+/**
+  * @brief      Move a reader of the indexed trace to a record.
+  * @param      index: pointer to the index.
+  * @param      trace: reader of the trace, TRACE_NATIVE.
+  * @param      record: number of the next record to read, from 0. At or
+  *                     after the last record, the reader is at the end.
+  * @retval     SUCCESS, ERROR if failed.
+  */
+int traceidx_seek(const trace_index_t* index, trace_t* trace, uint64_t record)
+{
+    trace_record_t skipped;
+    uint64_t i;
+    if(index == NULL || trace == NULL || trace->format != TRACE_NATIVE)
+    {
+        return ERROR;
+    }
+    if(record >= index->header.records)
+    {
+        return (fseeko(trace->fp, 0, SEEK_END) == 0) ? SUCCESS : ERROR;
+    }
+    if(fseeko(trace->fp, (off_t)index->points[record / index->header.interval], SEEK_SET) != 0)
+    {
+        printf("Error: Cannot seek the trace.\n");
+        return ERROR;
+    }
+    for(i = 0; i < record % index->header.interval; i++)
+    {
+        if(trace_read(trace, &skipped) == FALSE)
+        {
+            printf("Error: Trace shorter than its index.\n");
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Print an index: the records and the control records.
+  * @param      index: pointer to the index.
+  * @param      fp: output file.
+  * @retval     SUCCESS, ERROR if failed.
+  */
+int traceidx_log(const trace_index_t* index, FILE* fp)
+{
+    uint64_t i;
+    if(index == NULL || fp == NULL)
+    {
+        return ERROR;
+    }
+    fprintf(fp, "> Records       : %llu\n", (unsigned long long)index->header.records);
+    fprintf(fp, "> Seek points   : %llu, every %u records\n",
+                (unsigned long long)index->header.points_num, index->header.interval);
+    fprintf(fp, "> Controls      : %llu\n", (unsigned long long)index->header.controls_num);
+    for(i = 0; i < index->header.controls_num; i++)
+    {
+        if(fprintf(fp, "  %llu %s\n", (unsigned long long)index->controls[i].record,
+                   (index->controls[i].command == CLEAR_CACHE) ? "clear" : "print") < 0)
+        {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Release an index.
+  * @param      index: pointer to the index, NULL is ignored.
+  * @retval     None.
+  */
+void traceidx_destroy(trace_index_t* index)
+{
+    if(index == NULL)
+    {
+        return;
+    }
+    free(index->points);
+    free(index->controls);
+    free(index);
+}
+/**
+  * @}
+  */
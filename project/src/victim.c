@@ -0,0 +1,219 @@
+/**
+  ***********************************************************************
+  * @file       victim.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Victim buffer driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    A victim buffer is a small fully-associative store of lines that
+    were replaced in one L1 cache. Attach it to a cache by setting
+    cache->victim, the cache request APIs do the rest:
+        (+) On L1 miss the buffer is probed before cache_L2_read().
+            A hit swaps the line back into L1 (return bit VICTIM_HIT).
+        (+) On L1 replacement the old line is placed in the buffer, a
+            dirty line pushed out of the buffer is written to L2.
+        (+) On L2 evict command the line is removed from the buffer too,
+            to keep the inclusion.
+    [..]
+    (#) Create by victim_create(), entries_num <= VICTIM_MAX_ENTRIES.
+    (#) Lookup is a SIMD compare over the line address array.
+    (#) Log the statistic next to cache_log() by victim_log().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#include "victim.h"
+#include "simd.h"
+
+
+/* Victim buffer function prototypes -------------------------------------------------*/
+/** @addtogroup Victim_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Create a victim buffer.
+  * @param      entries_num: number of lines, 1..VICTIM_MAX_ENTRIES.
+  * @param      line_size: line size of the owner cache.
+  * @retval     pointer to the victim buffer, NULL if failed.
+  */
+victim_t* victim_create(int entries_num, int line_size)
+{
+    if(entries_num <= 0 || entries_num > VICTIM_MAX_ENTRIES)
+    {
+        printf("Error: Victim buffer supports 1..%d entries.\n", VICTIM_MAX_ENTRIES);
+        return NULL;
+    }
+    victim_t *vc = (victim_t*)malloc(sizeof(victim_t));
+    if(vc == NULL)
+    {
+        return NULL;
+    }
+    vc->entries_num = entries_num;
+    vc->line_size = line_size;
+    vc->data = (uint8_t*)malloc(entries_num * line_size * sizeof(uint8_t));
+    if(vc->data == NULL)
+    {
+        free(vc);
+        return NULL;
+    }
+    victim_clear(vc);
+    return vc;
+}
+
+/**
+  * @brief      Search a line in the victim buffer.
+  * @param      vc: pointer to victim buffer.
+  * @param      line: line address.
+  * @retval     index of the entry if present, otherwise FALSE.
+  */
+int victim_lookup(victim_t* vc, uint32_t line)
+{
+    int index = simd_find_u32(vc->lines, SIMD_ROUND_U32(vc->entries_num), line);
+    return (index < 0) ? FALSE : index;
+}
+
+/**
+  * @brief      Select the entry for a new line: an empty entry first,
+  *             otherwise the least recently placed one.
+  *             Note: if the selected entry is dirty, the caller must
+  *             write it to L2 before victim_place().
+  * @param      vc: pointer to victim buffer.
+  * @retval     index of the entry.
+  */
+int victim_select(victim_t* vc)
+{
+    int i;
+    int index = 0;
+    for(i = 0; i < vc->entries_num; i++)
+    {
+        if(vc->lines[i] == VICTIM_INVALID_LINE)
+        {
+            return i;
+        }
+        if(vc->clock - vc->stamp[i] > vc->clock - vc->stamp[index])
+        {
+            index = i;
+        }
+    }
+    return index;
+}
+
+/**
+  * @brief      Place a line evicted from L1 into an entry.
+  * @param      vc: pointer to victim buffer.
+  * @param      index: entry from victim_select().
+  * @param      line: line address.
+  * @param      data: line data, line_size bytes.
+  * @param      dirty: 1 if the line is modified.
+  * @retval     None.
+  */
+void victim_place(victim_t* vc, int index, uint32_t line, uint8_t* data, int dirty)
+{
+    if(vc->lines[index] != VICTIM_INVALID_LINE && vc->dirty[index])
+    {
+        vc->writebacks++;
+    }
+    vc->lines[index] = line;
+    vc->dirty[index] = dirty ? 1 : 0;
+    vc->stamp[index] = vc->clock++;
+    memcpy(VICTIM_DATA(vc, index), data, vc->line_size);
+    vc->fills++;
+}
+
+/**
+  * @brief      Remove an entry, after it is moved back to L1 or evicted by L2.
+  * @param      vc: pointer to victim buffer.
+  * @param      index: entry index.
+  * @retval     None.
+  */
+void victim_invalidate(victim_t* vc, int index)
+{
+    vc->lines[index] = VICTIM_INVALID_LINE;
+    vc->dirty[index] = 0;
+}
+
+/**
+  * @brief      Release a victim buffer.
+  * @param      vc: pointer to victim buffer, NULL is ignored.
+  * @retval     None.
+  */
+void victim_destroy(victim_t* vc)
+{
+    if(vc == NULL)
+    {
+        return;
+    }
+    free(vc->data);
+    free(vc);
+}
+
+/**
+  * @brief      Clear all entries and statistic of the victim buffer.
+  * @param      vc: pointer to victim buffer.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int victim_clear(victim_t* vc)
+{
+    int i;
+    if(vc == NULL)
+    {
+        return ERROR;
+    }
+    for(i = 0; i < VICTIM_MAX_ENTRIES; i++)
+    {
+        vc->lines[i] = VICTIM_INVALID_LINE;
+        vc->stamp[i] = 0;
+        vc->dirty[i] = 0;
+    }
+    vc->clock = 0;
+    vc->probes = 0;
+    vc->hits = 0;
+    vc->fills = 0;
+    vc->writebacks = 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Log victim buffer statistic to file, right after cache_log().
+  *             Nothing is written when the buffer is NULL (disabled).
+  * @param      vc: pointer to victim buffer.
+  * @param      fp: log file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int victim_log(victim_t* vc, FILE* fp)
+{
+    if(vc == NULL)
+    {
+        return SUCCESS;
+    }
+    if(fp == NULL)
+    {
+        return ERROR;
+    }
+    fprintf(fp, "> Victim buffer : %d lines\n", vc->entries_num);
+    fprintf(fp, "> VB probes     : %d\n", vc->probes);
+    fprintf(fp, "> VB hits       : %d\n", vc->hits);
+    fprintf(fp, "> VB fills      : %d\n", vc->fills);
+    fprintf(fp, "> VB writebacks : %d\n", vc->writebacks);
+    if(vc->probes > 0)
+    {
+        fprintf(fp, "> VB hit rate   : %.1f%%\n", vc->hits * 100.0 / vc->probes);
+    }
+    fprintf(fp, "------------------------------\n");
+    return SUCCESS;
+}
+/**
+  * @}
+  */
@@ -0,0 +1,270 @@
+/**
+  ***********************************************************************
+  * @file       writebuf.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Coalescing write buffer driver.
+  @verbatim
+  =======================================================================
+                    #### How to use this driver ####
+  =======================================================================
+    [..]
+    Attach a write buffer to a cache by setting cache->wbuf. Every L1
+    write to L2 (writeback of a dirty line, or write-through of a byte)
+    then goes through the buffer:
+        (+) Line already buffered: the write is coalesced into the entry,
+            no extra L2 write.
+        (+) Buffer full          : the oldest entry is written to L2.
+        (+) L1 reads the line    : the entry is flushed to L2 first.
+    [..]
+    (#) Create by writebuf_create(), entries_num <= WB_MAX_ENTRIES.
+    (#) Entries still pending at the end can be written by writebuf_drain().
+    (#) The bytes written to L2 are counted by parts of the line: one
+        byte up to 64-byte lines, line_size / 64 bytes above, so a byte
+        written in a 128-byte line counts as 2.
+    (#) Log the L2 write traffic next to cache_log() by writebuf_log().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdlib.h>
+#include "cache.h"
+#include "writebuf.h"
+#include "simd.h"
+
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Bytes of a slot written to L2.
+  * @param      wb: pointer to write buffer.
+  * @param      index: slot holding a line.
+  * @retval     number of bytes.
+  */
+static inline uint64_t writebuf_bytes(write_buffer_t* wb, int index)
+{
+    if(wb->masks[index] == WB_FULL_LINE)
+    {
+        return (uint64_t)wb->line_size;
+    }
+    return (uint64_t)__builtin_popcountll(wb->masks[index]) << wb->mask_shift;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Write the oldest slot of the ring to L2.
+  * @param      wb: pointer to write buffer, count must be > 0.
+  * @retval     1 if a line was written to L2, 0 if the slot was a hole.
+  */
+static int writebuf_pop(write_buffer_t* wb)
+{
+    int written = 0;
+    int index = wb->head;
+    if(wb->lines[index] != WB_INVALID_LINE)
+    {
+        wb->l2_writes++;
+        wb->l2_bytes += writebuf_bytes(wb, index);
+        wb->lines[index] = WB_INVALID_LINE;
+        wb->masks[index] = 0;
+        written = 1;
+    }
+    wb->head = (wb->head + 1) % wb->entries_num;
+    wb->count--;
+    return written;
+}
+
+/* Write buffer function prototypes -------------------------------------------------*/
+/** @addtogroup Write_buffer_data_structures
+  * @{
+  */
+
+/**
+  * @brief      Create a write buffer.
+  * @param      entries_num: number of lines, 1..WB_MAX_ENTRIES.
+  * @param      line_size: line size of the owner cache.
+  * @retval     pointer to the write buffer, NULL if failed.
+  */
+write_buffer_t* writebuf_create(int entries_num, int line_size)
+{
+    if(entries_num <= 0 || entries_num > WB_MAX_ENTRIES)
+    {
+        printf("Error: Write buffer supports 1..%d entries.\n", WB_MAX_ENTRIES);
+        return NULL;
+    }
+    write_buffer_t *wb = (write_buffer_t*)malloc(sizeof(write_buffer_t));
+    if(wb == NULL)
+    {
+        return NULL;
+    }
+    wb->entries_num = entries_num;
+    wb->line_size = line_size;
+    wb->mask_shift = (LOG2(line_size) > LOG2(WB_MASK_BITS)) ?
+                        LOG2(line_size) - LOG2(WB_MASK_BITS) : 0;
+    writebuf_clear(wb);
+    return wb;
+}
+
+/**
+  * @brief      Put an L1 write to L2 into the buffer.
+  * @param      wb: pointer to write buffer.
+  * @param      address: byte address of the write.
+  * @param      size: number of bytes written, >= line size for a writeback.
+  * @retval     number of lines written to L2 to make room (0 or 1).
+  */
+int writebuf_write(write_buffer_t* wb, uint32_t address, int size)
+{
+    int written = 0;
+    uint32_t line = address & ~(uint32_t)(wb->line_size - 1);
+    uint32_t offset = address & (wb->line_size - 1);
+    uint64_t mask;
+    if(size >= wb->line_size)
+    {
+        mask = WB_FULL_LINE;
+    }
+    else
+    {
+        //the parts from the first to the last byte written:
+        uint32_t first = offset >> wb->mask_shift;
+        uint32_t parts = ((offset + size - 1) >> wb->mask_shift) - first + 1;
+        mask = ((parts >= WB_MASK_BITS) ? WB_FULL_LINE : ((1ULL << parts) - 1)) << first;
+    }
+    wb->writes++;
+    int index = simd_find_u32(wb->lines, SIMD_ROUND_U32(wb->entries_num), line);
+    if(index >= 0)
+    {
+        wb->masks[index] |= mask;
+        wb->coalesced++;
+        return written;
+    }
+    if(wb->count == wb->entries_num)
+    {
+        //no room: the oldest entry goes to L2 now, a hole just frees its slot.
+        written = writebuf_pop(wb);
+        wb->full += written;
+    }
+    index = (wb->head + wb->count) % wb->entries_num;
+    wb->lines[index] = line;
+    wb->masks[index] = mask;
+    wb->count++;
+    return written;
+}
+
+/**
+  * @brief      Write a buffered line to L2 before L1 reads it again.
+  * @param      wb: pointer to write buffer.
+  * @param      address: byte address in the line.
+  * @retval     1 if the line was buffered and written to L2, otherwise 0.
+  */
+int writebuf_flush_line(write_buffer_t* wb, uint32_t address)
+{
+    uint32_t line = address & ~(uint32_t)(wb->line_size - 1);
+    int index = simd_find_u32(wb->lines, SIMD_ROUND_U32(wb->entries_num), line);
+    if(index < 0)
+    {
+        return 0;
+    }
+    wb->flushes++;
+    wb->l2_writes++;
+    wb->l2_bytes += writebuf_bytes(wb, index);
+    //leave a hole, it is skipped when the ring reaches it.
+    wb->lines[index] = WB_INVALID_LINE;
+    wb->masks[index] = 0;
+    return 1;
+}
+
+/**
+  * @brief      Write every pending line to L2.
+  * @param      wb: pointer to write buffer.
+  * @retval     number of lines written.
+  */
+int writebuf_drain(write_buffer_t* wb)
+{
+    int written = 0;
+    while(wb->count > 0)
+    {
+        written += writebuf_pop(wb);
+    }
+    return written;
+}
+
+/**
+  * @brief      Release a write buffer. Pending lines are dropped,
+  *             call writebuf_drain() first to count them as written.
+  * @param      wb: pointer to write buffer, NULL is ignored.
+  * @retval     None.
+  */
+void writebuf_destroy(write_buffer_t* wb)
+{
+    free(wb);
+}
+
+/**
+  * @brief      Clear all entries and statistic of the write buffer.
+  * @param      wb: pointer to write buffer.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int writebuf_clear(write_buffer_t* wb)
+{
+    int i;
+    if(wb == NULL)
+    {
+        return ERROR;
+    }
+    for(i = 0; i < WB_MAX_ENTRIES; i++)
+    {
+        wb->lines[i] = WB_INVALID_LINE;
+        wb->masks[i] = 0;
+    }
+    wb->head = 0;
+    wb->count = 0;
+    wb->writes = 0;
+    wb->coalesced = 0;
+    wb->full = 0;
+    wb->flushes = 0;
+    wb->l2_writes = 0;
+    wb->l2_bytes = 0;
+    return SUCCESS;
+}
+
+/**
+  * @brief      Log write buffer statistic to file, right after cache_log().
+  *             Nothing is written when the buffer is NULL (disabled).
+  * @param      wb: pointer to write buffer.
+  * @param      fp: log file.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+int writebuf_log(write_buffer_t* wb, FILE* fp)
+{
+    int i, pending = 0;
+    if(wb == NULL)
+    {
+        return SUCCESS;
+    }
+    if(fp == NULL)
+    {
+        return ERROR;
+    }
+    for(i = 0; i < wb->entries_num; i++)
+    {
+        if(wb->lines[i] != WB_INVALID_LINE)
+        {
+            pending++;
+        }
+    }
+    fprintf(fp, "> Write buffer  : %d lines\n", wb->entries_num);
+    fprintf(fp, "> WB writes in  : %d\n", wb->writes);
+    fprintf(fp, "> WB coalesced  : %d\n", wb->coalesced);
+    fprintf(fp, "> WB full       : %d\n", wb->full);
+    fprintf(fp, "> WB flushes    : %d\n", wb->flushes);
+    fprintf(fp, "> WB pending    : %d\n", pending);
+    fprintf(fp, "> L2 writes     : %d\n", wb->l2_writes);
+    fprintf(fp, "> L2 write bytes: %llu\n", (unsigned long long)wb->l2_bytes);
+    fprintf(fp, "------------------------------\n");
+    return SUCCESS;
+}
+/**
+  * @}
+  */
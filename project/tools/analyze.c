@@ -0,0 +1,879 @@
+/**
+  ***********************************************************************
+  * @file       analyze.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Trace analysis, without simulating any cache.
+  @verbatim
+  =======================================================================
+                    #### How to use this tool ####
+  =======================================================================
+    [..]
+    A trace can be characterized much faster than it is simulated, to
+    choose the traces and the cache sizes worth a full simulation. For
+    each trace (records "<command> <address> [core] [count]", or a trace
+    of another tool, see trace.c) it reports:
+        (+) Mix       : reads, writes, fetches (with their repeat counts),
+                        evicts, clears and prints.
+        (+) Footprint : distinct lines touched. Exact from a hash set of
+                        the lines, HyperLogLog estimates (2^14 registers,
+                        about 1% error) for instruction and data lines,
+                        and for the whole trace when the lines do not fit
+                        in --exact-limit.
+        (+) Working set: distinct lines in the last W records, averaged
+                        over the trace, and its maximum, for each W.
+        (+) Reuse time: records since the previous access to the same
+                        line, power of 2 histogram, and first accesses.
+        (+) Locality  : accesses to the line of the previous record, and
+                        lines entering the smallest window while one of
+                        their neighbours (line - 1, line + 1) is in it.
+    [..]
+    The trace is streamed in chunks of --chunk records, read by
+    trace_read() while the threads analyze the previous chunk. A chunk
+    starts with the last W records of the previous one (W the largest
+    window), so the memory does not grow with the length of the trace.
+    Each thread analyzes one part of the chunk, after replaying the last
+    W records before its part without counting them, so the windows are
+    exact across parts and chunks. The first accesses of a thread are
+    then checked against the lines of the earlier parts, so the
+    footprint, the first accesses and the reuse times are exact too,
+    unless a thread had to drop lines or the trace has more than
+    --exact-limit lines: those are then reported as estimates. A thread
+    replays W records for its part, so chunks much larger than threads
+    times W are faster.
+    [..]
+    (#) make analyzer, then ./analyzer [options] trace ..., see usage().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "sim.h"
+
+
+/** @defgroup Analyze_configuration
+  * @brief    ANALYZE_MAX_WINDOWS: working set windows of one run.
+  *           ANALYZE_HLL_BITS   : HyperLogLog index bits, 2^bits registers.
+  *           ANALYZE_REUSE_BINS : reuse time histogram, bin i counts
+  *                                [2^i, 2^(i+1)) records.
+  *           ANALYZE_DEFAULT_LIMIT: lines kept by one thread before the
+  *                                lines out of every window are dropped.
+  *           ANALYZE_DEFAULT_CHUNK: records read while the previous ones
+  *                                are analyzed.
+  *           ANALYZE_MIN_RECORDS: records of a chunk per thread, fewer
+  *                                threads on a smaller chunk.
+  * @{
+  */
+#define ANALYZE_MAX_THREADS         64
+#define ANALYZE_MAX_WINDOWS         8
+#define ANALYZE_HLL_BITS            14
+#define ANALYZE_HLL_REGISTERS       (1 << ANALYZE_HLL_BITS)
+#define ANALYZE_REUSE_BINS          40
+#define ANALYZE_DEFAULT_LIMIT       (1 << 24)
+#define ANALYZE_DEFAULT_CHUNK       (1 << 22)
+#define ANALYZE_MIN_RECORDS         4096
+#define ANALYZE_COMMANDS            10
+#define ANALYZE_I                   0
+#define ANALYZE_D                   1
+/**
+  * @}
+  */
+
+/* Analyze data structures ----------------------------------------------*/
+/** @defgroup Analyze_data_structures
+  * @{
+  */
+
+/* Access record */
+/**
+  * @brief    One read, write or fetch record of the trace, count is its
+  *           repeat count (1 if not given).
+  */
+typedef struct record_struct {
+    uint32_t line;
+    uint32_t count;
+    uint8_t command;
+}record_t;
+
+/* Line of the hash set */
+/**
+  * @brief    first/last: times (record index + 1) of the first and last
+  *           access seen by the thread, first 0 for an empty entry.
+  */
+typedef struct line_entry_struct {
+    uint64_t first;
+    uint64_t last;
+    uint32_t line;
+}line_entry_t;
+
+/* Hash set of lines, open addressing, linear probing */
+typedef struct line_map_struct {
+    line_entry_t* entries;
+    uint64_t size;
+    uint64_t used;
+}line_map_t;
+
+/* Options of a run */
+typedef struct options_struct {
+    int threads;
+    int line_bits;
+    int windows_num;
+    uint64_t windows[ANALYZE_MAX_WINDOWS];
+    uint64_t limit;
+    uint64_t chunk;
+    trace_format_t trace_format;
+}options_t;
+
+/* Chunk of records in memory */
+/**
+  * @brief    records: the last records of the previous chunk (kept, up to
+  *           the largest window), then the new ones, records_num in all.
+  *           base: index in the trace of records[0].
+  */
+typedef struct chunk_struct {
+    record_t* records;
+    uint64_t records_num;
+    uint64_t kept;
+    uint64_t base;
+}chunk_t;
+
+/* Worker: one part of the records of each chunk */
+/**
+  * @brief    begin/end: records analyzed (not the warm-up before them),
+  *           indexes in the trace, the chunk holds them from base.
+  *           exact: 0 if lines were dropped, see worker_purge().
+  *           The counters add up over the chunks.
+  */
+typedef struct worker_struct {
+    const options_t* options;
+    pthread_t thread;
+    const record_t* records;
+    uint64_t base;
+    uint64_t begin;
+    uint64_t end;
+    line_map_t map;
+    uint64_t limit;
+    int exact;
+    uint64_t cold;
+    uint64_t reuse[ANALYZE_REUSE_BINS];
+    uint64_t same_line;
+    uint64_t new_lines;
+    uint64_t neighbor_hits;
+    uint64_t ws_sum[ANALYZE_MAX_WINDOWS];
+    uint64_t ws_max[ANALYZE_MAX_WINDOWS];
+    uint8_t hll[2][ANALYZE_HLL_REGISTERS];
+}worker_t;
+
+/**
+  * @}
+  */
+
+/* Analyze function prototypes -------------------------------------------------*/
+/** @addtogroup Analyze_data_structures
+  * @{
+  */
+void usage(char* prog);
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Hash set of lines: create, find, insert, release.
+  */
+static int map_init(line_map_t* map, uint64_t size)
+{
+    map->entries = (line_entry_t*)calloc(size, sizeof(line_entry_t));
+    map->size = size;
+    map->used = 0;
+    return (map->entries != NULL) ? SUCCESS : ERROR;
+}
+
+static inline uint64_t map_slot(const line_map_t* map, uint32_t line)
+{
+    return ((uint64_t)line * 0x9E3779B97F4A7C15ULL >> 20) & (map->size - 1);
+}
+
+static inline line_entry_t* map_find(const line_map_t* map, uint32_t line)
+{
+    uint64_t i = map_slot(map, line);
+    while(map->entries[i].first != 0)
+    {
+        if(map->entries[i].line == line)
+        {
+            return &map->entries[i];
+        }
+        i = (i + 1) & (map->size - 1);
+    }
+    return NULL;
+}
+
+static int map_rehash(line_map_t* map, uint64_t size, uint64_t keep_after)
+{
+    line_map_t bigger;
+    uint64_t i;
+    if(map_init(&bigger, size) < 0)
+    {
+        return ERROR;
+    }
+    for(i = 0; i < map->size; i++)
+    {
+        line_entry_t *entry = &map->entries[i];
+        if(entry->first != 0 && entry->last > keep_after)
+        {
+            uint64_t j = map_slot(&bigger, entry->line);
+            while(bigger.entries[j].first != 0)
+            {
+                j = (j + 1) & (bigger.size - 1);
+            }
+            bigger.entries[j] = *entry;
+            bigger.used++;
+        }
+    }
+    free(map->entries);
+    *map = bigger;
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Insert a line known to be absent, the table doubles at
+  *             half load.
+  * @retval     the new entry (first and last to set), NULL if failed.
+  */
+static line_entry_t* map_insert(line_map_t* map, uint32_t line)
+{
+    uint64_t i;
+    if(2 * (map->used + 1) > map->size && map_rehash(map, 2 * map->size, 0) < 0)
+    {
+        return NULL;
+    }
+    i = map_slot(map, line);
+    while(map->entries[i].first != 0)
+    {
+        i = (i + 1) & (map->size - 1);
+    }
+    map->entries[i].line = line;
+    map->used++;
+    return &map->entries[i];
+}
+
+static void map_free(line_map_t* map)
+{
+    free(map->entries);
+    map->entries = NULL;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Add a line to a HyperLogLog sketch, and estimate the
+  *             number of distinct lines of a sketch.
+  */
+static inline void hll_add(uint8_t* registers, uint32_t line)
+{
+    //splitmix64 finalizer:
+    uint64_t h = line + 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    uint32_t index = h >> (64 - ANALYZE_HLL_BITS);
+    uint64_t rest = (h << ANALYZE_HLL_BITS) | (1ULL << (ANALYZE_HLL_BITS - 1));
+    uint8_t rank = __builtin_clzll(rest) + 1;
+    if(registers[index] < rank)
+    {
+        registers[index] = rank;
+    }
+}
+
+static double hll_estimate(const uint8_t* registers)
+{
+    double m = ANALYZE_HLL_REGISTERS, sum = 0;
+    int i, zeros = 0;
+    for(i = 0; i < ANALYZE_HLL_REGISTERS; i++)
+    {
+        sum += ldexp(1.0, -registers[i]);
+        zeros += (registers[i] == 0);
+    }
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    //small range: linear counting
+    if(estimate <= 2.5 * m && zeros > 0)
+    {
+        estimate = m * log(m / zeros);
+    }
+    return estimate;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Read the next chunk of records with trace_read(), after the
+  *             last records of the previous chunk, and count the commands.
+  * @param      trace: trace reader.
+  * @param      options: options of the run.
+  * @param      previous: previous chunk, records_num 0 for the first one.
+  * @param      chunk: chunk to fill, room for the largest window and
+  *             options->chunk records.
+  * @param      commands, accesses: records of each command, accesses of
+  *             each read/write/fetch command (with their repeat counts).
+  * @retval     number of new records, 0 at the end of the trace.
+  */
+static uint64_t chunk_read(trace_t* trace, const options_t* options, const chunk_t* previous,
+                           chunk_t* chunk, uint64_t* commands, uint64_t* accesses)
+{
+    uint64_t largest = options->windows[options->windows_num - 1];
+    trace_record_t input;
+    chunk->kept = (previous->records_num < largest) ? previous->records_num : largest;
+    chunk->base = previous->base + previous->records_num - chunk->kept;
+    if(chunk->kept > 0)
+    {
+        memcpy(chunk->records, previous->records + previous->records_num - chunk->kept,
+               chunk->kept * sizeof(record_t));
+    }
+    chunk->records_num = chunk->kept;
+    while(chunk->records_num < chunk->kept + options->chunk && trace_read(trace, &input) == TRUE)
+    {
+        commands[((unsigned)input.command < ANALYZE_COMMANDS) ? input.command : ANALYZE_COMMANDS]++;
+        if(input.command == READ_DATA || input.command == WRITE_DATA || input.command == INSTRUCTION_FETCH)
+        {
+            record_t *record = &chunk->records[chunk->records_num++];
+            record->line = input.address >> options->line_bits;
+            record->count = input.count;
+            record->command = input.command;
+            accesses[input.command] += input.count;
+        }
+    }
+    return chunk->records_num - chunk->kept;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Drop the lines out of every window when the thread holds
+  *             too many, the first accesses after that are not exact.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int worker_purge(worker_t* w, uint64_t time)
+{
+    uint64_t largest = w->options->windows[w->options->windows_num - 1];
+    if(map_rehash(&w->map, w->map.size, time > largest ? time - largest : 0) < 0)
+    {
+        return ERROR;
+    }
+    w->exact = 0;
+    if(2 * w->map.used > w->limit)
+    {
+        w->limit *= 2;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Thread of the second pass: replay the warm-up records, then
+  *             analyze records begin..end-1.
+  */
+static void* worker_analyze(void* arg)
+{
+    worker_t *w = (worker_t*)arg;
+    const options_t *o = w->options;
+    uint64_t largest = o->windows[o->windows_num - 1];
+    uint64_t warm = (w->begin > largest) ? w->begin - largest : 0;
+    uint64_t sizes[ANALYZE_MAX_WINDOWS] = {0};
+    uint64_t t;
+    int i;
+    w->exact = 1;
+    w->limit = o->limit;
+    if(map_init(&w->map, 1024) < 0)
+    {
+        return (void*)1;
+    }
+    for(t = warm; t < w->end; t++)
+    {
+        const record_t *record = &w->records[t - w->base];
+        uint64_t time = t + 1;
+        int counted = (t >= w->begin);
+        //records leaving the windows, if they were replayed:
+        for(i = 0; i < o->windows_num; i++)
+        {
+            if(t >= warm + o->windows[i])
+            {
+                line_entry_t *old = map_find(&w->map, w->records[t - o->windows[i] - w->base].line);
+                if(old != NULL && old->last == time - o->windows[i])
+                {
+                    sizes[i]--;
+                }
+            }
+        }
+        line_entry_t *entry = map_find(&w->map, record->line);
+        uint64_t previous = (entry != NULL) ? entry->last : 0;
+        for(i = 0; i < o->windows_num; i++)
+        {
+            if(previous == 0 || previous + o->windows[i] <= time)
+            {
+                sizes[i]++;
+            }
+            if(counted)
+            {
+                w->ws_sum[i] += sizes[i];
+                if(sizes[i] > w->ws_max[i])
+                    w->ws_max[i] = sizes[i];
+            }
+        }
+        if(counted)
+        {
+            if(previous == 0)
+                w->cold++;
+            else
+                w->reuse[63 - __builtin_clzll(time - previous)]++;
+            w->same_line += record->count - 1;
+            if(t > 0 && w->records[t - 1 - w->base].line == record->line)
+                w->same_line++;
+            if(previous == 0 || previous + o->windows[0] <= time)
+            {
+                //entering the smallest window, is a neighbour there?
+                line_entry_t *below = map_find(&w->map, record->line - 1);
+                line_entry_t *above = map_find(&w->map, record->line + 1);
+                w->new_lines++;
+                if((below != NULL && below->last + o->windows[0] > time) ||
+                   (above != NULL && above->last + o->windows[0] > time))
+                    w->neighbor_hits++;
+            }
+            hll_add(w->hll[record->command == INSTRUCTION_FETCH ? ANALYZE_I : ANALYZE_D], record->line);
+        }
+        if(entry == NULL)
+        {
+            entry = map_insert(&w->map, record->line);
+            if(entry == NULL)
+            {
+                return (void*)1;
+            }
+            entry->first = time;
+        }
+        entry->last = time;
+        if(w->map.used > w->limit && worker_purge(w, time) < 0)
+        {
+            return (void*)1;
+        }
+    }
+    return NULL;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Start worker_analyze() on every worker, one thread each,
+  *             and wait for them.
+  * @retval     SUCCESS if every thread succeeded. Otherwise ERROR.
+  */
+static void workers_start(worker_t* workers, int workers_num)
+{
+    int i;
+    for(i = 0; i < workers_num; i++)
+    {
+        if(pthread_create(&workers[i].thread, NULL, worker_analyze, &workers[i]) != 0)
+        {
+            workers[i].thread = 0;
+        }
+    }
+}
+
+static int workers_join(worker_t* workers, int workers_num)
+{
+    int i, status = SUCCESS;
+    for(i = 0; i < workers_num; i++)
+    {
+        void *result = NULL;
+        if(workers[i].thread == 0 || pthread_join(workers[i].thread, &result) != 0 || result != NULL)
+        {
+            status = ERROR;
+        }
+        workers[i].thread = 0;
+    }
+    return status;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Check the first accesses of each worker against the lines
+  *             of the earlier parts and chunks, in trace order.
+  * @param      workers: workers of the chunk, joined.
+  * @param      workers_num: number of workers.
+  * @param      lines: lines seen so far, with their last access.
+  * @param      limit: most lines kept in lines.
+  * @param      cold, reuse: first accesses and reuse times, corrected.
+  * @retval     1 while the lines are exact, 0 once they are not.
+  */
+static int workers_merge(worker_t* workers, int workers_num, line_map_t* lines, uint64_t limit,
+                         uint64_t* cold, uint64_t* reuse)
+{
+    int i, exact = (lines->entries != NULL);
+    for(i = 0; i < workers_num; i++)
+    {
+        exact &= workers[i].exact;
+    }
+    for(i = 0; i < workers_num && exact; i++)
+    {
+        line_map_t *map = &workers[i].map;
+        uint64_t k;
+        for(k = 0; k < map->size; k++)
+        {
+            line_entry_t *entry = &map->entries[k], *seen;
+            if(entry->first == 0)
+                continue;
+            seen = map_find(lines, entry->line);
+            if(seen != NULL && entry->first > workers[i].begin)
+            {
+                (*cold)--;
+                reuse[63 - __builtin_clzll(entry->first - seen->last)]++;
+            }
+            if(seen == NULL)
+            {
+                seen = map_insert(lines, entry->line);
+                if(seen == NULL || lines->used > limit)
+                {
+                    exact = 0;
+                    break;
+                }
+                seen->first = entry->first;
+            }
+            if(entry->last > seen->last)
+                seen->last = entry->last;
+        }
+    }
+    if(!exact)
+    {
+        map_free(lines);
+    }
+    return exact;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Print a size in bytes with a unit.
+  */
+static void print_size(double bytes)
+{
+    if(bytes >= M)
+        printf("%.1f MB", bytes / M);
+    else if(bytes >= K)
+        printf("%.1f KB", bytes / K);
+    else
+        printf("%.0f B", bytes);
+}
+
+static double percent(uint64_t part, uint64_t total)
+{
+    return total ? 100.0 * part / total : 0.0;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Stream and analyze a trace, print its summary.
+  * @param      path: trace file, for the summary.
+  * @param      trace: trace reader.
+  * @param      chunks: two chunks, room for the largest window and
+  *             options->chunk records each.
+  * @param      workers: options->threads workers, zeroed.
+  * @param      options: options of the run.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int analyze_chunks(const char* path, trace_t* trace, chunk_t* chunks, worker_t* workers,
+                          const options_t* options)
+{
+    struct timespec start, end;
+    uint64_t commands[ANALYZE_COMMANDS + 1] = {0}, accesses[3] = {0};
+    uint64_t records_num = 0, reuse[ANALYZE_REUSE_BINS] = {0}, cold = 0;
+    uint64_t same_line = 0, new_lines = 0, neighbor_hits = 0, fresh;
+    uint64_t ws_sum[ANALYZE_MAX_WINDOWS] = {0}, ws_max[ANALYZE_MAX_WINDOWS] = {0};
+    uint8_t hll[2][ANALYZE_HLL_REGISTERS];
+    uint8_t hll_all[ANALYZE_HLL_REGISTERS];
+    line_map_t lines = {0};
+    int exact, workers_num = 0, current = 0, status = SUCCESS, i, j;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    exact = (map_init(&lines, 1024) == SUCCESS);
+    chunks[1].records_num = 0;
+    chunks[1].base = 0;
+    fresh = chunk_read(trace, options, &chunks[1], &chunks[0], commands, accesses);
+    while(fresh > 0 && status == SUCCESS)
+    {
+        chunk_t *chunk = &chunks[current];
+        uint64_t first = chunk->base + chunk->kept;
+        //fewer threads on a short chunk:
+        int parts = options->threads;
+        if(fresh / ANALYZE_MIN_RECORDS + 1 < (uint64_t)parts)
+        {
+            parts = fresh / ANALYZE_MIN_RECORDS + 1;
+        }
+        if(parts > workers_num)
+        {
+            workers_num = parts;
+        }
+        for(i = 0; i < parts; i++)
+        {
+            workers[i].records = chunk->records;
+            workers[i].base = chunk->base;
+            workers[i].begin = first + fresh * i / parts;
+            workers[i].end = first + fresh * (i + 1) / parts;
+        }
+        records_num += fresh;
+        workers_start(workers, parts);
+        //read the next chunk while this one is analyzed:
+        fresh = chunk_read(trace, options, chunk, &chunks[1 - current], commands, accesses);
+        if(workers_join(workers, parts) < 0)
+        {
+            printf("Error: Cannot analyze %s.\n", path);
+            status = ERROR;
+        }
+        if(exact)
+        {
+            exact = workers_merge(workers, parts, &lines, options->limit, &cold, reuse);
+        }
+        for(i = 0; i < parts; i++)
+        {
+            map_free(&workers[i].map);
+        }
+        current = 1 - current;
+    }
+    if(status != SUCCESS)
+    {
+        map_free(&lines);
+        return ERROR;
+    }
+    memset(hll, 0, sizeof(hll));
+    for(i = 0; i < workers_num; i++)
+    {
+        worker_t *w = &workers[i];
+        cold += w->cold;
+        same_line += w->same_line;
+        new_lines += w->new_lines;
+        neighbor_hits += w->neighbor_hits;
+        for(j = 0; j < ANALYZE_REUSE_BINS; j++)
+            reuse[j] += w->reuse[j];
+        for(j = 0; j < options->windows_num; j++)
+        {
+            ws_sum[j] += w->ws_sum[j];
+            if(w->ws_max[j] > ws_max[j])
+                ws_max[j] = w->ws_max[j];
+        }
+        for(j = 0; j < ANALYZE_HLL_REGISTERS; j++)
+        {
+            if(w->hll[ANALYZE_I][j] > hll[ANALYZE_I][j])
+                hll[ANALYZE_I][j] = w->hll[ANALYZE_I][j];
+            if(w->hll[ANALYZE_D][j] > hll[ANALYZE_D][j])
+                hll[ANALYZE_D][j] = w->hll[ANALYZE_D][j];
+        }
+    }
+    for(j = 0; j < ANALYZE_HLL_REGISTERS; j++)
+    {
+        hll_all[j] = (hll[ANALYZE_I][j] > hll[ANALYZE_D][j]) ? hll[ANALYZE_I][j] : hll[ANALYZE_D][j];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    uint64_t total = accesses[READ_DATA] + accesses[WRITE_DATA] + accesses[INSTRUCTION_FETCH];
+    int line_size = 1 << options->line_bits;
+    printf("%s: %llu records, %.2f s, %d threads, %d-byte lines\n", path,
+           (unsigned long long)(records_num + commands[EVICT] + commands[CLEAR_CACHE] + commands[PRINT_CONTENT]),
+           (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9, workers_num, line_size);
+    printf("> Mix         : %llu accesses: %llu reads (%.1f%%), %llu writes (%.1f%%), %llu fetches (%.1f%%)\n",
+           (unsigned long long)total,
+           (unsigned long long)accesses[READ_DATA], percent(accesses[READ_DATA], total),
+           (unsigned long long)accesses[WRITE_DATA], percent(accesses[WRITE_DATA], total),
+           (unsigned long long)accesses[INSTRUCTION_FETCH], percent(accesses[INSTRUCTION_FETCH], total));
+    printf(">               %llu evicts, %llu clears, %llu prints, %llu other\n",
+           (unsigned long long)commands[EVICT], (unsigned long long)commands[CLEAR_CACHE],
+           (unsigned long long)commands[PRINT_CONTENT],
+           (unsigned long long)(commands[4] + commands[5] + commands[6] + commands[7] + commands[ANALYZE_COMMANDS]));
+    if(exact)
+    {
+        printf("> Footprint   : %llu lines (", (unsigned long long)lines.used);
+        print_size((double)lines.used * line_size);
+        printf("), HyperLogLog %.0f\n", hll_estimate(hll_all));
+    }
+    else
+    {
+        printf("> Footprint   : ~%.0f lines (", hll_estimate(hll_all));
+        print_size(hll_estimate(hll_all) * line_size);
+        printf("), HyperLogLog estimate, over --exact-limit\n");
+    }
+    printf(">   instruction: ~%.0f lines, data: ~%.0f lines\n",
+           hll_estimate(hll[ANALYZE_I]), hll_estimate(hll[ANALYZE_D]));
+    printf("> Working set : window      average        max\n");
+    for(j = 0; j < options->windows_num; j++)
+    {
+        double average = records_num ? (double)ws_sum[j] / records_num : 0;
+        printf(">               %-10llu %8.1f   %8llu lines, ", (unsigned long long)options->windows[j],
+               average, (unsigned long long)ws_max[j]);
+        print_size(average * line_size);
+        printf(" average\n");
+    }
+    printf("> Reuse time  : %llu first accesses%s (%.1f%%)\n", (unsigned long long)cold,
+           exact ? "" : ", upper bound", percent(cold, records_num));
+    for(j = 0; j < ANALYZE_REUSE_BINS; j++)
+    {
+        if(reuse[j] == 0)
+            continue;
+        printf(">   %10llu..%-10llu : %llu (%.1f%%)\n", 1ULL << j, (2ULL << j) - 1,
+               (unsigned long long)reuse[j], percent(reuse[j], records_num));
+    }
+    printf("> Same line   : %.1f%% of the accesses follow one to the same line\n",
+           percent(same_line, total));
+    printf("> Neighbours  : %.1f%% of the lines entering the %llu-record window find line +/- 1 in it\n",
+           percent(neighbor_hits, new_lines), (unsigned long long)options->windows[0]);
+    map_free(&lines);
+    return SUCCESS;
+}
+
+/**
+  * @brief      Analyze one trace and print its summary.
+  * @param      path: trace file.
+  * @param      options: options of the run.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int analyze_trace(const char* path, const options_t* options)
+{
+    uint64_t size = options->windows[options->windows_num - 1] + options->chunk;
+    chunk_t chunks[2] = {{0}};
+    worker_t *workers;
+    int i, status;
+    trace_t *trace = trace_create(path, options->trace_format, 1 << options->line_bits);
+    if(trace == NULL)
+    {
+        return ERROR;
+    }
+    chunks[0].records = (record_t*)malloc(size * sizeof(record_t));
+    chunks[1].records = (record_t*)malloc(size * sizeof(record_t));
+    workers = (worker_t*)calloc(options->threads, sizeof(worker_t));
+    if(chunks[0].records == NULL || chunks[1].records == NULL || workers == NULL)
+    {
+        printf("Error: Cannot hold %llu records and %d workers.\n", (unsigned long long)(2 * size),
+               options->threads);
+        status = ERROR;
+    }
+    else
+    {
+        for(i = 0; i < options->threads; i++)
+        {
+            workers[i].options = options;
+        }
+        status = analyze_chunks(path, trace, chunks, workers, options);
+    }
+    free(workers);
+    free(chunks[0].records);
+    free(chunks[1].records);
+    trace_destroy(trace);
+    return status;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Parse "W[,W...]", sorted from the smallest window.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int parse_windows(const char* str, options_t* options)
+{
+    int i, j;
+    char *end;
+    options->windows_num = 0;
+    while(*str != '\0')
+    {
+        unsigned long long window = strtoull(str, &end, 10);
+        if(end == str || window == 0 || options->windows_num >= ANALYZE_MAX_WINDOWS ||
+           (*end != ',' && *end != '\0'))
+        {
+            return ERROR;
+        }
+        options->windows[options->windows_num++] = window;
+        str = (*end == ',') ? end + 1 : end;
+    }
+    for(i = 1; i < options->windows_num; i++)
+    {
+        uint64_t window = options->windows[i];
+        for(j = i; j > 0 && options->windows[j - 1] > window; j--)
+            options->windows[j] = options->windows[j - 1];
+        options->windows[j] = window;
+    }
+    return options->windows_num > 0 ? SUCCESS : ERROR;
+}
+
+int main(int argc, char** argv)
+{
+    options_t options;
+    int opt, line_size = DATA_CACHE_LINE_SIZE, status = SUCCESS;
+    static struct option long_options[] = {
+        {"threads",         required_argument, 0, 'j'},
+        {"line",            required_argument, 0, 'l'},
+        {"windows",         required_argument, 0, 'w'},
+        {"exact-limit",     required_argument, 0, 'x'},
+        {"chunk",           required_argument, 0, 'c'},
+        {"trace-format",    required_argument, 0, 'T'},
+        {0, 0, 0, 0}
+    };
+    memset(&options, 0, sizeof(options));
+    options.threads = sysconf(_SC_NPROCESSORS_ONLN);
+    options.limit = ANALYZE_DEFAULT_LIMIT;
+    options.chunk = ANALYZE_DEFAULT_CHUNK;
+    options.trace_format = TRACE_AUTO;
+    parse_windows("1000,10000,100000", &options);
+    while((opt = getopt_long(argc, argv, "j:l:w:x:c:T:", long_options, NULL)) != -1)
+    {
+        if(opt == 'j')
+            options.threads = atoi(optarg);
+        else if(opt == 'l')
+            line_size = atoi(optarg);
+        else if(opt == 'x')
+            options.limit = strtoull(optarg, NULL, 10);
+        else if(opt == 'c')
+            options.chunk = strtoull(optarg, NULL, 10);
+        else if(opt == 'T' && trace_parse_format(optarg) >= 0)
+            options.trace_format = trace_parse_format(optarg);
+        else if(opt == 'w' && parse_windows(optarg, &options) == SUCCESS)
+            continue;
+        else
+        {
+            usage(argv[0]);
+            return ERROR;
+        }
+    }
+    if(optind >= argc || !IS_POWER_OF_2(line_size) || options.limit == 0 || options.chunk == 0)
+    {
+        usage(argv[0]);
+        return ERROR;
+    }
+    if(options.threads < 1)
+        options.threads = 1;
+    if(options.threads > ANALYZE_MAX_THREADS)
+        options.threads = ANALYZE_MAX_THREADS;
+    options.line_bits = LOG2(line_size);
+    for(; optind < argc; optind++)
+    {
+        if(analyze_trace(argv[optind], &options) < 0)
+        {
+            status = ERROR;
+        }
+    }
+    return status == SUCCESS ? 0 : 1;
+}
+
+void usage(char* prog)
+{
+    printf("Usage: %s [options] trace ...\n", prog);
+    printf("Options:\n");
+    printf("  -j, --threads=N                        threads (default: online CPUs, max %d).\n", ANALYZE_MAX_THREADS);
+    printf("  -l, --line=BYTES                       line size, power of 2 (default %d).\n", DATA_CACHE_LINE_SIZE);
+    printf("  -w, --windows=W[,W...]                 working set windows in records\n");
+    printf("                                         (default 1000,10000,100000, max %d).\n", ANALYZE_MAX_WINDOWS);
+    printf("  -x, --exact-limit=LINES                lines one thread keeps exactly, beyond them\n");
+    printf("                                         the footprint is estimated (default %d).\n", ANALYZE_DEFAULT_LIMIT);
+    printf("  -c, --chunk=RECORDS                    records read while the previous ones are\n");
+    printf("                                         analyzed (default %d).\n", ANALYZE_DEFAULT_CHUNK);
+    printf("  -T, --trace-format=FORMAT              native, lackey, dinero or champsim (default from\n");
+    printf("                                         the extension .din/.champsimtrace and the text).\n");
+}
+/**
+  * @}
+  */
@@ -0,0 +1,840 @@
+/**
+  ***********************************************************************
+  * @file       optimal.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Offline optimal replacement (Belady MIN) against LRU.
+  @verbatim
+  =======================================================================
+                    #### How to use this tool ####
+  =======================================================================
+    [..]
+    The L1 caches replace their LRU line. To know how far it is from the
+    best any replacement could do on a trace, this tool replays the trace
+    twice on the same geometry (-f/-o options of the simulator, with
+    trace_format for the traces of other tools):
+        (+) LRU: the reference cache_L1_read()/cache_L1_write() of cache.c.
+        (+) OPT: Belady MIN, on a miss the line used again the furthest
+                 in the future (or never) is replaced. A miss always
+                 fills the line, like the L1 caches.
+    Each core has its L1 instruction and data caches, both engines get
+    the reads, writes, fetches, L2 evicts and clears of the trace; the
+    statistic of every cache is logged by cache_log(), followed by the
+    misses of OPT relative to LRU. The L2, the coherence, the victim
+    buffer, the prefetchers and the latency model are not simulated.
+    The write policy of the configuration applies to both.
+    [..]
+    OPT needs the next use of every access:
+        (#) the trace is decoded once to a temporary file of records.
+        (#) a reverse pass, --chunk records at a time from the end,
+            keeps the last position of every line of every cache in a
+            hash map and writes the next use of each record to a second
+            temporary file. An L2 evict or a clear ends the line(s), the
+            accesses before them are never used again.
+        (#) a forward pass, --chunk records at a time, replays both
+            engines. The next use of each OPT line is kept beside it.
+    The memory is the chunks, the caches and one map entry per distinct
+    line: it does not grow with the length of the trace, the temporary
+    files do (12 + 8 bytes per record, in TMPDIR).
+    [..]
+    (#) make optimal, then ./optimal [options] trace ..., see usage().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <sys/types.h>
+#include "sim.h"
+#include "config.h"
+
+
+/** @defgroup Optimal_configuration
+  * @brief    OPT_DEFAULT_CHUNK: records of one pass step, in memory.
+  *           OPT_NEVER        : next use of a line never used again.
+  *           OPT_CACHES       : one instruction and one data cache a core.
+  * @{
+  */
+#define OPT_DEFAULT_CHUNK           (1 << 20)
+#define OPT_NEVER                   UINT64_MAX
+#define OPT_MAP_SIZE                1024
+#define OPT_CACHES                  (2 * DIR_MAX_CORES)
+#define OPT_ENGINES                 2
+#define OPT_LRU                     0
+#define OPT_OPT                     1
+/**
+  * @}
+  */
+
+/* Optimal data structures ----------------------------------------------*/
+/** @defgroup Optimal_data_structures
+  * @{
+  */
+
+/* Decoded record */
+/**
+  * @brief    One record of the trace, count is its repeat count. The
+  *           print commands are dropped.
+  */
+typedef struct opt_record_struct {
+    uint32_t address;
+    uint32_t count;
+    uint8_t command;
+    uint8_t core;
+}opt_record_t;
+
+/* Entry of the next use map */
+/**
+  * @brief    key: cache index + 1 (high 32 bits) and line, 0 if empty.
+  *           next: position of the next access, OPT_NEVER if none.
+  */
+typedef struct next_entry_struct {
+    uint64_t key;
+    uint64_t next;
+}next_entry_t;
+
+/* Hash map of the next uses, open addressing, linear probing */
+typedef struct next_map_struct {
+    next_entry_t* entries;
+    uint64_t size;
+    uint64_t used;
+}next_map_t;
+
+/* One replay of a trace */
+/**
+  * @brief    caches: LRU and OPT engine of each cache, index 2 * core for
+  *           the instruction cache, 2 * core + 1 for the data cache.
+  *           next_use: OPT only, next use of each way, set * ways + way.
+  *           records/next: temporary files of the decoded records and of
+  *           their next uses.
+  */
+typedef struct optimal_struct {
+    sim_config_t config;
+    uint64_t chunk;
+    int line_bits;
+    cache_t* caches[OPT_ENGINES][OPT_CACHES];
+    cache_stat_t stats[OPT_ENGINES][OPT_CACHES];
+    uint64_t misses[OPT_ENGINES][OPT_CACHES];
+    uint64_t* next_use[OPT_CACHES];
+    char names[OPT_ENGINES][OPT_CACHES][32];
+    FILE* records;
+    FILE* next;
+    uint64_t records_num;
+    opt_record_t* chunk_records;
+    uint64_t* chunk_next;
+}optimal_t;
+
+/**
+  * @}
+  */
+
+/* Optimal function prototypes -------------------------------------------------*/
+/** @addtogroup Optimal_data_structures
+  * @{
+  */
+void usage(char* prog);
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Next use map: create, find or add, clear, release.
+  */
+static int map_init(next_map_t* map, uint64_t size)
+{
+    map->entries = (next_entry_t*)calloc(size, sizeof(next_entry_t));
+    map->size = size;
+    map->used = 0;
+    return (map->entries != NULL) ? SUCCESS : ERROR;
+}
+
+static inline uint64_t map_slot(const next_map_t* map, uint64_t key)
+{
+    return (key * 0x9E3779B97F4A7C15ULL >> 20) & (map->size - 1);
+}
+
+static int map_grow(next_map_t* map)
+{
+    next_map_t bigger;
+    uint64_t i;
+    if(map_init(&bigger, 2 * map->size) < 0)
+    {
+        return ERROR;
+    }
+    for(i = 0; i < map->size; i++)
+    {
+        if(map->entries[i].key != 0)
+        {
+            uint64_t j = map_slot(&bigger, map->entries[i].key);
+            while(bigger.entries[j].key != 0)
+            {
+                j = (j + 1) & (bigger.size - 1);
+            }
+            bigger.entries[j] = map->entries[i];
+            bigger.used++;
+        }
+    }
+    free(map->entries);
+    *map = bigger;
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Find the entry of a key, add it with OPT_NEVER if absent.
+  *             The table doubles at half load.
+  * @retval     the entry, NULL if failed.
+  */
+static next_entry_t* map_get(next_map_t* map, uint64_t key)
+{
+    uint64_t i = map_slot(map, key);
+    while(map->entries[i].key != 0)
+    {
+        if(map->entries[i].key == key)
+        {
+            return &map->entries[i];
+        }
+        i = (i + 1) & (map->size - 1);
+    }
+    if(2 * (map->used + 1) > map->size)
+    {
+        if(map_grow(map) < 0)
+        {
+            return NULL;
+        }
+        i = map_slot(map, key);
+        while(map->entries[i].key != 0)
+        {
+            i = (i + 1) & (map->size - 1);
+        }
+    }
+    map->entries[i].key = key;
+    map->entries[i].next = OPT_NEVER;
+    map->used++;
+    return &map->entries[i];
+}
+
+static void map_clear(next_map_t* map)
+{
+    memset(map->entries, 0, map->size * sizeof(next_entry_t));
+    map->used = 0;
+}
+
+static void map_free(next_map_t* map)
+{
+    free(map->entries);
+    map->entries = NULL;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Cache index of an access record: see optimal_t.caches.
+  */
+static inline int opt_cache_index(const opt_record_t* record)
+{
+    return 2 * record->core + (record->command == INSTRUCTION_FETCH ? 0 : 1);
+}
+
+static inline uint64_t opt_key(int cache, uint32_t address, int line_bits)
+{
+    return ((uint64_t)(cache + 1) << 32) | (address >> line_bits);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Read a chunk of records and of their next uses, write the
+  *             next uses of a chunk, at record position start.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int opt_read_chunk(optimal_t* o, uint64_t start, uint64_t length, int with_next)
+{
+    if(fseeko(o->records, (off_t)(start * sizeof(opt_record_t)), SEEK_SET) != 0 ||
+       fread(o->chunk_records, sizeof(opt_record_t), length, o->records) != length)
+    {
+        printf("Error: Cannot read the decoded records.\n");
+        return ERROR;
+    }
+    if(with_next &&
+       (fseeko(o->next, (off_t)(start * sizeof(uint64_t)), SEEK_SET) != 0 ||
+        fread(o->chunk_next, sizeof(uint64_t), length, o->next) != length))
+    {
+        printf("Error: Cannot read the next uses.\n");
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+static int opt_write_next(optimal_t* o, uint64_t start, uint64_t length)
+{
+    if(fseeko(o->next, (off_t)(start * sizeof(uint64_t)), SEEK_SET) != 0 ||
+       fwrite(o->chunk_next, sizeof(uint64_t), length, o->next) != length)
+    {
+        printf("Error: Cannot write the next uses.\n");
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Decode the trace to o->records, like sim_step_batch().
+  * @param      o: the replay.
+  * @param      trace: trace reader, any format of trace.c.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int opt_decode(optimal_t* o, trace_t* trace)
+{
+    trace_record_t input;
+    uint64_t used = 0;
+    o->records_num = 0;
+    while(trace_read(trace, &input) == TRUE)
+    {
+        int command = input.command, core = input.core;
+        if(command == PRINT_CONTENT)
+        {
+            continue;
+        }
+        if(command != READ_DATA && command != WRITE_DATA && command != INSTRUCTION_FETCH &&
+           command != EVICT && command != CLEAR_CACHE)
+        {
+            printf("Error: Unknown command %d.\n", command);
+            return ERROR;
+        }
+        if(core < 0 || core >= o->config.cores_num)
+        {
+            printf("Error: Core %d out of %d cores.\n", core, o->config.cores_num);
+            return ERROR;
+        }
+        opt_record_t *record = &o->chunk_records[used++];
+        record->address = input.address;
+        record->count = input.count;
+        record->command = (uint8_t)command;
+        record->core = (uint8_t)core;
+        if(used == o->chunk)
+        {
+            if(fwrite(o->chunk_records, sizeof(opt_record_t), used, o->records) != used)
+            {
+                printf("Error: Cannot write the decoded records.\n");
+                return ERROR;
+            }
+            o->records_num += used;
+            used = 0;
+        }
+    }
+    if(used > 0 && fwrite(o->chunk_records, sizeof(opt_record_t), used, o->records) != used)
+    {
+        printf("Error: Cannot write the decoded records.\n");
+        return ERROR;
+    }
+    o->records_num += used;
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Reverse pass: the next use of every record, chunk by chunk
+  *             from the end of the trace. Evicts and clears have none.
+  * @param      o: the replay, records decoded.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int opt_next_use(optimal_t* o)
+{
+    next_map_t map;
+    uint64_t start, i;
+    int status = SUCCESS;
+    if(o->records_num == 0)
+    {
+        return SUCCESS;
+    }
+    if(map_init(&map, OPT_MAP_SIZE) < 0)
+    {
+        printf("Error: Cannot create the next use map.\n");
+        return ERROR;
+    }
+    start = ((o->records_num - 1) / o->chunk) * o->chunk;
+    while(status == SUCCESS)
+    {
+        uint64_t length = (o->records_num - start < o->chunk) ? o->records_num - start : o->chunk;
+        status = opt_read_chunk(o, start, length, 0);
+        for(i = length; status == SUCCESS && i-- > 0;)
+        {
+            opt_record_t *record = &o->chunk_records[i];
+            o->chunk_next[i] = OPT_NEVER;
+            if(record->command == CLEAR_CACHE)
+            {
+                //every line is gone, the accesses before are the last.
+                map_clear(&map);
+                continue;
+            }
+            int cache = (record->command == EVICT) ? 2 * record->core : opt_cache_index(record);
+            next_entry_t *entry = map_get(&map, opt_key(cache, record->address, o->line_bits));
+            if(entry != NULL && record->command == EVICT)
+            {
+                //the line leaves both caches of the core:
+                entry->next = OPT_NEVER;
+                entry = map_get(&map, opt_key(cache + 1, record->address, o->line_bits));
+                if(entry != NULL)
+                {
+                    entry->next = OPT_NEVER;
+                }
+            }
+            else if(entry != NULL)
+            {
+                o->chunk_next[i] = entry->next;
+                entry->next = start + i;
+            }
+            if(entry == NULL)
+            {
+                printf("Error: Cannot grow the next use map.\n");
+                status = ERROR;
+            }
+        }
+        if(status == SUCCESS)
+        {
+            status = opt_write_next(o, start, length);
+        }
+        if(start == 0)
+        {
+            break;
+        }
+        start -= o->chunk;
+    }
+    map_free(&map);
+    return status;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Write to a present OPT line, following the write policy
+  *             like cache_L1_store(), without data.
+  * @retval     status bits of the write (WRITE_L2_THROUGH).
+  */
+static int opt_store(cache_t* cache, line_t* line)
+{
+    if(cache->write_policy == WRITE_THROUGH ||
+       (cache->write_policy == WRITE_ONCE && !(line->flags & LINE_WRITTEN) &&
+        !(line->tag_array & BIT(cache->D_BIT))))
+    {
+        line->flags |= LINE_WRITTEN;
+        return BIT(WRITE_L2_THROUGH);
+    }
+    line->tag_array |= BIT(cache->D_BIT);
+    return 0;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      One access to the OPT engine: on a miss the first invalid
+  *             way, else the way used again the furthest, is replaced.
+  *             A write miss without write allocate goes through to L2.
+  *             The lines of a set are created on the first access, with
+  *             no data.
+  * @param      o: the replay.
+  * @param      cache_num: cache index.
+  * @param      address: byte address.
+  * @param      write: 1 for a write, 0 for a read or a fetch.
+  * @param      next: next use of this access.
+  * @retval     status of the access, see return_t. ERROR if failed.
+  */
+static int opt_access(optimal_t* o, int cache_num, uint32_t address, int write, uint64_t next)
+{
+    int i, index = FALSE;
+    return_t ret = 0;
+    cache_t *cache = o->caches[OPT_OPT][cache_num];
+    uint32_t set = get_set(*cache, address);
+    uint32_t tag = get_tag(*cache, address);
+    uint64_t *next_use = o->next_use[cache_num] + (uint64_t)set * cache->ways_assoc;
+    line_t *lines = (cache->sets)[set].lines;
+    if(lines == NULL)
+    {
+        lines = create_set(cache->ways_assoc);
+        if(lines == NULL)
+        {
+            printf("Error: Cannot create set of %d line\n", cache->ways_assoc);
+            return ERROR;
+        }
+        for(i = 0; i < cache->ways_assoc; i++)
+        {
+            lines[i].tag_array = 0;
+            lines[i].flags = 0;
+            lines[i].data = NULL;
+        }
+        (cache->sets)[set].lines = lines;
+    }
+    for(i = 0; i < cache->ways_assoc; i++)
+    {
+        if((lines[i].tag_array & BIT(cache->V_BIT)) &&
+           (lines[i].tag_array & cache->tag_line_mask) == tag)
+        {
+            next_use[i] = next;
+            return write ? (BIT(WRITE_HIT) | opt_store(cache, &lines[i])) : BIT(READ_HIT);
+        }
+    }
+    if(write && !cache->write_allocate)
+    {
+        return BIT(WRITE_MISS) | BIT(WRITE_L2_THROUGH);
+    }
+    ret |= write ? (BIT(WRITE_MISS) | BIT(READ_L2_OWN)) : (BIT(READ_MISS) | BIT(READ_L2));
+    for(i = 0; i < cache->ways_assoc && index == FALSE; i++)
+    {
+        if(!(lines[i].tag_array & BIT(cache->V_BIT)))
+        {
+            index = i;
+        }
+    }
+    if(index == FALSE)
+    {
+        index = 0;
+        for(i = 1; i < cache->ways_assoc; i++)
+        {
+            if(next_use[i] > next_use[index])
+            {
+                index = i;
+            }
+        }
+        if(lines[index].tag_array & BIT(cache->D_BIT))
+        {
+            ret |= BIT(WRITE_L2);
+        }
+    }
+    lines[index].tag_array = tag | BIT(cache->V_BIT);
+    lines[index].flags = 0;
+    next_use[index] = next;
+    return write ? (ret | opt_store(cache, &lines[index])) : ret;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Invalidate a line in the OPT engine, clear the OPT engine.
+  */
+static void opt_invalidate(optimal_t* o, int cache_num, uint32_t address)
+{
+    cache_t *cache = o->caches[OPT_OPT][cache_num];
+    line_t *lines = (cache->sets)[get_set(*cache, address)].lines;
+    uint32_t tag = get_tag(*cache, address);
+    int i;
+    for(i = 0; lines != NULL && i < cache->ways_assoc; i++)
+    {
+        if((lines[i].tag_array & BIT(cache->V_BIT)) &&
+           (lines[i].tag_array & cache->tag_line_mask) == tag)
+        {
+            lines[i].tag_array = 0;
+            lines[i].flags = 0;
+        }
+    }
+}
+
+static void opt_clear(optimal_t* o, int cache_num)
+{
+    cache_t *cache = o->caches[OPT_OPT][cache_num];
+    uint32_t set, sets_num = 1U << cache->sets_num_bits;
+    int i;
+    for(set = 0; set < sets_num; set++)
+    {
+        line_t *lines = (cache->sets)[set].lines;
+        for(i = 0; lines != NULL && i < cache->ways_assoc; i++)
+        {
+            lines[i].tag_array = 0;
+            lines[i].flags = 0;
+        }
+    }
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Replay one record on both engines.
+  * @param      o: the replay.
+  * @param      record: decoded record.
+  * @param      next: its next use.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int opt_replay_record(optimal_t* o, const opt_record_t* record, uint64_t next)
+{
+    int cache_num, update;
+    uint32_t n;
+    if(record->command == CLEAR_CACHE)
+    {
+        for(cache_num = 0; cache_num < 2 * o->config.cores_num; cache_num++)
+        {
+            opt_clear(o, cache_num);
+            if(cache_L1_clear(o->caches[OPT_LRU][cache_num]) < 0)
+            {
+                return ERROR;
+            }
+        }
+        return SUCCESS;
+    }
+    if(record->command == EVICT)
+    {
+        //L2 evicts are not counted, only their effect on the lines:
+        for(cache_num = 2 * record->core; cache_num <= 2 * record->core + 1; cache_num++)
+        {
+            opt_invalidate(o, cache_num, record->address);
+            if(cache_L1_probe(o->caches[OPT_LRU][cache_num], record->address) != FALSE &&
+               cache_L2_evict(o->caches[OPT_LRU][cache_num], record->address) < 0)
+            {
+                return ERROR;
+            }
+        }
+        return SUCCESS;
+    }
+    int engine, write = (record->command == WRITE_DATA);
+    cache_num = opt_cache_index(record);
+    for(n = 0; n < record->count; n++)
+    {
+        for(engine = 0; engine < OPT_ENGINES; engine++)
+        {
+            uint8_t data = DUMMY_BYTE;
+            cache_t *cache = o->caches[engine][cache_num];
+            if(engine == OPT_OPT)
+                update = opt_access(o, cache_num, record->address, write, next);
+            else if(write)
+                update = cache_L1_write(cache, record->address, data);
+            else
+                update = cache_L1_read(cache, record->address, &data);
+            if(update < 0 || cache_stat_update(&o->stats[engine][cache_num], update, record->address) < 0)
+            {
+                return ERROR;
+            }
+            if(update & (BIT(READ_MISS) | BIT(WRITE_MISS)))
+            {
+                o->misses[engine][cache_num]++;
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Forward pass: replay the records with their next uses.
+  * @param      o: the replay, next uses computed.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int opt_replay(optimal_t* o)
+{
+    uint64_t start, i;
+    for(start = 0; start < o->records_num; start += o->chunk)
+    {
+        uint64_t length = (o->records_num - start < o->chunk) ? o->records_num - start : o->chunk;
+        if(opt_read_chunk(o, start, length, 1) < 0)
+        {
+            return ERROR;
+        }
+        for(i = 0; i < length; i++)
+        {
+            if(opt_replay_record(o, &o->chunk_records[i], o->chunk_next[i]) < 0)
+            {
+                return ERROR;
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Log the statistic of both engines, and the misses of OPT
+  *             relative to LRU, for every cache accessed.
+  */
+static void opt_report(optimal_t* o, const char* path)
+{
+    int cache_num;
+    printf("Trace: %s, %llu records\n", path, (unsigned long long)o->records_num);
+    for(cache_num = 0; cache_num < 2 * o->config.cores_num; cache_num++)
+    {
+        cache_stat_t *lru = &o->stats[OPT_LRU][cache_num];
+        if(lru->read_hits + lru->read_misses + lru->write_hits + lru->write_misses == 0)
+        {
+            continue;
+        }
+        cache_log(lru);
+        cache_log(&o->stats[OPT_OPT][cache_num]);
+        uint64_t lru_misses = o->misses[OPT_LRU][cache_num];
+        uint64_t opt_misses = o->misses[OPT_OPT][cache_num];
+        printf("> %s: LRU misses %llu, OPT misses %llu", o->names[OPT_OPT][cache_num],
+               (unsigned long long)lru_misses, (unsigned long long)opt_misses);
+        if(lru_misses > 0)
+        {
+            printf(", OPT/LRU %.1f%%", opt_misses * 100.0 / lru_misses);
+        }
+        printf("\n");
+    }
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Create the caches of both engines, release everything.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int opt_create(optimal_t* o)
+{
+    int engine, cache_num;
+    for(engine = 0; engine < OPT_ENGINES; engine++)
+    {
+        for(cache_num = 0; cache_num < 2 * o->config.cores_num; cache_num++)
+        {
+            int kind = (cache_num % 2 == 0) ? INSTRUCTION_CACHE : DATA_CACHE;
+            cache_t *cache = create_cache(o->config.l1_sets[kind], o->config.l1_ways[kind],
+                                          o->config.line_size, CACHE_ALLOC_MALLOC);
+            o->caches[engine][cache_num] = cache;
+            if(cache == NULL ||
+               cache_set_write_policy(cache, o->config.write_policy, o->config.write_allocate) < 0)
+            {
+                printf("Error: Cannot create the caches.\n");
+                return ERROR;
+            }
+            snprintf(o->names[engine][cache_num], sizeof(o->names[engine][cache_num]),
+                     "%s %d %s", (kind == INSTRUCTION_CACHE) ? "Instruction" : "Data",
+                     cache_num / 2, (engine == OPT_LRU) ? "LRU" : "OPT");
+            cache_stat_init(&o->stats[engine][cache_num], o->names[engine][cache_num], stdout, 1);
+            if(engine == OPT_OPT)
+            {
+                size_t lines = ((size_t)1 << cache->sets_num_bits) * cache->ways_assoc;
+                o->next_use[cache_num] = (uint64_t*)malloc(lines * sizeof(uint64_t));
+                if(o->next_use[cache_num] == NULL)
+                {
+                    printf("Error: Cannot create the next uses of the lines.\n");
+                    return ERROR;
+                }
+            }
+        }
+    }
+    o->chunk_records = (opt_record_t*)malloc(o->chunk * sizeof(opt_record_t));
+    o->chunk_next = (uint64_t*)malloc(o->chunk * sizeof(uint64_t));
+    o->records = tmpfile();
+    o->next = tmpfile();
+    if(o->chunk_records == NULL || o->chunk_next == NULL || o->records == NULL || o->next == NULL)
+    {
+        printf("Error: Cannot create the chunks and the temporary files.\n");
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+static void opt_destroy(optimal_t* o)
+{
+    int engine, cache_num;
+    for(engine = 0; engine < OPT_ENGINES; engine++)
+    {
+        for(cache_num = 0; cache_num < OPT_CACHES; cache_num++)
+        {
+            destroy_cache(o->caches[engine][cache_num]);
+        }
+    }
+    for(cache_num = 0; cache_num < OPT_CACHES; cache_num++)
+    {
+        free(o->next_use[cache_num]);
+    }
+    free(o->chunk_records);
+    free(o->chunk_next);
+    if(o->records != NULL)
+        fclose(o->records);
+    if(o->next != NULL)
+        fclose(o->next);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Compare LRU and OPT on one trace.
+  * @param      path: trace file.
+  * @param      config: geometry of the caches, format of the trace.
+  * @param      chunk: records of one pass step.
+  * @retval     SUCCESS if success. Otherwise ERROR.
+  */
+static int opt_trace(const char* path, const sim_config_t* config, uint64_t chunk)
+{
+    optimal_t *o = (optimal_t*)calloc(1, sizeof(optimal_t));
+    trace_t *trace = trace_create(path, config->trace_format, config->line_size);
+    int status = ERROR;
+    if(o == NULL || trace == NULL)
+    {
+        printf("Error: Cannot replay %s.\n", path);
+    }
+    else
+    {
+        o->config = *config;
+        o->chunk = chunk;
+        o->line_bits = LOG2(config->line_size);
+        if(opt_create(o) == SUCCESS && opt_decode(o, trace) == SUCCESS &&
+           opt_next_use(o) == SUCCESS && opt_replay(o) == SUCCESS)
+        {
+            opt_report(o, path);
+            status = SUCCESS;
+        }
+        opt_destroy(o);
+    }
+    trace_destroy(trace);
+    free(o);
+    return status;
+}
+
+int main(int argc, char** argv)
+{
+    sim_config_t config;
+    uint64_t chunk = OPT_DEFAULT_CHUNK;
+    int opt, status = SUCCESS;
+    static struct option long_options[] = {
+        {"config",          required_argument, 0, 'f'},
+        {"option",          required_argument, 0, 'o'},
+        {"chunk",           required_argument, 0, 'c'},
+        {0, 0, 0, 0}
+    };
+    sim_config_init(&config);
+    while((opt = getopt_long(argc, argv, "f:o:c:", long_options, NULL)) != -1)
+    {
+        if(opt == 'f' && config_load(&config, optarg) < 0)
+        {
+            printf("Error: Wrong configuration file %s.\n", optarg);
+            return ERROR;
+        }
+        else if(opt == 'o' && config_set_option(&config, optarg) < 0)
+        {
+            usage(argv[0]);
+            return ERROR;
+        }
+        else if(opt == 'c')
+        {
+            chunk = strtoull(optarg, NULL, 10);
+        }
+        else if(opt != 'f' && opt != 'o')
+        {
+            usage(argv[0]);
+            return ERROR;
+        }
+    }
+    if(optind >= argc || chunk == 0)
+    {
+        usage(argv[0]);
+        return ERROR;
+    }
+    if(sim_config_check(&config) < 0)
+    {
+        printf("Error: Invalid simulator configuration.\n");
+        return ERROR;
+    }
+    for(; optind < argc; optind++)
+    {
+        if(opt_trace(argv[optind], &config, chunk) < 0)
+        {
+            status = ERROR;
+        }
+    }
+    return status == SUCCESS ? 0 : 1;
+}
+
+void usage(char* prog)
+{
+    printf("Usage: %s [options] trace ...\n", prog);
+    printf("Options:\n");
+    printf("  -f, --config=FILE                      cache geometry, like the simulator.\n");
+    printf("  -o, --option=KEY=VALUE                 one configuration key, like the simulator.\n");
+    printf("  -c, --chunk=RECORDS                    records in memory at once (default %d).\n", OPT_DEFAULT_CHUNK);
+}
+/**
+  * @}
+  */
@@ -0,0 +1,1048 @@
+/**
+  ***********************************************************************
+  * @file       verify.c
+  * @author     Nguyen Huynh Dang Khoa-Nguyen Thi Minh Hien
+  * @brief      Differential verification of the cache engines.
+  @verbatim
+  =======================================================================
+                    #### How to use this tool ####
+  =======================================================================
+    [..]
+    Every engine simulating the L1 caches must behave exactly like the
+    reference one: cache_L1_read(), cache_L1_write(), cache_L2_evict()
+    with the LRU bits of update_line_LRU(). This tool runs the reference
+    and the other engines side by side on the same accesses:
+        (+) The return bits of each access are compared, on the bits
+            both engines report (see engine_ops_t.bits).
+        (+) At each checkpoint the full state of every set is compared:
+            the valid lines from MRU to LRU, with their dirty bit.
+        (+) The first divergence is reported with the two set states,
+            and the tool stops with an error.
+    With -M, each trace is also replayed by the whole simulator in the
+    modes that change how records are applied but not their result:
+    run-length merging (rle) and read ahead (interleave). Every counter
+    of the L1 caches must be the same as the plain replay, with the
+    sector size of -s (runs of hits must stay in one sector).
+    With -b, each replay also checks the write buffer of the data cache,
+    drained at the end: every line it writes to L2 carries at least one
+    byte and at most one part of the line per byte the L1 wrote, and a
+    full event is counted only when a line is written to make room. -l
+    sets the line size, for lines over 64 bytes (several bytes per mask
+    bit).
+    [..]
+    Engines:
+        (+) reference: the cache request APIs of cache.c. With -g 1,WAYS
+                       it is the fully-associative table of fullassoc.c.
+        (+) model    : a plain array model, one list of lines per set
+                       in LRU order. It checks the packed tag array.
+        (+) huge     : the reference with its storage on huge pages.
+        (+) warm     : cache_L1_warm_read()/cache_L1_warm_write() of the
+                       sampled simulation, hit/miss bits only.
+        A new engine is one more engine_ops_t in engines[].
+    [..]
+    (#) make verify: replay the shipped traces of trace/.
+    (#) make fuzz  : random accesses, FUZZ_ACCESSES of them, and report
+                     the throughput. Use another --seed for each night.
+    (#) ./verifier -M [-s SECTOR] [-l LINE] [-b N] trace ...: the
+        simulator modes.
+    (#) ./verifier [options] [trace ...], see usage().
+
+  @endverbatim
+  ***********************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2020 Team3_16ES.
+  * All rights reserved.</center></h2>
+  */
+/* Includes ------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include "sim.h"
+
+
+/** @defgroup Verify_configuration
+  * @brief    VERIFY_BITS: return bits compared between engines, the
+  *           others (prefetch, victim buffer, MSHR...) are not configured.
+  *           The fuzzer uses FUZZ_SETS consecutive sets and FUZZ_TAGS
+  *           tags per cache, so lines are replaced and evicted often.
+  * @{
+  */
+#define VERIFY_MAX_ENGINES          8
+#define VERIFY_DEFAULT_CHECKPOINT   4096
+#define VERIFY_LINE_SIZE            512
+#define VERIFY_BITS     (BIT(READ_HIT) | BIT(READ_MISS) | BIT(WRITE_HIT) | BIT(WRITE_MISS) | \
+                         BIT(WRITE_L2) | BIT(READ_L2) | BIT(READ_L2_OWN) | BIT(EVICT_L2_OK) | \
+                         BIT(EVICT_L2_ERROR) | BIT(WRITE_L2_THROUGH))
+#define VERIFY_HIT_BITS (BIT(READ_HIT) | BIT(READ_MISS) | BIT(WRITE_HIT) | BIT(WRITE_MISS))
+#define FUZZ_SETS                   64
+#define FUZZ_TAGS                   8
+#define FUZZ_RECENT                 64
+#define VERIFY_MODE_COUNTERS        9
+#define VERIFY_MODE_BATCH           4096
+/**
+  * @}
+  */
+
+/* Verify data structures ----------------------------------------------*/
+/** @defgroup Verify_data_structures
+  * @{
+  */
+
+/* Engine */
+/**
+  * @brief    Operations of one engine on one cache.
+  *           set_state: fill the valid lines of a set from MRU to LRU
+  *                      (line address and dirty bit), return their number,
+  *                      ERROR if the state is inconsistent.
+  */
+typedef struct engine_ops_struct {
+    const char* name;
+    uint32_t bits;
+    void* (*create)(int sets_num, int ways, int line_size, write_policy_t policy, int write_allocate);
+    int (*read)(void* cache, uint32_t address);
+    int (*write)(void* cache, uint32_t address);
+    int (*evict)(void* cache, uint32_t address);
+    int (*clear)(void* cache);
+    int (*set_state)(void* cache, uint32_t set, uint32_t* lines, uint8_t* dirty);
+    void (*destroy)(void* cache);
+}engine_ops_t;
+
+/* Array model of a cache */
+/**
+  * @brief    lines/flags: ways entries per set, MRU first, count valid.
+  *           flags: MODEL_DIRTY, MODEL_WRITTEN (write-once policy).
+  */
+typedef struct model_struct {
+    int sets_num;
+    int ways;
+    int line_bits;
+    write_policy_t policy;
+    int write_allocate;
+    uint32_t* lines;
+    uint8_t* flags;
+    uint32_t* count;
+}model_t;
+
+#define MODEL_DIRTY     BIT(0)
+#define MODEL_WRITTEN   BIT(1)
+
+/* Simulator mode */
+/**
+  * @brief    Options of sim_config_t a replay must give the same
+  *           counters with, see verify_modes().
+  */
+typedef struct verify_mode_struct {
+    const char* name;
+    int rle;
+    int interleave;
+}verify_mode_t;
+
+/* Verifier */
+/**
+  * @brief    The instruction and data cache of every engine, engine 0 is
+  *           the reference.
+  */
+typedef struct verify_struct {
+    int engines_num;
+    const engine_ops_t* ops[VERIFY_MAX_ENGINES];
+    void* caches[VERIFY_MAX_ENGINES][2];
+    int sets[2];
+    int ways[2];
+    uint64_t accesses;
+    uint64_t checkpoints;
+    uint32_t checkpoint;
+    write_policy_t policy;
+    int write_allocate;
+    int modes;          //1 to check the simulator modes of each trace
+    int sector_size;    //sector size of the simulator modes, 0 for none
+    int line_size;      //line size of the simulator modes
+    int write_buffer;   //write buffer lines of the simulator modes, 0 for none
+}verify_t;
+
+/**
+  * @}
+  */
+
+/* Reference engine -----------------------------------------------------*/
+/** @addtogroup Verify_data_structures
+  * @{
+  */
+
+static void* reference_alloc_create(int sets_num, int ways, int line_size, write_policy_t policy,
+                                    int write_allocate, cache_alloc_t alloc)
+{
+    cache_t *cache = create_cache(sets_num, ways, line_size, alloc);
+    if(cache != NULL && cache_set_write_policy(cache, policy, write_allocate) < 0)
+    {
+        destroy_cache(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+static void* reference_create(int sets_num, int ways, int line_size, write_policy_t policy, int write_allocate)
+{
+    return reference_alloc_create(sets_num, ways, line_size, policy, write_allocate, CACHE_ALLOC_MALLOC);
+}
+
+/* Same engine, storage on huge pages */
+static void* huge_create(int sets_num, int ways, int line_size, write_policy_t policy, int write_allocate)
+{
+    return reference_alloc_create(sets_num, ways, line_size, policy, write_allocate, CACHE_ALLOC_HUGE);
+}
+
+static int reference_read(void* cache, uint32_t address)
+{
+    uint8_t data;
+    return cache_L1_read((cache_t*)cache, address, &data);
+}
+
+static int reference_write(void* cache, uint32_t address)
+{
+    return cache_L1_write((cache_t*)cache, address, DUMMY_BYTE);
+}
+
+static int reference_evict(void* cache, uint32_t address)
+{
+    return cache_L2_evict((cache_t*)cache, address);
+}
+
+static int reference_clear(void* cache)
+{
+    return cache_L1_clear((cache_t*)cache);
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      State of a set of a cache_t: the LRU bits of the valid
+  *             lines must be 0..n-1, each once. A fully-associative cache
+  *             is read from MRU to LRU in its list, which must hold the
+  *             valid lines only, each found by its tag.
+  */
+static int reference_set_state(void* p, uint32_t set, uint32_t* lines, uint8_t* dirty)
+{
+    cache_t *cache = (cache_t*)p;
+    line_t *set_lines = (cache->sets)[set].lines;
+    uint8_t used[cache->ways_assoc];
+    int i, n = 0;
+    if(set_lines == NULL)
+    {
+        return 0;
+    }
+    if(cache->fa != NULL)
+    {
+        int32_t entry;
+        for(entry = cache->fa->head; entry != FA_NONE; entry = cache->fa->entries[entry].next)
+        {
+            uint32_t tag_array = set_lines[entry].tag_array;
+            if(n >= cache->ways_assoc || !(tag_array & BIT(cache->V_BIT)) ||
+               fa_lookup(cache->fa, tag_array & cache->tag_line_mask) != entry)
+            {
+                return ERROR;
+            }
+            lines[n] = get_line_address(*cache, tag_array, set);
+            dirty[n] = (tag_array & BIT(cache->D_BIT)) ? 1 : 0;
+            n++;
+        }
+        return (n == cache->fa->used) ? n : ERROR;
+    }
+    memset(used, 0, sizeof(used));
+    for(i = 0; i < cache->ways_assoc; i++)
+    {
+        uint32_t tag_array = set_lines[i].tag_array;
+        if(!(tag_array & BIT(cache->V_BIT)))
+        {
+            continue;
+        }
+        uint16_t lru = get_line_LRU(*cache, tag_array);
+        if(lru >= cache->ways_assoc || used[lru])
+        {
+            return ERROR;
+        }
+        used[lru] = 1;
+        lines[lru] = get_line_address(*cache, tag_array, set);
+        dirty[lru] = (tag_array & BIT(cache->D_BIT)) ? 1 : 0;
+        n++;
+    }
+    for(i = 0; i < n; i++)
+    {
+        if(!used[i])
+        {
+            return ERROR;
+        }
+    }
+    return n;
+}
+
+static void reference_destroy(void* cache)
+{
+    destroy_cache((cache_t*)cache);
+}
+
+/* Functional warming engine, on the same cache_t */
+static int warm_read(void* cache, uint32_t address)
+{
+    return cache_L1_warm_read((cache_t*)cache, address);
+}
+
+static int warm_write(void* cache, uint32_t address)
+{
+    return cache_L1_warm_write((cache_t*)cache, address);
+}
+
+/**
+  * @}
+  */
+
+/* Model engine -----------------------------------------------------*/
+/** @addtogroup Verify_data_structures
+  * @{
+  */
+
+static void* model_create(int sets_num, int ways, int line_size, write_policy_t policy, int write_allocate)
+{
+    model_t *model = (model_t*)calloc(1, sizeof(model_t));
+    if(model == NULL)
+    {
+        return NULL;
+    }
+    model->sets_num = sets_num;
+    model->ways = ways;
+    model->line_bits = __builtin_ctz(line_size);
+    model->policy = policy;
+    model->write_allocate = write_allocate;
+    model->lines = (uint32_t*)calloc((size_t)sets_num * ways, sizeof(uint32_t));
+    model->flags = (uint8_t*)calloc((size_t)sets_num * ways, sizeof(uint8_t));
+    model->count = (uint32_t*)calloc(sets_num, sizeof(uint32_t));
+    if(model->lines == NULL || model->flags == NULL || model->count == NULL)
+    {
+        free(model->lines);
+        free(model->flags);
+        free(model->count);
+        free(model);
+        return NULL;
+    }
+    return model;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Find a line in its set, and move it to MRU if present.
+  * @retval     TRUE if present (now at position 0), otherwise FALSE.
+  */
+static int model_touch(model_t* model, uint32_t address, uint32_t** lines, uint8_t** flags, uint32_t** count)
+{
+    uint32_t line = address >> model->line_bits << model->line_bits;
+    uint32_t set = (address >> model->line_bits) & (model->sets_num - 1);
+    int i;
+    *lines = model->lines + (size_t)set * model->ways;
+    *flags = model->flags + (size_t)set * model->ways;
+    *count = model->count + set;
+    for(i = 0; i < **count; i++)
+    {
+        if((*lines)[i] == line)
+        {
+            uint8_t flag = (*flags)[i];
+            memmove(*lines + 1, *lines, i * sizeof(uint32_t));
+            memmove(*flags + 1, *flags, i * sizeof(uint8_t));
+            (*lines)[0] = line;
+            (*flags)[0] = flag;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Insert a clean line at MRU, the LRU line leaves a full set.
+  * @retval     BIT(WRITE_L2) if the line leaving is dirty, otherwise 0.
+  */
+static int model_insert(model_t* model, uint32_t address, uint32_t* lines, uint8_t* flags, uint32_t* count)
+{
+    int ret = 0;
+    if(*count == model->ways)
+    {
+        if(flags[model->ways - 1] & MODEL_DIRTY)
+        {
+            ret |= BIT(WRITE_L2);
+        }
+        (*count)--;
+    }
+    memmove(lines + 1, lines, *count * sizeof(uint32_t));
+    memmove(flags + 1, flags, *count * sizeof(uint8_t));
+    lines[0] = address >> model->line_bits << model->line_bits;
+    flags[0] = 0;
+    (*count)++;
+    return ret;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Write to the MRU line, following the write policy.
+  */
+static int model_store(model_t* model, uint8_t* flags)
+{
+    if(model->policy == WRITE_THROUGH ||
+       (model->policy == WRITE_ONCE && !(flags[0] & (MODEL_WRITTEN | MODEL_DIRTY))))
+    {
+        flags[0] |= MODEL_WRITTEN;
+        return BIT(WRITE_L2_THROUGH);
+    }
+    flags[0] |= MODEL_DIRTY;
+    return 0;
+}
+
+static int model_read(void* p, uint32_t address)
+{
+    model_t *model = (model_t*)p;
+    uint32_t *lines;
+    uint8_t *flags;
+    uint32_t *count;
+    if(model_touch(model, address, &lines, &flags, &count) == TRUE)
+    {
+        return BIT(READ_HIT);
+    }
+    return BIT(READ_MISS) | BIT(READ_L2) | model_insert(model, address, lines, flags, count);
+}
+
+static int model_write(void* p, uint32_t address)
+{
+    model_t *model = (model_t*)p;
+    uint32_t *lines;
+    uint8_t *flags;
+    uint32_t *count;
+    if(model_touch(model, address, &lines, &flags, &count) == TRUE)
+    {
+        return BIT(WRITE_HIT) | model_store(model, flags);
+    }
+    if(!model->write_allocate)
+    {
+        return BIT(WRITE_MISS) | BIT(WRITE_L2_THROUGH);
+    }
+    int ret = BIT(WRITE_MISS) | BIT(READ_L2_OWN) | model_insert(model, address, lines, flags, count);
+    return ret | model_store(model, flags);
+}
+
+static int model_evict(void* p, uint32_t address)
+{
+    model_t *model = (model_t*)p;
+    uint32_t *lines;
+    uint8_t *flags;
+    uint32_t *count;
+    if(model_touch(model, address, &lines, &flags, &count) == FALSE)
+    {
+        return BIT(EVICT_L2_ERROR);
+    }
+    (*count)--;
+    memmove(lines, lines + 1, *count * sizeof(uint32_t));
+    memmove(flags, flags + 1, *count * sizeof(uint8_t));
+    return BIT(EVICT_L2_OK);
+}
+
+static int model_clear(void* p)
+{
+    model_t *model = (model_t*)p;
+    memset(model->count, 0, model->sets_num * sizeof(uint32_t));
+    return SUCCESS;
+}
+
+static int model_set_state(void* p, uint32_t set, uint32_t* lines, uint8_t* dirty)
+{
+    model_t *model = (model_t*)p;
+    int i, n = model->count[set];
+    for(i = 0; i < n; i++)
+    {
+        lines[i] = model->lines[(size_t)set * model->ways + i];
+        dirty[i] = (model->flags[(size_t)set * model->ways + i] & MODEL_DIRTY) ? 1 : 0;
+    }
+    return n;
+}
+
+static void model_destroy(void* p)
+{
+    model_t *model = (model_t*)p;
+    if(model == NULL)
+    {
+        return;
+    }
+    free(model->lines);
+    free(model->flags);
+    free(model->count);
+    free(model);
+}
+
+static const engine_ops_t engines[] = {
+    {"reference", VERIFY_BITS, reference_create, reference_read, reference_write,
+        reference_evict, reference_clear, reference_set_state, reference_destroy},
+    {"model", VERIFY_BITS, model_create, model_read, model_write,
+        model_evict, model_clear, model_set_state, model_destroy},
+    {"huge", VERIFY_BITS, huge_create, reference_read, reference_write,
+        reference_evict, reference_clear, reference_set_state, reference_destroy},
+    {"warm", VERIFY_HIT_BITS, reference_create, warm_read, warm_write,
+        reference_evict, reference_clear, reference_set_state, reference_destroy},
+};
+
+/**
+  * @}
+  */
+
+/* Verify function prototypes -------------------------------------------------*/
+/** @addtogroup Verify_data_structures
+  * @{
+  */
+//verifier messages, stdout unless --quiet:
+static FILE* report;
+
+static const verify_mode_t modes[] = {
+    {"plain", 0, 0},
+    {"rle", 1, 0},
+    {"interleave", 0, 8},
+};
+
+static const char* counter_names[VERIFY_MODE_COUNTERS] = {
+    "read_hits", "read_misses", "write_hits", "write_misses", "l2_writebacks",
+    "l2_write_throughs", "sector_misses", "l2_read_bytes", "l2_write_bytes"
+};
+
+static const char* bit_names[] = {
+    "READ_HIT", "READ_MISS", "WRITE_HIT", "WRITE_MISS", "WRITE_L2", "READ_L2",
+    "READ_L2_OWN", "EVICT_L2_OK", "EVICT_L2_ERROR", "PREFETCH_L2", "PREFETCH_HIT",
+    "PREFETCH_UNUSED", "VICTIM_HIT", "MSHR_MERGE", "WRITE_L2_THROUGH", "UPGRADE_L2",
+    "SECTOR_MISS"
+};
+
+void usage(char* prog);
+
+/**
+  * @brief      Print the return bits of an access by name.
+  * @param      name: engine name.
+  * @param      ret: return bits.
+  * @retval     None.
+  */
+static void print_bits(const char* name, int ret)
+{
+    int i;
+    fprintf(report, "  %-10s: 0x%04x", name, ret);
+    for(i = 0; i < (int)(sizeof(bit_names) / sizeof(bit_names[0])); i++)
+    {
+        if(ret >= 0 && (ret & BIT(i)))
+        {
+            fprintf(report, " %s", bit_names[i]);
+        }
+    }
+    fprintf(report, "%s\n", ret < 0 ? " ERROR" : "");
+}
+
+/**
+  * @brief      Print the state of a set in one engine, MRU first.
+  * @param      v: pointer to the verifier.
+  * @param      e: engine index.
+  * @param      kind: INSTRUCTION_CACHE or DATA_CACHE.
+  * @param      set: set index.
+  * @retval     None.
+  */
+static void print_set(verify_t* v, int e, int kind, uint32_t set)
+{
+    uint32_t lines[v->ways[kind]];
+    uint8_t dirty[v->ways[kind]];
+    int i, n = v->ops[e]->set_state(v->caches[e][kind], set, lines, dirty);
+    fprintf(report, "  %-10s: set %u:", v->ops[e]->name, set);
+    if(n < 0)
+    {
+        fprintf(report, " inconsistent LRU bits\n");
+        return;
+    }
+    for(i = 0; i < n; i++)
+    {
+        fprintf(report, " %x%s", lines[i], dirty[i] ? "(D)" : "");
+    }
+    fprintf(report, "%s\n", n ? "" : " empty");
+}
+
+/**
+  * @brief      Compare the state of every set between the engines.
+  * @param      v: pointer to the verifier.
+  * @retval     SUCCESS if all engines agree. Otherwise ERROR.
+  */
+static int verify_checkpoint(verify_t* v)
+{
+    int kind, e, i;
+    uint32_t set;
+    v->checkpoints++;
+    for(kind = INSTRUCTION_CACHE; kind <= DATA_CACHE; kind++)
+    {
+        int ways = v->ways[kind];
+        int sets_num = v->sets[kind];
+        uint32_t ref_lines[ways], lines[ways];
+        uint8_t ref_dirty[ways], dirty[ways];
+        for(set = 0; set < (uint32_t)sets_num; set++)
+        {
+            int ref_n = v->ops[0]->set_state(v->caches[0][kind], set, ref_lines, ref_dirty);
+            for(e = 1; e < v->engines_num; e++)
+            {
+                int n = v->ops[e]->set_state(v->caches[e][kind], set, lines, dirty);
+                int same = (n == ref_n && n >= 0);
+                for(i = 0; same && i < n; i++)
+                {
+                    same = (lines[i] == ref_lines[i] && dirty[i] == ref_dirty[i]);
+                }
+                if(!same)
+                {
+                    fprintf(report, "Divergence: %s cache state after access %llu (checkpoint %llu)\n",
+                            kind == DATA_CACHE ? "Data" : "Instruction",
+                            (unsigned long long)v->accesses, (unsigned long long)v->checkpoints);
+                    print_set(v, 0, kind, set);
+                    print_set(v, e, kind, set);
+                    return ERROR;
+                }
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Send one trace command to every engine, compare the return
+  *             bits, and the full state at each checkpoint.
+  * @param      v: pointer to the verifier.
+  * @param      command: command, see command_t.
+  * @param      address: byte address.
+  * @retval     SUCCESS if all engines agree. Otherwise ERROR.
+  */
+static int verify_access(verify_t* v, int command, uint32_t address)
+{
+    int e, kind, ret[VERIFY_MAX_ENGINES];
+    if(command == PRINT_CONTENT)
+    {
+        return verify_checkpoint(v);
+    }
+    if(command == CLEAR_CACHE)
+    {
+        for(e = 0; e < v->engines_num; e++)
+        {
+            if(v->ops[e]->clear(v->caches[e][INSTRUCTION_CACHE]) < 0 ||
+               v->ops[e]->clear(v->caches[e][DATA_CACHE]) < 0)
+            {
+                fprintf(report, "Error: %s cannot clear.\n", v->ops[e]->name);
+                return ERROR;
+            }
+        }
+        return SUCCESS;
+    }
+    //caches of the default address map of the simulator, evicts to the home cache:
+    if(command == INSTRUCTION_FETCH)
+        kind = INSTRUCTION_CACHE;
+    else if(command == READ_DATA || command == WRITE_DATA)
+        kind = DATA_CACHE;
+    else if(command == EVICT)
+        kind = (address >= DATA_BASE_ADDR) ? DATA_CACHE : INSTRUCTION_CACHE;
+    else
+        return SUCCESS;
+    for(e = 0; e < v->engines_num; e++)
+    {
+        void *cache = v->caches[e][kind];
+        if(command == WRITE_DATA)
+            ret[e] = v->ops[e]->write(cache, address);
+        else if(command == EVICT)
+            ret[e] = v->ops[e]->evict(cache, address);
+        else
+            ret[e] = v->ops[e]->read(cache, address);
+    }
+    v->accesses++;
+    for(e = 1; e < v->engines_num; e++)
+    {
+        uint32_t bits = v->ops[0]->bits & v->ops[e]->bits;
+        if(ret[e] < 0 || ret[0] < 0 || ((ret[e] ^ ret[0]) & bits))
+        {
+            fprintf(report, "Divergence: access %llu, command %d address %x\n",
+                    (unsigned long long)v->accesses, command, address);
+            print_bits(v->ops[0]->name, ret[0]);
+            print_bits(v->ops[e]->name, ret[e]);
+            print_set(v, 0, kind, get_set(*(cache_t*)v->caches[0][kind], address));
+            print_set(v, e, kind, get_set(*(cache_t*)v->caches[0][kind], address));
+            return ERROR;
+        }
+    }
+    if(v->checkpoint > 0 && v->accesses % v->checkpoint == 0)
+    {
+        return verify_checkpoint(v);
+    }
+    return SUCCESS;
+}
+
+/**
+  * @brief      Replay a trace file, records "<command> <address> [core] [count]".
+  * @param      v: pointer to the verifier.
+  * @param      path: trace file.
+  * @retval     SUCCESS if all engines agree. Otherwise ERROR.
+  */
+static int verify_trace(verify_t* v, const char* path)
+{
+    char line[VERIFY_LINE_SIZE];
+    long records = 0;
+    FILE *fp = fopen(path, "r");
+    if(fp == NULL)
+    {
+        fprintf(report, "Error: Failed to open file %s.\n", path);
+        return ERROR;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL)
+    {
+        int command, core;
+        uint32_t address, count = 1;
+        if(sscanf(line, "%d %x %d %u", &command, &address, &core, &count) < 2)
+        {
+            continue;
+        }
+        records++;
+        for(; count > 0; count--)
+        {
+            if(verify_access(v, command, address) < 0)
+            {
+                fprintf(report, "  in %s, record %ld\n", path, records);
+                fclose(fp);
+                return ERROR;
+            }
+        }
+    }
+    fclose(fp);
+    if(verify_checkpoint(v) < 0)
+    {
+        fprintf(report, "  at the end of %s\n", path);
+        return ERROR;
+    }
+    fprintf(report, "%s: %ld records, engines agree.\n", path, records);
+    return SUCCESS;
+}
+
+/**
+  * @attention  RESTRICTED API
+  * @brief      Replay a trace by the simulator in one mode, and read the
+  *             counters of the L1 caches of core 0.
+  * @retval     SUCCESS, ERROR if the simulator failed.
+  */
+static int verify_mode_run(verify_t* v, const verify_mode_t* mode, const char* path,
+                           uint64_t counters[2][VERIFY_MODE_COUNTERS])
+{
+    sim_config_t config;
+    int kind, status;
+    sim_config_init(&config);
+    config.l1_sets[DATA_CACHE] = v->sets[DATA_CACHE];
+    config.l1_ways[DATA_CACHE] = v->ways[DATA_CACHE];
+    config.write_policy = v->policy;
+    config.write_allocate = v->write_allocate;
+    config.sector_size = v->sector_size;
+    config.line_size = v->line_size;
+    config.write_buffer_entries = v->write_buffer;
+    config.rle = mode->rle;
+    config.interleave = mode->interleave;
+    sim_context_t *sim = sim_create(&config, path, NULL);
+    if(sim == NULL)
+    {
+        fprintf(report, "Error: Cannot replay %s in mode %s.\n", path, mode->name);
+        return ERROR;
+    }
+    while((status = sim_step_batch(sim, VERIFY_MODE_BATCH)) > 0);
+    for(kind = 0; kind < 2; kind++)
+    {
+        cache_t *cache = (kind == DATA_CACHE) ? sim->data_caches[0] : sim->instruction_caches[0];
+        cache_stat_t *stat = (kind == DATA_CACHE) ? &sim->data_cache_stats[0] :
+                                                    &sim->instruction_cache_stats[0];
+        counters[kind][0] = stat->read_hits;
+        counters[kind][1] = stat->read_misses;
+        counters[kind][2] = stat->write_hits;
+        counters[kind][3] = stat->write_misses;
+        counters[kind][4] = stat->l2_writebacks;
+        counters[kind][5] = stat->l2_write_throughs;
+        counters[kind][6] = stat->sector_misses;
+        counters[kind][7] = cache->l2_read_bytes - stat->l2_read_bytes_base;
+        counters[kind][8] = cache->l2_write_bytes - stat->l2_write_bytes_base;
+    }
+    write_buffer_t *wb = sim->data_caches[0]->wbuf;
+    if(status >= 0 && wb != NULL)
+    {
+        //before the drain, a line goes to L2 only by a flush or when the buffer is full:
+        int full = wb->l2_writes - wb->flushes;
+        writebuf_drain(wb);
+        //a line sent to L2 carries a byte at least, a part of the line per byte written at most:
+        if(wb->full != full || wb->l2_bytes < (uint64_t)wb->l2_writes ||
+           wb->l2_bytes > (sim->data_caches[0]->l2_write_bytes << wb->mask_shift))
+        {
+            fprintf(report, "Divergence: %s, mode %s, write buffer: %d L2 writes of %llu bytes, "
+                    "%d full, %d flushes, %llu bytes written by L1\n", path, mode->name,
+                    wb->l2_writes, (unsigned long long)wb->l2_bytes, wb->full, wb->flushes,
+                    (unsigned long long)sim->data_caches[0]->l2_write_bytes);
+            status = ERROR;
+        }
+    }
+    sim_destroy(sim);
+    return (status < 0) ? ERROR : SUCCESS;
+}
+
+/**
+  * @brief      Replay a trace by the simulator in every mode of modes[],
+  *             the counters of the L1 caches must be the ones of the
+  *             plain replay (modes[0]).
+  * @param      v: pointer to the verifier.
+  * @param      path: trace file.
+  * @retval     SUCCESS if all modes agree. Otherwise ERROR.
+  */
+static int verify_modes(verify_t* v, const char* path)
+{
+    uint64_t plain[2][VERIFY_MODE_COUNTERS], other[2][VERIFY_MODE_COUNTERS];
+    int m, kind, i;
+    if(verify_mode_run(v, &modes[0], path, plain) < 0)
+    {
+        return ERROR;
+    }
+    for(m = 1; m < (int)(sizeof(modes) / sizeof(modes[0])); m++)
+    {
+        if(verify_mode_run(v, &modes[m], path, other) < 0)
+        {
+            return ERROR;
+        }
+        for(kind = 0; kind < 2; kind++)
+        {
+            for(i = 0; i < VERIFY_MODE_COUNTERS; i++)
+            {
+                if(plain[kind][i] != other[kind][i])
+                {
+                    fprintf(report, "Divergence: %s, %s cache, %s: %s %llu, %s %llu\n", path,
+                            (kind == DATA_CACHE) ? "data" : "instruction", counter_names[i],
+                            modes[0].name, (unsigned long long)plain[kind][i],
+                            modes[m].name, (unsigned long long)other[kind][i]);
+                    return ERROR;
+                }
+            }
+        }
+    }
+    fprintf(report, "%s: %d simulator modes agree.\n", path, m);
+    return SUCCESS;
+}
+
+/**
+  * @brief      Random accesses: reads, writes and fetches to FUZZ_TAGS
+  *             tags of FUZZ_SETS sets, evicts of recent lines (sometimes
+  *             of absent ones), and rare clears.
+  * @param      v: pointer to the verifier.
+  * @param      accesses_num: number of accesses.
+  * @param      seed: random seed.
+  * @retval     SUCCESS if all engines agree. Otherwise ERROR.
+  */
+static int verify_fuzz(verify_t* v, uint64_t accesses_num, unsigned int seed)
+{
+    uint32_t recent[FUZZ_RECENT] = {0};
+    uint64_t i;
+    struct timespec start, end;
+    srand(seed);
+    uint32_t base_set = rand() % (INSTRUCTION_CACHE_NUM_SETS - FUZZ_SETS);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(i = 0; i < accesses_num; i++)
+    {
+        int r = rand();
+        int command;
+        uint32_t set = base_set + (r >> 8) % FUZZ_SETS;
+        uint32_t tag = (r >> 16) % FUZZ_TAGS;
+        uint32_t offset = rand() % INSTRUCTION_CACHE_LINE_SIZE;
+        uint32_t address;
+        switch(r % 100)
+        {
+            case 0 ... 29:  command = READ_DATA; break;
+            case 30 ... 54: command = WRITE_DATA; break;
+            case 55 ... 89: command = INSTRUCTION_FETCH; break;
+            default:        command = EVICT; break;
+        }
+        if(command == EVICT)
+        {
+            //mostly lines accessed lately, they may still be present:
+            address = recent[rand() % FUZZ_RECENT];
+            if(rand() % 100 == 0)
+            {
+                address ^= 1U << 20;
+            }
+        }
+        else
+        {
+            //the instruction lines below DATA_BASE_ADDR, data lines above:
+            address = (tag << 20) | (set << 6) | offset;
+            if(command != INSTRUCTION_FETCH)
+            {
+                address += DATA_BASE_ADDR;
+            }
+            recent[i % FUZZ_RECENT] = address;
+        }
+        if(rand() % 1000000 == 0)
+        {
+            command = CLEAR_CACHE;
+        }
+        if(verify_access(v, command, address) < 0)
+        {
+            fprintf(report, "  fuzz seed %u\n", seed);
+            return ERROR;
+        }
+    }
+    if(verify_checkpoint(v) < 0)
+    {
+        fprintf(report, "  fuzz seed %u\n", seed);
+        return ERROR;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(report, "Fuzz: %llu accesses, seed %u, %d engines agree, %.2f s, %.2f M accesses/s.\n",
+            (unsigned long long)accesses_num, seed, v->engines_num, seconds,
+            seconds > 0 ? accesses_num / seconds / 1e6 : 0.0);
+    return SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+    verify_t v;
+    int opt, e, status = SUCCESS;
+    uint64_t fuzz = 0;
+    unsigned int seed = 1;
+    write_policy_t policy = WRITE_ONCE;
+    int write_allocate = 1;
+    int quiet = 0;
+    static struct option long_options[] = {
+        {"fuzz",            required_argument, 0, 'f'},
+        {"seed",            required_argument, 0, 'S'},
+        {"checkpoint",      required_argument, 0, 'k'},
+        {"write-policy",    required_argument, 0, 'W'},
+        {"no-write-allocate", no_argument,     0, 'n'},
+        {"quiet",           no_argument,       0, 'q'},
+        {"geometry",        required_argument, 0, 'g'},
+        {"modes",           no_argument,       0, 'M'},
+        {"sector",          required_argument, 0, 's'},
+        {"line",            required_argument, 0, 'l'},
+        {"write-buffer",    required_argument, 0, 'b'},
+        {0, 0, 0, 0}
+    };
+    memset(&v, 0, sizeof(v));
+    v.checkpoint = VERIFY_DEFAULT_CHECKPOINT;
+    v.sets[DATA_CACHE] = DATA_CACHE_NUM_SETS;
+    v.ways[DATA_CACHE] = DATA_CACHE_ASSOC_WAYS;
+    v.line_size = DATA_CACHE_LINE_SIZE;
+    while((opt = getopt_long(argc, argv, "f:S:k:W:nqg:Ms:l:b:", long_options, NULL)) != -1)
+    {
+        if(opt == 'f')
+            fuzz = strtoull(optarg, NULL, 10);
+        else if(opt == 'S')
+            seed = strtoul(optarg, NULL, 10);
+        else if(opt == 'k')
+            v.checkpoint = strtoul(optarg, NULL, 10);
+        else if(opt == 'W' && strcmp(optarg, "wb") == 0)
+            policy = WRITE_BACK;
+        else if(opt == 'W' && strcmp(optarg, "wt") == 0)
+            policy = WRITE_THROUGH;
+        else if(opt == 'W' && strcmp(optarg, "once") == 0)
+            policy = WRITE_ONCE;
+        else if(opt == 'n')
+            write_allocate = 0;
+        else if(opt == 'q')
+            quiet = 1;
+        else if(opt == 'M')
+            v.modes = 1;
+        else if(opt == 's')
+            v.sector_size = atoi(optarg);
+        else if(opt == 'l')
+            v.line_size = atoi(optarg);
+        else if(opt == 'b')
+            v.write_buffer = atoi(optarg);
+        else if(opt == 'g')
+        {
+            if(sscanf(optarg, "%d,%d", &v.sets[DATA_CACHE], &v.ways[DATA_CACHE]) != 2)
+            {
+                usage(argv[0]);
+                return ERROR;
+            }
+        }
+        else
+        {
+            usage(argv[0]);
+            return ERROR;
+        }
+    }
+    if(fuzz == 0 && optind >= argc)
+    {
+        usage(argv[0]);
+        return ERROR;
+    }
+    report = stdout;
+    if(quiet)
+    {
+        //keep the messages of the verifier, drop the warnings of the engines:
+        report = fdopen(dup(STDOUT_FILENO), "w");
+        if(report == NULL || freopen("/dev/null", "w", stdout) == NULL)
+        {
+            printf("Error: Cannot redirect the output.\n");
+            return ERROR;
+        }
+        setvbuf(report, NULL, _IOLBF, 0);
+    }
+    v.policy = policy;
+    v.write_allocate = write_allocate;
+    v.engines_num = sizeof(engines) / sizeof(engines[0]);
+    v.sets[INSTRUCTION_CACHE] = INSTRUCTION_CACHE_NUM_SETS;
+    v.ways[INSTRUCTION_CACHE] = INSTRUCTION_CACHE_ASSOC_WAYS;
+    for(e = 0; e < v.engines_num; e++)
+    {
+        v.ops[e] = &engines[e];
+        v.caches[e][INSTRUCTION_CACHE] = engines[e].create(INSTRUCTION_CACHE_NUM_SETS,
+                    INSTRUCTION_CACHE_ASSOC_WAYS, INSTRUCTION_CACHE_LINE_SIZE, WRITE_BACK, 1);
+        v.caches[e][DATA_CACHE] = engines[e].create(v.sets[DATA_CACHE],
+                    v.ways[DATA_CACHE], DATA_CACHE_LINE_SIZE, policy, write_allocate);
+        if(v.caches[e][INSTRUCTION_CACHE] == NULL || v.caches[e][DATA_CACHE] == NULL)
+        {
+            fprintf(report, "Error: Cannot create the caches of %s.\n", engines[e].name);
+            return ERROR;
+        }
+    }
+    for(; optind < argc && status == SUCCESS; optind++)
+    {
+        status = verify_trace(&v, argv[optind]);
+        if(status == SUCCESS && v.modes)
+        {
+            status = verify_modes(&v, argv[optind]);
+        }
+    }
+    if(status == SUCCESS && fuzz > 0)
+    {
+        status = verify_fuzz(&v, fuzz, seed);
+    }
+    for(e = 0; e < v.engines_num; e++)
+    {
+        engines[e].destroy(v.caches[e][INSTRUCTION_CACHE]);
+        engines[e].destroy(v.caches[e][DATA_CACHE]);
+    }
+    return status == SUCCESS ? 0 : 1;
+}
+
+void usage(char* prog)
+{
+    printf("Usage: %s [options] [trace ...]\n", prog);
+    printf("Options:\n");
+    printf("  -f, --fuzz=N                           N random accesses after the traces.\n");
+    printf("  -S, --seed=S                           seed of the fuzzer (default 1).\n");
+    printf("  -k, --checkpoint=N                     compare all sets every N accesses\n");
+    printf("                                         (default %d, 0 at the end only).\n", VERIFY_DEFAULT_CHECKPOINT);
+    printf("  -W, --write-policy=wb|wt|once          data cache write policy (default once).\n");
+    printf("  -n, --no-write-allocate                write misses go to L2 only.\n");
+    printf("  -q, --quiet                            drop the warnings of the engines.\n");
+    printf("  -g, --geometry=SETS,WAYS               data cache geometry (default %d,%d).\n",
+                DATA_CACHE_NUM_SETS, DATA_CACHE_ASSOC_WAYS);
+    printf("  -M, --modes                            also replay each trace by the simulator with\n");
+    printf("                                         -r and -i, the L1 counters must not change.\n");
+    printf("  -s, --sector=N                         sector size of the simulator for -M.\n");
+    printf("  -l, --line=N                           line size of the simulator for -M (default %d).\n",
+                DATA_CACHE_LINE_SIZE);
+    printf("  -b, --write-buffer=N                   write buffer of N lines for -M, its L2 bytes\n");
+    printf("                                         are checked.\n");
+}
+/**
+  * @}
+  */